@@ -0,0 +1,177 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#include "admin_server.hpp"
+
+#include "polyfill/explain.hpp"
+
+#include <algorithm>
+#include <boost/algorithm/string.hpp>
+#include <cerrno>
+#include <sstream>
+#include <spdlog/spdlog.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace application
+{
+    admin_server::admin_server(executor_type exec, std::string path)
+    : path_(std::move(path))
+    , acceptor_(exec)
+    , backoff_(exec)
+    {
+        // replace a socket left by a previous process, but nothing else which happens to be at the path
+        struct stat st;
+        if (::lstat(path_.c_str(), &st) == 0)
+        {
+            if (not S_ISSOCK(st.st_mode))
+                throw system_error(error_code(EEXIST, boost::system::system_category()), path_ + " is not a socket");
+            ::unlink(path_.c_str());
+        }
+        acceptor_.open(protocol_type());
+
+        // The socket file is created with the mode allowed by the umask, so restrict the umask while binding rather
+        // than narrow the mode afterwards, when others may already have connected
+        auto ec       = error_code();
+        auto previous = ::umask(S_IXUSR | S_IRWXG | S_IRWXO);
+        acceptor_.bind(protocol_type::endpoint(path_), ec);
+        ::umask(previous);
+        if (ec.failed())
+            throw system_error(ec, "bind " + path_);
+        acceptor_.listen();
+    }
+
+    admin_server::~admin_server() { ::unlink(path_.c_str()); }
+
+    auto admin_server::add_command(std::string name, handler_type handler) -> void
+    {
+        commands_.emplace_back(std::move(name), std::move(handler));
+    }
+
+    auto admin_server::start() -> void
+    {
+        net::co_spawn(
+            get_executor(), [this] { return accept_loop(); }, net::detached);
+    }
+
+    auto admin_server::stop() -> void
+    {
+        dispatch(bind_executor(get_executor(), [this] {
+            auto ec = error_code();
+            acceptor_.close(ec);
+            backoff_.cancel();
+            for (auto *sock : clients_)
+                sock->close(ec);
+        }));
+    }
+
+    auto admin_server::accept_loop() -> net::awaitable< void >
+    {
+        auto ec = error_code();
+        while (acceptor_.is_open())
+        {
+            auto sock = socket_type(get_executor());
+            co_await acceptor_.async_accept(sock, net::redirect_error(net::use_awaitable, ec));
+            if (ec == net::error::operation_aborted or ec == net::error::bad_descriptor)
+                co_return;
+            if (ec.failed())
+            {
+                // an error such as EMFILE persists until a descriptor is closed, so wait rather than spin on it
+                spdlog::warn("admin_server: accept on {} failed: {}", path_, ec.message());
+                backoff_.expires_after(accept_backoff);
+                co_await backoff_.async_wait(net::redirect_error(net::use_awaitable, ec));
+                continue;
+            }
+            net::co_spawn(
+                get_executor(),
+                [this, sock = std::move(sock)]() mutable { return serve(std::move(sock)); },
+                net::detached);
+        }
+    }
+
+    auto admin_server::serve(socket_type sock) -> net::awaitable< void >
+    {
+        clients_.insert(&sock);
+        auto input    = std::string();
+        auto response = std::string();
+        auto ec       = error_code();
+        while (not ec.failed())
+        {
+            auto n = co_await net::async_read_until(
+                sock, net::dynamic_buffer(input, max_line), '\n', net::redirect_error(net::use_awaitable, ec));
+            if (ec == net::error::not_found)
+            {
+                response = "error: line too long\n\n";
+                co_await net::async_write(sock, net::buffer(response), net::redirect_error(net::use_awaitable, ec));
+                break;
+            }
+            if (ec.failed())
+                break;
+
+            auto line = std::string_view(input).substr(0, n - 1);
+            if (not line.empty() and line.back() == '\r')
+                line.remove_suffix(1);
+            response = execute(line);
+            input.erase(0, n);
+
+            co_await net::async_write(sock, net::buffer(response), net::redirect_error(net::use_awaitable, ec));
+        }
+        clients_.erase(&sock);
+    }
+
+    auto admin_server::execute(std::string_view line) -> std::string
+    {
+        auto text = std::string(line);
+        boost::trim(text);
+
+        auto matches = [&text](std::string const &name) {
+            return boost::istarts_with(text, name) and (text.size() == name.size() or text[name.size()] == ' ');
+        };
+
+        auto out = std::ostringstream();
+        auto command =
+            std::find_if(commands_.begin(), commands_.end(), [&](auto const &entry) { return matches(entry.first); });
+        if (command != commands_.end())
+        {
+            auto args = std::string_view(text).substr(command->first.size());
+            while (not args.empty() and args.front() == ' ')
+                args.remove_prefix(1);
+            try
+            {
+                command->second(args, out);
+            }
+            catch (...)
+            {
+                out << "error: " << polyfill::explain() << '\n';
+            }
+        }
+        else if (matches("help"))
+        {
+            out << "commands:\n";
+            for (auto &entry : commands_)
+                out << '\t' << entry.first << '\n';
+        }
+        else if (not text.empty())
+            out << "error: not recognised: " << text << '\n';
+
+        // one line per line written, without the empty ones, and an empty line to end the response
+        auto body     = out.str();
+        auto response = std::string();
+        response.reserve(body.size() + 2);
+        auto first = std::size_t(0);
+        while (first < body.size())
+        {
+            auto last = std::min(body.find('\n', first), body.size());
+            if (last != first)
+                response.append(body, first, last - first).append(1, '\n');
+            first = last + 1;
+        }
+        response.append(1, '\n');
+        return response;
+    }
+
+}   // namespace application
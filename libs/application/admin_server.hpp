@@ -0,0 +1,91 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#pragma once
+
+#include "application/net.hpp"
+
+#include <chrono>
+#include <functional>
+#include <iosfwd>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace application
+{
+    /// Serves line based commands on a Unix domain socket, for operators and scripts, for example
+    /// `echo stats | socat - UNIX-CONNECT:relay.sock`.
+    ///
+    /// Each line received is a command name followed by its arguments. The response is the text written by the
+    /// command's handler followed by an empty line, so a client may send several commands on one connection. Empty
+    /// lines written by a handler are dropped, so that the end of a response is unambiguous.
+    ///
+    /// Handlers run on the server's executor, which is expected to be the one the rest of the process runs on,
+    /// so they may inspect its state without locking. A handler only produces text; the text is sent by an
+    /// asynchronous write, so a client which is slow to read delays only its own next command.
+    struct admin_server
+    {
+        using executor_type = net::io_context::executor_type;
+        using protocol_type = net::local::stream_protocol;
+        using socket_type   = net::basic_stream_socket< protocol_type, executor_type >;
+        using acceptor_type = net::basic_socket_acceptor< protocol_type, executor_type >;
+        using timer_type    = net::basic_waitable_timer< std::chrono::steady_clock,
+                                                      net::wait_traits< std::chrono::steady_clock >,
+                                                      executor_type >;
+
+        /// Writes the response to the command, given the rest of the line after the name with surrounding spaces
+        /// removed
+        using handler_type = std::function< void(std::string_view args, std::ostream &out) >;
+
+        /// Longest command line accepted. A client which sends a longer one is disconnected.
+        static constexpr std::size_t max_line = 4096;
+
+        /// How long to wait before accepting again after an error, such as running out of file descriptors
+        static constexpr std::chrono::milliseconds accept_backoff { 100 };
+
+        /// Listen on `path`, replacing any socket file left there by a previous process. The socket is accessible
+        /// only to the user running the process.
+        /// \throw system_error, including if something other than a socket is at `path`
+        admin_server(executor_type exec, std::string path);
+
+        admin_server(admin_server const &) = delete;
+        admin_server &operator=(admin_server const &) = delete;
+
+        /// Removes the socket file
+        ~admin_server();
+
+        /// Run `handler` for lines whose first words are `name`. Names are not case sensitive, and are matched in
+        /// the order they were added, so add "profile reset" before "profile". "help" lists the commands.
+        auto add_command(std::string name, handler_type handler) -> void;
+
+        auto start() -> void;
+
+        /// Stop accepting and close the connections of any clients
+        auto stop() -> void;
+
+        auto path() const -> std::string const & { return path_; }
+
+        auto get_executor() -> executor_type { return acceptor_.get_executor(); }
+
+      private:
+        auto accept_loop() -> net::awaitable< void >;
+        auto serve(socket_type sock) -> net::awaitable< void >;
+
+        /// Run the command on `line` and return the response, including the empty line which ends it
+        auto execute(std::string_view line) -> std::string;
+
+        std::string                                          path_;
+        acceptor_type                                        acceptor_;
+        timer_type                                           backoff_;
+        std::vector< std::pair< std::string, handler_type > > commands_;
+        std::set< socket_type * >                            clients_;
+    };
+
+}   // namespace application
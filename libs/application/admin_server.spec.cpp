@@ -0,0 +1,93 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#include "application/admin_server.hpp"
+
+#include <catch2/catch.hpp>
+#include <cstdio>
+#include <fstream>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <vector>
+
+TEST_CASE("application::admin_server")
+{
+    using namespace application;
+
+    auto ioc    = net::io_context();
+    auto path   = std::string("admin_server.spec.sock");
+    auto server = std::optional< admin_server >(std::in_place, ioc.get_executor(), path);
+    server->add_command("say again", [](std::string_view args, std::ostream &out) { out << "again " << args; });
+    server->add_command("say", [](std::string_view args, std::ostream &out) { out << args << "\n\n" << args; });
+    server->add_command("fail", [](std::string_view, std::ostream &) { throw std::runtime_error("failed"); });
+    server->start();
+
+    struct stat st {};
+    REQUIRE(::stat(path.c_str(), &st) == 0);
+    CHECK((st.st_mode & 0777) == 0600);
+
+    auto responses = std::vector< std::string >();
+    net::co_spawn(
+        ioc,
+        [&]() -> net::awaitable< void > {
+            auto sock = admin_server::socket_type(ioc.get_executor());
+            co_await sock.async_connect(admin_server::protocol_type::endpoint(path), net::use_awaitable);
+
+            // several commands on one connection, each response ending with an empty line
+            co_await net::async_write(sock,
+                                      net::buffer(std::string_view("say hello\nSAY AGAIN  world \r\n"
+                                                                   "sayonara\nfail\nhelp\n")),
+                                      net::use_awaitable);
+            auto input = std::string();
+            for (int i = 0; i < 5; ++i)
+            {
+                auto n = co_await net::async_read_until(sock, net::dynamic_buffer(input), "\n\n", net::use_awaitable);
+                responses.push_back(input.substr(0, n));
+                input.erase(0, n);
+            }
+
+            // a line longer than the limit ends the session
+            auto ec = error_code();
+            co_await net::async_write(
+                sock, net::buffer(std::string(admin_server::max_line + 1, 'x')), net::use_awaitable);
+            co_await net::async_read(sock, net::dynamic_buffer(input), net::redirect_error(net::use_awaitable, ec));
+            responses.push_back(input);
+            server->stop();
+        },
+        net::detached);
+    ioc.run();
+
+    REQUIRE(responses.size() == 6);
+    CHECK(responses[0] == "hello\nhello\n\n");
+    CHECK(responses[1] == "again world\n\n");
+    CHECK(responses[2] == "error: not recognised: sayonara\n\n");
+    CHECK(responses[3].rfind("error: ", 0) == 0);
+    CHECK(responses[3].find("failed") != std::string::npos);
+    CHECK(responses[4] == "commands:\n\tsay again\n\tsay\n\tfail\n\n");
+    CHECK(responses[5] == "error: line too long\n\n");
+
+    server.reset();
+    CHECK(::stat(path.c_str(), &st) != 0);
+}
+
+TEST_CASE("application::admin_server refuses to replace a file which is not a socket")
+{
+    using namespace application;
+
+    auto ioc  = net::io_context();
+    auto path = std::string("admin_server.spec.txt");
+    std::ofstream(path) << "keep me\n";
+
+    CHECK_THROWS_AS(admin_server(ioc.get_executor(), path), system_error);
+
+    struct stat st {};
+    REQUIRE(::stat(path.c_str(), &st) == 0);
+    CHECK(S_ISREG(st.st_mode));
+    std::remove(path.c_str());
+}
@@ -0,0 +1,100 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#include "admission_queue.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace application
+{
+    // ------ place ------
+
+    admission_queue::place::place(admission_queue &queue, std::function< void() > on_admit)
+    : queue_(queue)
+    , on_admit_(std::move(on_admit))
+    , where_(queue.waiting_.insert(queue.waiting_.end(), this))
+    , ticket_(queue.next_ticket_++)
+    {
+        queue_.admit_pending();
+    }
+
+    admission_queue::place::~place()
+    {
+        switch (state_)
+        {
+        case waiting:
+            queue_.waiting_.erase(where_);
+            break;
+        case admitted_:
+            queue_.release(*this, false);
+            break;
+        case done:
+            break;
+        }
+    }
+
+    auto admission_queue::place::position() const -> std::size_t
+    {
+        if (admitted())
+            return 0;
+        return std::size_t(ticket_ - queue_.waiting_.front()->ticket_) + 1;
+    }
+
+    auto admission_queue::place::complete() -> void
+    {
+        assert(state_ == admitted_);
+        queue_.release(*this, true);
+    }
+
+    // ------ admission_queue ------
+
+    admission_queue::admission_queue(admission_config config)
+    : config_(config)
+    , limit_(double(config.max_concurrent))
+    , last_reduction_(clock_type::now())
+    {
+        assert(config_.min_concurrent >= 1);
+        assert(config_.min_concurrent <= config_.max_concurrent);
+    }
+
+    auto admission_queue::release(place &p, bool ok) -> void
+    {
+        assert(in_flight_ > 0);
+        --in_flight_;
+        p.state_ = place::done;
+
+        auto now  = clock_type::now();
+        auto slow = now - p.admitted_at_ > config_.target_latency;
+        if (ok and not slow)
+        {
+            limit_ = (std::min)(limit_ + 1.0 / limit_, double(config_.max_concurrent));
+        }
+        else if (p.admitted_at_ >= last_reduction_)
+        {
+            limit_          = (std::max)(limit_ * 0.75, double(config_.min_concurrent));
+            last_reduction_ = now;
+        }
+
+        admit_pending();
+    }
+
+    auto admission_queue::admit_pending() -> void
+    {
+        while (not waiting_.empty() and in_flight_ < limit())
+        {
+            auto &p = *waiting_.front();
+            waiting_.pop_front();
+            ++in_flight_;
+            p.state_       = place::admitted_;
+            p.admitted_at_ = clock_type::now();
+            if (p.on_admit_)
+                p.on_admit_();
+        }
+    }
+
+}   // namespace application
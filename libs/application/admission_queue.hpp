@@ -0,0 +1,97 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+
+namespace application
+{
+    struct admission_config
+    {
+        /// The most operations ever admitted at once. The limit adapts between min_concurrent and this value.
+        std::size_t max_concurrent = 16;
+        std::size_t min_concurrent = 1;
+
+        /// Operations completing slower than this cause the limit to be reduced
+        std::chrono::milliseconds target_latency = std::chrono::milliseconds(1000);
+    };
+
+    /// A first come, first served queue which limits how many operations are in flight at once.
+    ///
+    /// The limit adapts to the latency of the operations it admits: each completion within the target latency
+    /// raises the limit by 1/limit (so roughly by one per limit's worth of completions), a slow or failed
+    /// operation reduces it by a quarter. Only operations admitted after the last reduction can cause another,
+    /// so a burst of slow completions from the same window reduces the limit once.
+    ///
+    /// Not thread safe. All members, and the destructors of places, must be called from the same executor.
+    struct admission_queue
+    {
+        using clock_type = std::chrono::steady_clock;
+
+        /// A place in the queue, owned by the waiting party.
+        /// Destroying a waiting place leaves the queue. Destroying an admitted place which has not been completed
+        /// releases its slot and counts as a failure.
+        struct place
+        {
+            place(admission_queue &queue, std::function< void() > on_admit);
+            place(place const &) = delete;
+            place &operator=(place const &) = delete;
+            ~place();
+
+            auto admitted() const -> bool { return state_ != waiting; }
+
+            /// Number of places ahead of this one plus one, or 0 once admitted. A place which leaves the queue
+            /// from behind the first is still counted until the places ahead of it have gone.
+            /// Complexity: constant
+            auto position() const -> std::size_t;
+
+            /// Report successful completion of the admitted operation and release the slot
+            auto complete() -> void;
+
+          private:
+            friend admission_queue;
+
+            enum state_type
+            {
+                waiting,
+                admitted_,
+                done
+            };
+
+            admission_queue &                queue_;
+            std::function< void() >          on_admit_;
+            std::list< place * >::iterator   where_;
+            std::uint64_t                    ticket_;   //! order of arrival in the queue
+            clock_type::time_point           admitted_at_;
+            state_type                       state_ = waiting;
+        };
+
+        explicit admission_queue(admission_config config = {});
+
+        auto waiting() const -> std::size_t { return waiting_.size(); }
+        auto in_flight() const -> std::size_t { return in_flight_; }
+        auto limit() const -> std::size_t { return std::size_t(limit_); }
+        auto config() const -> admission_config const & { return config_; }
+
+      private:
+        auto release(place &p, bool ok) -> void;
+        auto admit_pending() -> void;
+
+        admission_config       config_;
+        double                 limit_;
+        std::size_t            in_flight_   = 0;
+        std::uint64_t          next_ticket_ = 0;
+        std::list< place * >   waiting_;
+        clock_type::time_point last_reduction_;
+    };
+
+}   // namespace application
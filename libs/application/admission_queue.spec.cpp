@@ -0,0 +1,68 @@
+#include "application/admission_queue.hpp"
+
+#include <catch2/catch.hpp>
+#include <memory>
+#include <thread>
+
+TEST_CASE("application::admission_queue")
+{
+    using namespace application;
+    using namespace std::literals;
+
+    auto config           = admission_config();
+    config.max_concurrent = 2;
+    config.target_latency = 50ms;
+    auto queue            = admission_queue(config);
+
+    int  admissions = 0;
+    auto on_admit   = [&admissions] { ++admissions; };
+
+    SECTION("places beyond the limit wait in order")
+    {
+        auto a = std::make_unique< admission_queue::place >(queue, on_admit);
+        auto b = std::make_unique< admission_queue::place >(queue, on_admit);
+        auto c = std::make_unique< admission_queue::place >(queue, on_admit);
+        auto d = std::make_unique< admission_queue::place >(queue, on_admit);
+
+        CHECK(admissions == 2);
+        CHECK(a->admitted());
+        CHECK(b->admitted());
+        CHECK(not c->admitted());
+        CHECK(c->position() == 1);
+        CHECK(d->position() == 2);
+        CHECK(queue.waiting() == 2);
+
+        // leaving the queue moves later places forward
+        c.reset();
+        CHECK(d->position() == 1);
+
+        a->complete();
+        CHECK(d->admitted());
+        CHECK(admissions == 3);
+        CHECK(queue.in_flight() == 2);
+        CHECK(queue.waiting() == 0);
+    }
+
+    SECTION("slow or failed operations reduce the limit once per window")
+    {
+        auto a = std::make_unique< admission_queue::place >(queue, on_admit);
+        auto b = std::make_unique< admission_queue::place >(queue, on_admit);
+        std::this_thread::sleep_for(60ms);
+        a->complete();
+        CHECK(queue.limit() == 1);
+        b.reset();   // failed, but admitted before the reduction
+        CHECK(queue.limit() == 1);
+        CHECK(queue.in_flight() == 0);
+    }
+
+    SECTION("fast operations raise the limit back to the maximum")
+    {
+        {
+            auto a = admission_queue::place(queue, on_admit);
+        }
+        CHECK(queue.limit() == 1);
+        for (int i = 0; i < 4; ++i)
+            admission_queue::place(queue, on_admit).complete();
+        CHECK(queue.limit() == 2);
+    }
+}
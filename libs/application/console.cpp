@@ -7,6 +7,7 @@
 
 #include "console.hpp"
 
+#include <algorithm>
 #include <fmt/ostream.h>
 #include <iomanip>
 #include <iostream>
@@ -36,6 +37,25 @@ namespace application
                 on_done(); });
     }
 
+    auto console::add_command(std::string name, std::function< void() > handler) -> void
+    {
+        add_command(std::move(name), [handler = std::move(handler)](std::string_view) { handler(); });
+    }
+
+    auto console::add_command(std::string name, std::function< void(std::string_view) > handler) -> void
+    {
+        commands_.emplace_back(std::move(name), std::move(handler));
+    }
+
+    auto console::add_command(std::string name, std::function< void(std::string_view, std::ostream &) > handler)
+        -> void
+    {
+        add_command(std::move(name), [handler = std::move(handler)](std::string_view args) {
+            handler(args, std::cout);
+            std::cout << std::flush;
+        });
+    }
+
     auto console::run() -> net::awaitable< void >
     {
         std::string cmdbuffer;
@@ -54,6 +74,17 @@ namespace application
             if (boost::iequals(cmdview.substr(0, 4), "quit"))
                 co_return;
 
+            auto command = std::find_if(commands_.begin(), commands_.end(), [&cmdview](auto const &entry) {
+                return boost::iequals(cmdview.substr(0, entry.first.size()), entry.first);
+            });
+            if (command != commands_.end())
+            {
+                auto args = cmdview.substr(command->first.size());
+                boost::trim(args);
+                command->second(args);
+                continue;
+            }
+
             fmt::print(std::cout, "console: not recognised: {}\n", std::quoted(cmdbuffer));
         }
     }
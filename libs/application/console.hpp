@@ -10,15 +10,20 @@
 #include "application/net.hpp"
 
 #include <boost/algorithm/string.hpp>
+#include <functional>
+#include <iosfwd>
+#include <string>
 #include <string_view>
+#include <vector>
 
 namespace application
 {
     struct console
     {
-        using stream_type = net::posix::stream_descriptor;
+        using executor_type = net::io_context::executor_type;
+        using stream_type   = net::posix::basic_stream_descriptor< executor_type >;
 
-        console(net::executor exec, stream_type::native_handle_type fd_in)
+        console(executor_type exec, stream_type::native_handle_type fd_in)
         : input_(exec)
         {
             input_.assign(fd_in);
@@ -26,13 +31,23 @@ namespace application
 
         auto start(std::function<void()> on_done) -> void;
 
+        /// Run `handler` when a line beginning with `name` is entered. Names are not case sensitive.
+        auto add_command(std::string name, std::function< void() > handler) -> void;
+
+        /// As above, passing `handler` the rest of the line after the name, with surrounding spaces removed
+        auto add_command(std::string name, std::function< void(std::string_view) > handler) -> void;
+
+        /// As above, passing `handler` the console's output, so that a handler may be shared with the admin_server
+        auto add_command(std::string name, std::function< void(std::string_view, std::ostream &) > handler) -> void;
+
         void stop();
 
       private:
         auto run() -> net::awaitable< void >;
 
-        net::posix::stream_descriptor input_;
+        stream_type                   input_;
         net::streambuf                inbuf_;
+        std::vector< std::pair< std::string, std::function< void(std::string_view) > > > commands_;
         bool                          stopped = false;
     };
 
@@ -0,0 +1,402 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#include "ip_filter.hpp"
+
+#include <boost/algorithm/string.hpp>
+#include <charconv>
+#include <fmt/format.h>
+#include <fstream>
+
+namespace application
+{
+    namespace
+    {
+        auto common_prefix(ip_key const &a, ip_key const &b, unsigned limit) -> unsigned
+        {
+            unsigned result;
+            if (auto x = a.hi ^ b.hi)
+                result = unsigned(__builtin_clzll(x));
+            else if (auto y = a.lo ^ b.lo)
+                result = 64 + unsigned(__builtin_clzll(y));
+            else
+                result = 128;
+            return (std::min)(result, limit);
+        }
+
+        auto slot_of(ip_key const &key, std::size_t mask) -> std::size_t
+        {
+            auto h = key.hi * 0x9e3779b97f4a7c15ull ^ key.lo;
+            h ^= h >> 29;
+            h *= 0xbf58476d1ce4e5b9ull;
+            h ^= h >> 32;
+            return std::size_t(h) & mask;
+        }
+
+        auto parse_verdict(std::string_view word) -> ip_verdict
+        {
+            if (boost::iequals(word, "allow"))
+                return ip_verdict::allow;
+            if (boost::iequals(word, "deny"))
+                return ip_verdict::deny;
+            return ip_verdict::none;
+        }
+    }   // namespace
+
+    auto ip_key::from(net::ip::address const &addr) -> ip_key
+    {
+        auto result = ip_key();
+        if (addr.is_v4())
+        {
+            result.lo = 0x0000ffff00000000ull | addr.to_v4().to_uint();
+        }
+        else
+        {
+            auto bytes = addr.to_v6().to_bytes();
+            for (int i = 0; i < 8; ++i)
+                result.hi = (result.hi << 8) | bytes[i];
+            for (int i = 8; i < 16; ++i)
+                result.lo = (result.lo << 8) | bytes[i];
+        }
+        return result;
+    }
+
+    auto ip_key::masked(unsigned length) const -> ip_key
+    {
+        auto result = *this;
+        if (length == 0)
+            result.hi = 0, result.lo = 0;
+        else if (length < 64)
+            result.hi &= ~std::uint64_t(0) << (64 - length), result.lo = 0;
+        else if (length == 64)
+            result.lo = 0;
+        else if (length < 128)
+            result.lo &= ~std::uint64_t(0) << (128 - length);
+        return result;
+    }
+
+    // ------ ip_filter ------
+
+    ip_filter::ip_filter(ip_verdict default_verdict)
+    : default_verdict_(default_verdict)
+    , nodes_(1)
+    , exact_keys_(16)
+    , exact_verdicts_(16, ip_verdict::none)
+    {
+    }
+
+    auto ip_filter::add(net::ip::address const &addr, ip_verdict v) -> void
+    {
+        assert(v != ip_verdict::none);
+        v4_index_.clear();
+        insert_exact(ip_key::from(addr), v);
+    }
+
+    auto ip_filter::add(net::ip::address const &addr, unsigned prefix_length, ip_verdict v) -> void
+    {
+        assert(v != ip_verdict::none);
+        if (addr.is_v4())
+        {
+            assert(prefix_length <= 32);
+            prefix_length += 96;
+        }
+        assert(prefix_length <= 128);
+        v4_index_.clear();
+        insert_network(ip_key::from(addr), prefix_length, v);
+    }
+
+    auto ip_filter::add_rule(std::string_view line, error_code &ec) -> void
+    {
+        ec.clear();
+
+        if (auto hash = line.find('#'); hash != std::string_view::npos)
+            line = line.substr(0, hash);
+
+        auto words = std::vector< std::string >();
+        boost::split(words, line, boost::is_any_of(" \t\r"), boost::token_compress_on);
+        words.erase(std::remove(words.begin(), words.end(), std::string()), words.end());
+
+        if (words.empty())
+            return;
+
+        if (boost::iequals(words[0], "default"))
+        {
+            if (words.size() != 2 or parse_verdict(words[1]) == ip_verdict::none)
+                ec = net::error::invalid_argument;
+            else
+                default_verdict_ = parse_verdict(words[1]);
+            return;
+        }
+
+        auto verdict = ip_verdict::deny;
+        if (words.size() == 2)
+            verdict = parse_verdict(words[0]);
+        if (verdict == ip_verdict::none or words.size() > 2)
+        {
+            ec = net::error::invalid_argument;
+            return;
+        }
+
+        auto const &target = words.back();
+        auto        slash  = target.find('/');
+        auto        addr   = net::ip::make_address(target.substr(0, slash), ec);
+        if (ec.failed())
+            return;
+
+        if (slash == std::string::npos)
+        {
+            add(addr, verdict);
+            return;
+        }
+
+        auto length = 0u;
+        auto first  = target.data() + slash + 1;
+        auto last   = target.data() + target.size();
+        auto res    = std::from_chars(first, last, length);
+        if (res.ec != std::errc() or res.ptr != last or first == last or length > (addr.is_v4() ? 32u : 128u))
+        {
+            ec = net::error::invalid_argument;
+            return;
+        }
+
+        add(addr, length, verdict);
+    }
+
+    auto ip_filter::compile() -> void
+    {
+        // Lay the trie out breadth first, so that the upper levels, which every lookup visits, share cache lines
+        // rather than being scattered in the order the rules were added
+        auto order = std::vector< std::uint32_t >();
+        order.reserve(nodes_.size());
+        order.push_back(0);
+        for (std::size_t i = 0; i < order.size(); ++i)
+            for (auto child : nodes_[order[i]].child)
+                if (child)
+                    order.push_back(child);
+        auto position = std::vector< std::uint32_t >(nodes_.size());
+        for (std::size_t i = 0; i < order.size(); ++i)
+            position[order[i]] = std::uint32_t(i);
+        auto laid_out = std::vector< node >();
+        laid_out.reserve(order.size());
+        for (auto index : order)
+        {
+            auto &n = laid_out.emplace_back(nodes_[index]);
+            for (auto &child : n.child)
+                if (child)
+                    child = position[child];
+        }
+        nodes_.swap(laid_out);
+
+        v4_index_.resize(0x10000);
+        for (std::uint32_t top = 0; top < 0x10000; ++top)
+        {
+            auto key   = ip_key::from(net::ip::address_v4(top << 16));
+            auto entry = v4_index_entry { 0, nodes_[0].verdict };
+            for (;;)
+            {
+                auto const &n     = nodes_[entry.node];
+                auto        child = n.length < 112 ? n.child[key.bit(n.length)] : 0;
+                if (child == 0)
+                    break;
+                auto const &c = nodes_[child];
+                if (c.length > 112 or common_prefix(key, c.prefix, c.length) != c.length)
+                    break;
+                entry.node = child;
+                if (c.verdict != ip_verdict::none)
+                    entry.best = c.verdict;
+            }
+            v4_index_[top] = entry;
+        }
+    }
+
+    auto ip_filter::check(net::ip::address const &addr) const -> ip_verdict
+    {
+        auto key = ip_key::from(addr);
+        if (auto v = find_exact(key); v != ip_verdict::none)
+            return v;
+
+        auto v = ip_verdict::none;
+        if (addr.is_v4() and not v4_index_.empty())
+        {
+            auto const &entry = v4_index_[key.lo >> 16 & 0xffff];
+            v                 = longest_match(key, entry.node, entry.best);
+        }
+        else
+            v = longest_match(key, 0, nodes_[0].verdict);
+
+        return v != ip_verdict::none ? v : default_verdict_;
+    }
+
+    auto ip_filter::load(std::istream &is) -> std::shared_ptr< ip_filter const >
+    {
+        auto result = std::make_shared< ip_filter >();
+        auto line   = std::string();
+        auto lineno = std::size_t(0);
+        auto ec     = error_code();
+        while (std::getline(is, line))
+        {
+            ++lineno;
+            result->add_rule(line, ec);
+            if (ec.failed())
+                throw std::runtime_error(fmt::format("ip_filter: line {}: {}: {}", lineno, ec.message(), line));
+        }
+        result->compile();
+        return result;
+    }
+
+    auto ip_filter::load(std::string const &path) -> std::shared_ptr< ip_filter const >
+    {
+        auto ifs = std::ifstream(path);
+        if (not ifs)
+            throw std::runtime_error(fmt::format("ip_filter: cannot open {}", path));
+        try
+        {
+            return load(ifs);
+        }
+        catch (...)
+        {
+            std::throw_with_nested(std::runtime_error(fmt::format("ip_filter: loading {}", path)));
+        }
+    }
+
+    auto ip_filter::new_node(ip_key prefix, unsigned length, ip_verdict v) -> std::uint32_t
+    {
+        auto &n   = nodes_.emplace_back();
+        n.prefix  = prefix.masked(length);
+        n.length  = std::uint8_t(length);
+        n.verdict = v;
+        return std::uint32_t(nodes_.size() - 1);
+    }
+
+    auto ip_filter::insert_network(ip_key key, unsigned length, ip_verdict v) -> void
+    {
+        key = key.masked(length);
+
+        auto current = std::uint32_t(0);
+        for (;;)
+        {
+            if (nodes_[current].length == length)
+            {
+                if (nodes_[current].verdict == ip_verdict::none)
+                    ++network_count_;
+                nodes_[current].verdict = v;
+                return;
+            }
+
+            auto bit   = key.bit(nodes_[current].length);
+            auto child = nodes_[current].child[bit];
+            if (child == 0)
+            {
+                auto leaf                    = new_node(key, length, v);
+                nodes_[current].child[bit]   = leaf;
+                ++network_count_;
+                return;
+            }
+
+            auto child_length = unsigned(nodes_[child].length);
+            auto cpl          = common_prefix(key, nodes_[child].prefix, (std::min)(length, child_length));
+            if (cpl == child_length)
+            {
+                current = child;
+                continue;
+            }
+
+            // the new prefix diverges from (or is a parent of) the child, so split the edge
+            auto split                        = new_node(key, cpl, ip_verdict::none);
+            nodes_[split].child[nodes_[child].prefix.bit(cpl)] = child;
+            nodes_[current].child[bit]        = split;
+            if (cpl == length)
+            {
+                nodes_[split].verdict = v;
+            }
+            else
+            {
+                auto leaf                         = new_node(key, length, v);
+                nodes_[split].child[key.bit(cpl)] = leaf;
+            }
+            ++network_count_;
+            return;
+        }
+    }
+
+    auto ip_filter::longest_match(ip_key const &key, std::uint32_t start, ip_verdict best) const -> ip_verdict
+    {
+        auto const *n = &nodes_[start];
+        while (n->length < 128)
+        {
+            auto child = n->child[key.bit(n->length)];
+            if (child == 0)
+                break;
+            n = &nodes_[child];
+            if (common_prefix(key, n->prefix, n->length) != n->length)
+                break;
+            if (n->verdict != ip_verdict::none)
+                best = n->verdict;
+        }
+        return best;
+    }
+
+    auto ip_filter::insert_exact(ip_key key, ip_verdict v) -> void
+    {
+        if ((exact_size_ + 1) * 2 > exact_keys_.size())
+        {
+            auto keys     = std::exchange(exact_keys_, std::vector< ip_key >(exact_keys_.size() * 2));
+            auto verdicts = std::exchange(exact_verdicts_, std::vector< ip_verdict >(keys.size() * 2));
+            exact_size_   = 0;
+            for (std::size_t i = 0; i < keys.size(); ++i)
+                if (verdicts[i] != ip_verdict::none)
+                    insert_exact(keys[i], verdicts[i]);
+        }
+
+        auto mask = exact_keys_.size() - 1;
+        for (auto i = slot_of(key, mask);; i = (i + 1) & mask)
+        {
+            if (exact_verdicts_[i] == ip_verdict::none)
+            {
+                exact_keys_[i]     = key;
+                exact_verdicts_[i] = v;
+                ++exact_size_;
+                return;
+            }
+            if (exact_keys_[i] == key)
+            {
+                exact_verdicts_[i] = v;
+                return;
+            }
+        }
+    }
+
+    auto ip_filter::find_exact(ip_key const &key) const -> ip_verdict
+    {
+        if (exact_size_ == 0)
+            return ip_verdict::none;
+
+        auto mask = exact_keys_.size() - 1;
+        for (auto i = slot_of(key, mask);; i = (i + 1) & mask)
+        {
+            if (exact_verdicts_[i] == ip_verdict::none)
+                return ip_verdict::none;
+            if (exact_keys_[i] == key)
+                return exact_verdicts_[i];
+        }
+    }
+
+    // ------ ip_filter_handle ------
+
+    ip_filter_handle::ip_filter_handle(std::shared_ptr< ip_filter const > initial)
+    : current_(std::move(initial))
+    {
+        assert(current_);
+    }
+
+    auto ip_filter_handle::replace(std::shared_ptr< ip_filter const > next) -> void
+    {
+        assert(next);
+        std::atomic_store(&current_, std::move(next));
+    }
+
+}   // namespace application
@@ -0,0 +1,137 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#pragma once
+
+#include "application/net.hpp"
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <wise_enum/wise_enum.h>
+
+namespace application
+{
+    WISE_ENUM_CLASS((ip_verdict, std::uint8_t), (none, 0), (allow, 1), (deny, 2))
+
+    /// A 128 bit key representing either an IPv6 address or an IPv4 address mapped into ::ffff:0:0/96
+    struct ip_key
+    {
+        std::uint64_t hi = 0, lo = 0;
+
+        static auto from(net::ip::address const &addr) -> ip_key;
+
+        /// Return the bit at position i, counting from the most significant bit
+        auto bit(unsigned i) const -> unsigned
+        {
+            return i < 64 ? unsigned(hi >> (63 - i)) & 1 : unsigned(lo >> (127 - i)) & 1;
+        }
+
+        /// Return a copy of this key with all bits beyond `length` cleared
+        auto masked(unsigned length) const -> ip_key;
+
+        friend bool operator==(ip_key const &l, ip_key const &r) { return l.hi == r.hi and l.lo == r.lo; }
+    };
+
+    /// An immutable-once-shared set of allow/deny rules consulted before a connection is accepted.
+    ///
+    /// Exact addresses are held in an open-addressed flat table. CIDR rules are held in a path-compressed
+    /// binary radix trie over 128 bit keys, so that IPv4 and IPv6 rules share one structure. A lookup is one
+    /// probe sequence in the table followed by at most one node visit per distinct prefix length on the path.
+    /// Exact matches take precedence over the longest matching prefix, which takes precedence over the default.
+    /// Once all rules are added, compile() lays the trie out breadth first, so that the levels every lookup visits
+    /// share cache lines, and builds a direct index over the first 16 bits of the IPv4 space so that IPv4 lookups
+    /// skip the upper levels of the trie. Filters built by load() are already compiled.
+    struct ip_filter
+    {
+        ip_filter(ip_verdict default_verdict = ip_verdict::allow);
+
+        /// Add a verdict for exactly one address
+        auto add(net::ip::address const &addr, ip_verdict v) -> void;
+
+        /// Add a verdict for a network. An IPv4 prefix length is relative to the IPv4 address.
+        auto add(net::ip::address const &addr, unsigned prefix_length, ip_verdict v) -> void;
+
+        /// Parse one line of a rule file. Accepted forms are:
+        ///   # comment
+        ///   default allow|deny
+        ///   [allow|deny] <address>[/<prefix length>]
+        /// A rule with no verdict is a deny. Blank lines are ignored.
+        auto add_rule(std::string_view line, error_code &ec) -> void;
+
+        /// Build the IPv4 index. Adding a rule afterwards discards the index until compile() is called again.
+        auto compile() -> void;
+
+        auto check(net::ip::address const &addr) const -> ip_verdict;
+
+        auto permits(net::ip::address const &addr) const -> bool { return check(addr) != ip_verdict::deny; }
+
+        auto exact_count() const -> std::size_t { return exact_size_; }
+        auto network_count() const -> std::size_t { return network_count_; }
+
+        /// Build a filter from a stream of rules.
+        /// @throws std::runtime_error describing the first malformed line
+        static auto load(std::istream &is) -> std::shared_ptr< ip_filter const >;
+
+        /// Build a filter from a rule file.
+        /// @throws std::runtime_error if the file cannot be opened or contains a malformed line
+        static auto load(std::string const &path) -> std::shared_ptr< ip_filter const >;
+
+      private:
+        struct node
+        {
+            ip_key        prefix;
+            std::uint32_t child[2] = { 0, 0 };   // 0 is the root and therefore never a child
+            std::uint8_t  length   = 0;
+            ip_verdict    verdict  = ip_verdict::none;
+        };
+
+        auto insert_network(ip_key key, unsigned length, ip_verdict v) -> void;
+        auto insert_exact(ip_key key, ip_verdict v) -> void;
+        auto find_exact(ip_key const &key) const -> ip_verdict;
+        auto longest_match(ip_key const &key, std::uint32_t start, ip_verdict best) const -> ip_verdict;
+        auto new_node(ip_key prefix, unsigned length, ip_verdict v) -> std::uint32_t;
+
+        ip_verdict default_verdict_;
+
+        std::vector< node > nodes_;
+        std::size_t         network_count_ = 0;
+
+        // deepest node and best verdict so far on the path to each IPv4 /16
+        struct v4_index_entry
+        {
+            std::uint32_t node;
+            ip_verdict    best;
+        };
+        std::vector< v4_index_entry > v4_index_;
+
+        std::vector< ip_key >     exact_keys_;
+        std::vector< ip_verdict > exact_verdicts_;   // ip_verdict::none marks an empty slot
+        std::size_t               exact_size_ = 0;
+    };
+
+    /// Holds the current filter and allows it to be replaced from any thread while readers continue to use
+    /// the version they loaded. Readers never block a writer and a replaced filter is destroyed when its last
+    /// reader releases it.
+    struct ip_filter_handle
+    {
+        ip_filter_handle(std::shared_ptr< ip_filter const > initial = std::make_shared< ip_filter const >());
+
+        auto get() const -> std::shared_ptr< ip_filter const > { return std::atomic_load(&current_); }
+
+        auto replace(std::shared_ptr< ip_filter const > next) -> void;
+
+        auto permits(net::ip::address const &addr) const -> bool { return get()->permits(addr); }
+
+      private:
+        std::shared_ptr< ip_filter const > current_;
+    };
+
+}   // namespace application
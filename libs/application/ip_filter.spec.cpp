@@ -0,0 +1,181 @@
+#include "application/ip_filter.hpp"
+
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+TEST_CASE("application::ip_filter")
+{
+    using namespace application;
+
+    auto addr = [](const char *s) { return net::ip::make_address(s); };
+
+    SECTION("default verdict")
+    {
+        auto allow_all = ip_filter();
+        CHECK(allow_all.permits(addr("1.2.3.4")));
+        CHECK(allow_all.permits(addr("::1")));
+
+        auto deny_all = ip_filter(ip_verdict::deny);
+        CHECK(not deny_all.permits(addr("1.2.3.4")));
+    }
+
+    SECTION("longest prefix wins")
+    {
+        auto f = ip_filter();
+        f.add(addr("10.0.0.0"), 8, ip_verdict::deny);
+        f.add(addr("10.1.0.0"), 16, ip_verdict::allow);
+        f.add(addr("10.1.2.0"), 24, ip_verdict::deny);
+        f.add(addr("10.2.0.0"), 15, ip_verdict::deny);
+
+        CHECK(f.check(addr("10.0.0.1")) == ip_verdict::deny);
+        CHECK(f.check(addr("10.1.0.1")) == ip_verdict::allow);
+        CHECK(f.check(addr("10.1.2.200")) == ip_verdict::deny);
+        CHECK(f.check(addr("10.1.3.200")) == ip_verdict::allow);
+        CHECK(f.check(addr("10.3.255.255")) == ip_verdict::deny);
+        CHECK(f.check(addr("11.0.0.0")) == ip_verdict::allow);
+        CHECK(f.permits(addr("11.0.0.0")));
+        CHECK(f.network_count() == 4);
+
+        f.compile();
+        CHECK(f.check(addr("10.0.0.1")) == ip_verdict::deny);
+        CHECK(f.check(addr("10.1.2.200")) == ip_verdict::deny);
+        CHECK(f.check(addr("10.1.3.200")) == ip_verdict::allow);
+        CHECK(f.check(addr("10.3.255.255")) == ip_verdict::deny);
+        CHECK(f.check(addr("11.0.0.0")) == ip_verdict::allow);
+    }
+
+    SECTION("ipv4 rules match ipv4 mapped ipv6 addresses")
+    {
+        auto f = ip_filter();
+        f.add(addr("192.168.0.0"), 16, ip_verdict::deny);
+        CHECK(not f.permits(addr("::ffff:192.168.4.5")));
+        CHECK(f.permits(addr("::ffff:192.169.4.5")));
+    }
+
+    SECTION("ipv6 networks")
+    {
+        auto f = ip_filter();
+        f.add(addr("2001:db8::"), 32, ip_verdict::deny);
+        f.add(addr("2001:db8:1234::"), 48, ip_verdict::allow);
+        CHECK(not f.permits(addr("2001:db8::1")));
+        CHECK(f.permits(addr("2001:db8:1234::1")));
+        CHECK(f.permits(addr("2001:db9::1")));
+    }
+
+    SECTION("exact addresses take precedence")
+    {
+        auto f = ip_filter();
+        f.add(addr("10.0.0.0"), 8, ip_verdict::allow);
+        for (unsigned i = 0; i < 1000; ++i)
+            f.add(net::ip::address_v4(0x0a000000u + i * 7), ip_verdict::deny);
+        CHECK(f.exact_count() == 1000);
+        CHECK(not f.permits(addr("10.0.0.7")));
+        CHECK(f.permits(addr("10.0.0.8")));
+        CHECK(not f.permits(net::ip::address_v4(0x0a000000u + 999 * 7)));
+    }
+
+    SECTION("rule parsing")
+    {
+        auto is = std::istringstream("# ban list\n"
+                                     "default deny\n"
+                                     "allow 0.0.0.0/0\n"
+                                     "\n"
+                                     "deny 100.64.0.0/10   # carrier nat\n"
+                                     "1.2.3.4\n"
+                                     "allow ::/0\n"
+                                     "deny fe80::/10\n");
+        auto f  = ip_filter::load(is);
+        CHECK(f->permits(addr("8.8.8.8")));
+        CHECK(not f->permits(addr("100.100.1.1")));
+        CHECK(not f->permits(addr("1.2.3.4")));
+        CHECK(f->permits(addr("2001:db8::1")));
+        CHECK(not f->permits(addr("fe80::1")));
+    }
+
+    SECTION("malformed rules")
+    {
+        auto f  = ip_filter();
+        auto ec = error_code();
+        f.add_rule("deny 10.0.0.0/33", ec);
+        CHECK(ec.failed());
+        f.add_rule("block 10.0.0.0/8", ec);
+        CHECK(ec.failed());
+        f.add_rule("deny 10.0.0/8", ec);
+        CHECK(ec.failed());
+        f.add_rule("default maybe", ec);
+        CHECK(ec.failed());
+
+        auto is = std::istringstream("deny 1.2.3.4\nnonsense here please\n");
+        CHECK_THROWS_AS(ip_filter::load(is), std::runtime_error);
+    }
+
+    SECTION("handle replacement")
+    {
+        auto h = ip_filter_handle();
+        CHECK(h.permits(addr("1.2.3.4")));
+
+        auto held = h.get();
+        auto next = std::make_shared< ip_filter >();
+        next->add(addr("1.2.3.4"), ip_verdict::deny);
+        h.replace(std::move(next));
+
+        CHECK(not h.permits(addr("1.2.3.4")));
+        CHECK(held->permits(addr("1.2.3.4")));
+    }
+}
+
+TEST_CASE("application::ip_filter lookup cost at a million rules", "[.][benchmark]")
+{
+    using namespace application;
+
+    constexpr std::size_t lookups = 2'000'000;
+
+    // a ban list of exact addresses and a list of datacenter networks, mostly IPv4, written as a rule file
+    auto gen = std::mt19937_64(42);
+    auto v6  = [&gen] {
+        auto bytes = net::ip::address_v6::bytes_type();
+        for (auto &b : bytes)
+            b = std::uint8_t(gen());
+        bytes[0] = 0x20;   // 2000::/4, global unicast
+        bytes[1] &= 0x0f;
+        return net::ip::address_v6(bytes);
+    };
+    auto text = std::ostringstream();
+    for (int i = 0; i < 800'000; ++i)
+        text << "deny " << net::ip::address_v4(std::uint32_t(gen())) << '\n';
+    for (int i = 0; i < 100'000; ++i)
+        text << "deny " << v6() << '\n';
+    for (int i = 0; i < 80'000; ++i)
+        text << "deny " << net::ip::address_v4(std::uint32_t(gen())) << '/' << 16 + gen() % 13 << '\n';
+    for (int i = 0; i < 20'000; ++i)
+        text << "deny " << v6() << '/' << 29 + gen() % 36 << '\n';
+
+    auto in         = std::istringstream(text.str());
+    auto load_start = std::chrono::steady_clock::now();
+    auto filter     = ip_filter::load(in);
+    auto load_time  = std::chrono::steady_clock::now() - load_start;
+    CHECK(filter->exact_count() + filter->network_count() > 990'000);
+    std::cout << "ip_filter load of " << filter->exact_count() << " addresses and " << filter->network_count()
+              << " networks : " << std::chrono::duration_cast< std::chrono::milliseconds >(load_time).count()
+              << " ms\n";
+
+    auto measure = [&](char const *what, auto make_address) {
+        auto addresses = std::vector< net::ip::address >();
+        for (int i = 0; i < 4096; ++i)
+            addresses.push_back(make_address());
+        auto denied = std::size_t(0);
+        auto start  = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < lookups; ++i)
+            denied += not filter->permits(addresses[i % addresses.size()]);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        auto ns      = std::chrono::duration< double, std::nano >(elapsed).count() / double(lookups);
+        std::cout << what << ns << " ns (" << denied << " denied)\n";
+        return ns;
+    };
+    auto v4 = [&gen] { return net::ip::address(net::ip::address_v4(std::uint32_t(gen()))); };
+    CHECK(measure("ip_filter IPv4 lookup : ", v4) < 1000);
+    CHECK(measure("ip_filter IPv6 lookup : ", [&v6] { return net::ip::address(v6()); }) < 1000);
+}
@@ -0,0 +1,275 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#include "loop_monitor.hpp"
+
+#include "polyfill/activity.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <mutex>
+#include <optional>
+#include <pthread.h>
+#include <spdlog/spdlog.h>
+#include <sstream>
+#if __has_include(<execinfo.h>)
+#include <execinfo.h>
+#define APPLICATION_LOOP_MONITOR_STACKS 1
+#endif
+
+namespace application
+{
+    namespace
+    {
+        using clock_type = std::chrono::steady_clock;
+
+#ifdef APPLICATION_LOOP_MONITOR_STACKS
+        // Stacks are sampled by interrupting the blocked thread with a signal which is otherwise ignored, and whose
+        // handler records the thread's return addresses for the monitor to symbolise.
+        constexpr int sample_signal = SIGURG;
+        constexpr int max_frames    = 64;
+
+        void *             sampled_frames[max_frames];
+        std::atomic< int > sampled_depth { -1 };
+        std::mutex         sample_mutex;   //! one sample at a time, since there is one buffer
+
+        extern "C" void on_sample_signal(int)
+        {
+            sampled_depth.store(::backtrace(sampled_frames, max_frames), std::memory_order_release);
+        }
+
+        auto install_sample_handler() -> void
+        {
+            static auto const installed = [] {
+                // the first call of backtrace may allocate, which a signal handler must not
+                void *warm[1];
+                ::backtrace(warm, 1);
+
+                struct sigaction sa = {};
+                sa.sa_handler       = on_sample_signal;
+                sa.sa_flags         = SA_RESTART;
+                sigemptyset(&sa.sa_mask);
+                return ::sigaction(sample_signal, &sa, nullptr) == 0;
+            }();
+            (void)installed;
+        }
+
+        auto sample_stack(pthread_t thread) -> std::vector< std::string >
+        {
+            auto lock = std::lock_guard(sample_mutex);
+            sampled_depth.store(-1, std::memory_order_relaxed);
+            if (::pthread_kill(thread, sample_signal) != 0)
+                return {};
+
+            auto deadline = clock_type::now() + std::chrono::milliseconds(100);
+            auto depth    = -1;
+            while ((depth = sampled_depth.load(std::memory_order_acquire)) < 0 and clock_type::now() < deadline)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            if (depth <= 0)
+                return {};
+
+            auto result  = std::vector< std::string >();
+            auto symbols = ::backtrace_symbols(sampled_frames, depth);
+            if (not symbols)
+                return result;
+            // skip the signal handler and the signal trampoline
+            for (int i = std::min(depth, 2); i < depth; ++i)
+                result.emplace_back(symbols[i]);
+            std::free(symbols);
+            return result;
+        }
+#else
+        auto install_sample_handler() -> void {}
+
+        auto sample_stack(pthread_t) -> std::vector< std::string > { return {}; }
+#endif
+
+        auto microseconds(clock_type::duration d) -> std::chrono::microseconds
+        {
+            return std::chrono::duration_cast< std::chrono::microseconds >(d);
+        }
+    }   // namespace
+
+    struct loop_monitor::state
+    {
+        state(executor_type exec, loop_monitor_config cfg, polyfill::metrics::registry &registry)
+        : exec(exec)
+        , config(std::move(cfg))
+        , lag(registry.histogram("application_loop_lag_microseconds",
+                                 "Time a probe posted to the event loop waited to run",
+                                 { 50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 1000000 },
+                                 { { "loop", config.name } }))
+        , stall_count(registry.counter(
+              "application_loop_stalls_total", "Probes delayed beyond the stall threshold", { { "loop", config.name } }))
+        {
+        }
+
+        executor_type                exec;
+        loop_monitor_config          config;
+        polyfill::metrics::histogram lag;
+        polyfill::metrics::counter   stall_count;
+
+        mutable std::mutex      mutex;
+        std::condition_variable cv;
+        bool                    running = false;
+
+        // the probe in flight
+        bool                         ran = false;
+        clock_type::time_point       posted;
+        clock_type::time_point       ran_at;
+        std::optional< pthread_t >   loop_thread;              //! the thread which ran the last probe
+        std::atomic< char const * > *loop_activity = nullptr;   //! ... and its activity slot
+
+        // reporting
+        std::uint64_t          stalls = 0;
+        stall_report           last;
+        std::uint64_t          suppressed = 0;
+        clock_type::time_point last_warning;
+    };
+
+    loop_monitor::loop_monitor(executor_type exec, loop_monitor_config config, polyfill::metrics::registry &registry)
+    : state_(std::make_shared< state >(exec, std::move(config), registry))
+    {
+    }
+
+    loop_monitor::~loop_monitor() { stop(); }
+
+    auto loop_monitor::start() -> void
+    {
+        {
+            auto lock = std::lock_guard(state_->mutex);
+            if (state_->running)
+                return;
+            state_->running = true;
+        }
+        if (state_->config.stack_samples)
+            install_sample_handler();
+        watcher_ = std::thread([this] { watch(); });
+    }
+
+    auto loop_monitor::stop() -> void
+    {
+        {
+            auto lock       = std::lock_guard(state_->mutex);
+            state_->running = false;
+        }
+        state_->cv.notify_all();
+        if (watcher_.joinable())
+            watcher_.join();
+    }
+
+    auto loop_monitor::stalls() const -> std::uint64_t
+    {
+        auto lock = std::lock_guard(state_->mutex);
+        return state_->stalls;
+    }
+
+    auto loop_monitor::last_stall() const -> stall_report
+    {
+        auto lock = std::lock_guard(state_->mutex);
+        return state_->last;
+    }
+
+    auto loop_monitor::watch() -> void
+    {
+        auto &s    = *state_;
+        auto  lock = std::unique_lock(s.mutex);
+        while (s.running)
+        {
+            s.ran    = false;
+            s.posted = clock_type::now();
+            net::post(s.exec, [self = state_] {
+                auto lock           = std::lock_guard(self->mutex);
+                self->ran           = true;
+                self->ran_at        = clock_type::now();
+                self->loop_thread   = ::pthread_self();
+                self->loop_activity = &polyfill::activity::slot();
+                self->cv.notify_all();
+            });
+
+            // Wait for the probe to run. If it is late the loop is blocked now, which is the moment to see what
+            // it is doing.
+            auto current = stall_report();
+            auto sampled = false;
+            while (s.running and not s.ran)
+            {
+                s.cv.wait_for(lock, s.config.threshold / 2 + std::chrono::milliseconds(1));
+                if (s.ran or sampled or clock_type::now() - s.posted <= s.config.threshold)
+                    continue;
+
+                sampled = true;
+                if (s.loop_activity)
+                    if (auto name = s.loop_activity->load(std::memory_order_relaxed))
+                        current.activity = name;
+                if (s.config.stack_samples and s.loop_thread)
+                {
+                    auto thread = *s.loop_thread;
+                    lock.unlock();
+                    current.stack = sample_stack(thread);
+                    lock.lock();
+                }
+            }
+            if (not s.running)
+                break;
+
+            auto lag = s.ran_at - s.posted;
+            s.lag.observe(microseconds(lag).count());
+            if (lag > s.config.threshold)
+            {
+                current.lag = microseconds(lag);
+                if (auto message = report_stall(std::move(current)); not message.empty())
+                {
+                    // the probe takes the lock, so the loop must not wait while the message is written
+                    lock.unlock();
+                    spdlog::warn(message);
+                    lock.lock();
+                }
+            }
+
+            s.cv.wait_for(lock, s.config.interval, [&s] { return not s.running; });
+        }
+    }
+
+    auto loop_monitor::report_stall(stall_report report) -> std::string
+    {
+        auto &s = *state_;
+        ++s.stalls;
+        s.stall_count.inc();
+        s.last = std::move(report);
+
+        auto now = clock_type::now();
+        if (s.stalls > 1 and now - s.last_warning < s.config.warning_interval)
+        {
+            ++s.suppressed;
+            return {};
+        }
+        auto text = std::ostringstream();
+        text << "loop_monitor[" << s.config.name << "]: " << s.last;
+        if (s.suppressed)
+            text << "\t(" << s.suppressed << " more stalls since the last report)\n";
+        auto message = text.str();
+        if (message.back() == '\n')
+            message.pop_back();
+        s.last_warning = now;
+        s.suppressed   = 0;
+        return message;
+    }
+
+    auto operator<<(std::ostream &os, stall_report const &report) -> std::ostream &
+    {
+        os << "event loop blocked for " << report.lag.count() / 1000.0 << "ms";
+        if (not report.activity.empty())
+            os << " in " << report.activity;
+        os << '\n';
+        for (auto &frame : report.stack)
+            os << "\t" << frame << '\n';
+        return os;
+    }
+
+}   // namespace application
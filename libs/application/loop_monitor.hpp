@@ -0,0 +1,96 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#pragma once
+
+#include "application/net.hpp"
+#include "polyfill/metrics.hpp"
+
+#include <chrono>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace application
+{
+    struct loop_monitor_config
+    {
+        /// Identifies the loop in metrics and warnings
+        std::string name = "main";
+
+        /// Time between probes
+        std::chrono::milliseconds interval = std::chrono::milliseconds(100);
+
+        /// A probe which waits longer than this to run means a handler blocked the loop
+        std::chrono::milliseconds threshold = std::chrono::milliseconds(50);
+
+        /// At most one stall is reported in this time. Further stalls are counted and summarised in the next report.
+        std::chrono::seconds warning_interval = std::chrono::seconds(10);
+
+        /// Sample the stack of the blocked thread while it is stalled
+        bool stack_samples = true;
+    };
+
+    /// What a stalled event loop was doing
+    struct stall_report
+    {
+        std::chrono::microseconds  lag {};     //! how late the probe ran
+        std::string                activity;   //! the innermost polyfill::activity of the blocked thread, if any
+        std::vector< std::string > stack;      //! symbolised frames of the blocked thread, if sampled
+    };
+
+    /// Watches an io_context for handlers which block it.
+    ///
+    /// A thread of the monitor posts a probe to the io_context at regular intervals and measures how long the probe
+    /// waits to run. Every lag is recorded in the application_loop_lag_microseconds histogram. A lag beyond the
+    /// threshold is a stall: it is counted in application_loop_stalls_total and logged as a warning, at a limited
+    /// rate, with the polyfill::activity the blocked thread had marked and a sample of its stack taken while it was
+    /// blocked.
+    ///
+    /// The activity and stack are those of the thread which ran the previous probe, and so are reliable for loops
+    /// run by one thread. The monitor must be stopped before the threads running the loop exit.
+    struct loop_monitor
+    {
+        using executor_type = net::io_context::executor_type;
+
+        loop_monitor(executor_type                exec,
+                     loop_monitor_config          config,
+                     polyfill::metrics::registry &registry = polyfill::metrics::registry::global());
+
+        loop_monitor(loop_monitor const &) = delete;
+        loop_monitor &operator=(loop_monitor const &) = delete;
+
+        ~loop_monitor();
+
+        auto start() -> void;
+
+        auto stop() -> void;
+
+        /// The number of stalls so far
+        auto stalls() const -> std::uint64_t;
+
+        /// The most recent stall
+        auto last_stall() const -> stall_report;
+
+      private:
+        struct state;
+
+        auto watch() -> void;
+
+        /// Count a stall and, unless one was reported recently, return the message to log. Empty if the stall is
+        /// not to be reported. Called with the state locked, so the caller logs the message once it has unlocked.
+        auto report_stall(stall_report report) -> std::string;
+
+        std::shared_ptr< state > state_;
+        std::thread              watcher_;
+    };
+
+    auto operator<<(std::ostream &os, stall_report const &report) -> std::ostream &;
+
+}   // namespace application
@@ -0,0 +1,53 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#include "application/loop_monitor.hpp"
+#include "polyfill/activity.hpp"
+
+#include <catch2/catch.hpp>
+#include <thread>
+
+TEST_CASE("application::loop_monitor")
+{
+    using namespace application;
+    using namespace std::literals;
+
+    auto ioc  = net::io_context();
+    auto work = net::make_work_guard(ioc);
+    auto reg  = polyfill::metrics::registry();
+
+    auto config      = loop_monitor_config();
+    config.name      = "test";
+    config.interval  = 5ms;
+    config.threshold = 20ms;
+    auto monitor     = loop_monitor(ioc.get_executor(), config, reg);
+
+    auto runner = std::thread([&ioc] { ioc.run(); });
+    monitor.start();
+
+    // let a few probes run on the idle loop, so that the monitor learns which thread runs it
+    std::this_thread::sleep_for(50ms);
+    CHECK(monitor.stalls() == 0);
+
+    net::post(ioc, [] {
+        auto busy = polyfill::activity("test sleep");
+        std::this_thread::sleep_for(150ms);
+    });
+    std::this_thread::sleep_for(250ms);
+
+    monitor.stop();
+    work.reset();
+    runner.join();
+
+    // a loaded machine may delay the loop further, so count at least the stall caused here
+    REQUIRE(monitor.stalls() >= 1);
+    auto stall = monitor.last_stall();
+    CHECK(stall.lag >= 100ms);
+    CHECK(stall.activity == "test sleep");
+    CHECK(reg.text().find("application_loop_stalls_total{loop=\"test\"} " + std::to_string(monitor.stalls())) !=
+          std::string::npos);
+}
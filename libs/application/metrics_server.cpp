@@ -0,0 +1,79 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#include "metrics_server.hpp"
+
+#include <array>
+
+namespace application
+{
+    metrics_server::metrics_server(executor_type exec, std::string const &port, polyfill::metrics::registry &registry)
+    : acceptor_(exec, protocol_type::endpoint(net::ip::address_v4::loopback(), std::uint16_t(std::stoi(port))))
+    , registry_(registry)
+    {
+    }
+
+    auto metrics_server::start() -> void
+    {
+        net::co_spawn(
+            get_executor(), [this] { return accept_loop(); }, net::detached);
+    }
+
+    auto metrics_server::stop() -> void
+    {
+        dispatch(bind_executor(get_executor(), [this] {
+            auto ec = error_code();
+            acceptor_.close(ec);
+            for (auto *sock : clients_)
+                sock->close(ec);
+        }));
+    }
+
+    auto metrics_server::accept_loop() -> net::awaitable< void >
+    {
+        auto ec = error_code();
+        while (acceptor_.is_open())
+        {
+            auto sock = socket_type(get_executor());
+            co_await acceptor_.async_accept(sock, net::redirect_error(net::use_awaitable, ec));
+            if (ec == net::error::operation_aborted or ec == net::error::bad_descriptor)
+                co_return;
+            if (ec.failed())
+                continue;
+            net::co_spawn(
+                get_executor(),
+                [this, sock = std::move(sock)]() mutable { return serve(std::move(sock)); },
+                net::detached);
+        }
+    }
+
+    auto metrics_server::serve(socket_type sock) -> net::awaitable< void >
+    {
+        clients_.insert(&sock);
+        auto request = std::string();
+        auto ec      = error_code();
+
+        // The request itself is of no interest, but it must be read before the connection is closed
+        co_await net::async_read_until(
+            sock, net::dynamic_buffer(request, 8192), "\r\n\r\n", net::redirect_error(net::use_awaitable, ec));
+        if (not ec.failed())
+        {
+            auto body   = registry_.text();
+            auto header = "HTTP/1.1 200 OK\r\n"
+                          "Content-Type: text/plain; version=0.0.4\r\n"
+                          "Content-Length: " +
+                          std::to_string(body.size()) +
+                          "\r\n"
+                          "Connection: close\r\n\r\n";
+            auto buffers = std::array< net::const_buffer, 2 > { net::buffer(header), net::buffer(body) };
+            co_await net::async_write(sock, buffers, net::redirect_error(net::use_awaitable, ec));
+            sock.shutdown(socket_type::shutdown_send, ec);
+        }
+        clients_.erase(&sock);
+    }
+
+}   // namespace application
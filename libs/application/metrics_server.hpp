@@ -0,0 +1,49 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#pragma once
+
+#include "application/net.hpp"
+#include "polyfill/metrics.hpp"
+
+#include <set>
+#include <string>
+
+namespace application
+{
+    /// Serves the metrics of a registry over HTTP, in the Prometheus text format, on a port of the loopback
+    /// interface. Every path is answered with the metrics.
+    struct metrics_server
+    {
+        using executor_type = net::io_context::executor_type;
+        using protocol_type = net::ip::tcp;
+        using socket_type   = net::basic_stream_socket< protocol_type, executor_type >;
+        using acceptor_type = net::basic_socket_acceptor< protocol_type, executor_type >;
+
+        metrics_server(executor_type                exec,
+                       std::string const &          port,
+                       polyfill::metrics::registry &registry = polyfill::metrics::registry::global());
+
+        auto start() -> void;
+
+        /// Stop accepting and close any scrapes in progress
+        auto stop() -> void;
+
+        auto local_endpoint() const -> protocol_type::endpoint { return acceptor_.local_endpoint(); }
+
+        auto get_executor() -> executor_type { return acceptor_.get_executor(); }
+
+      private:
+        auto accept_loop() -> net::awaitable< void >;
+        auto serve(socket_type sock) -> net::awaitable< void >;
+
+        acceptor_type                 acceptor_;
+        polyfill::metrics::registry & registry_;
+        std::set< socket_type * >     clients_;
+    };
+
+}   // namespace application
@@ -0,0 +1,42 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#include "application/metrics_server.hpp"
+
+#include <catch2/catch.hpp>
+
+TEST_CASE("application::metrics_server")
+{
+    using namespace application;
+
+    auto ioc = net::io_context();
+    auto reg = polyfill::metrics::registry();
+    reg.counter("test_scrapes_total", "Scrapes").inc(3);
+
+    auto server = metrics_server(ioc.get_executor(), "0", reg);
+    server.start();
+
+    auto response = std::string();
+    net::co_spawn(
+        ioc,
+        [&]() -> net::awaitable< void > {
+            auto sock = metrics_server::socket_type(ioc.get_executor());
+            co_await sock.async_connect(server.local_endpoint(), net::use_awaitable);
+            co_await net::async_write(
+                sock, net::buffer(std::string_view("GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n")), net::use_awaitable);
+            auto ec = error_code();
+            co_await net::async_read(sock, net::dynamic_buffer(response), net::redirect_error(net::use_awaitable, ec));
+            server.stop();
+        },
+        net::detached);
+    ioc.run();
+
+    CHECK(response.rfind("HTTP/1.1 200 OK\r\n", 0) == 0);
+    CHECK(response.find("Content-Type: text/plain; version=0.0.4\r\n") != std::string::npos);
+    CHECK(response.find("\r\n\r\n# HELP test_scrapes_total Scrapes\n# TYPE test_scrapes_total counter\n"
+                        "test_scrapes_total 3\n") != std::string::npos);
+}
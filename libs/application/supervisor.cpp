@@ -0,0 +1,340 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#include "supervisor.hpp"
+
+#include "polyfill/explain.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <csignal>
+#include <cstdio>
+#include <iostream>
+#include <spdlog/spdlog.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+namespace application
+{
+    namespace
+    {
+        auto describe_exit(int status) -> std::string
+        {
+            if (WIFEXITED(status))
+                return "exited with status " + std::to_string(WEXITSTATUS(status));
+            if (WIFSIGNALED(status))
+                return "killed by signal " + std::to_string(WTERMSIG(status));
+            return "ended";
+        }
+
+        auto errno_error(char const *what) -> system_error
+        {
+            return system_error(error_code(errno, boost::system::system_category()), what);
+        }
+    }   // namespace
+
+    // ------ supervisor ------
+
+    supervisor::supervisor(net::io_context &ioc, supervisor_config config, worker_function fn)
+    : ioc_(ioc)
+    , config_(config)
+    , worker_fn_(std::move(fn))
+    , signals_(ioc.get_executor())
+    {
+        for (std::size_t i = 0; i < config_.workers; ++i)
+            workers_.push_back(std::make_unique< worker >(ioc.get_executor()));
+        signals_.add(SIGCHLD);
+        signals_.add(SIGINT);
+        signals_.add(SIGTERM);
+        signals_.add(SIGHUP);
+        signals_.add(SIGUSR1);
+    }
+
+    supervisor::~supervisor()
+    {
+        for (auto &w : workers_)
+            if (w->pid)
+                ::kill(w->pid, SIGTERM);
+    }
+
+    auto supervisor::start() -> void
+    {
+        for (std::size_t i = 0; i < workers_.size(); ++i)
+            spawn(i);
+        await_signal();
+    }
+
+    auto supervisor::stop() -> void
+    {
+        dispatch(bind_executor(get_executor(), [this] {
+            if (stopping_)
+                return;
+            stopping_ = true;
+            for (auto &w : workers_)
+                w->restart_timer.cancel();
+            signal_workers(SIGINT);
+            if (live_workers() == 0)
+                signals_.cancel();
+        }));
+    }
+
+    auto supervisor::stats() const -> worker_stats
+    {
+        auto result = worker_stats();
+        for (auto &w : workers_)
+            for (auto &[name, value] : w->latest)
+                result[name] += value;
+        return result;
+    }
+
+    auto supervisor::spawn(std::size_t index) -> void
+    {
+        auto &w = *workers_[index];
+
+        int fds[2];
+        if (::pipe(fds) != 0)
+            throw errno_error("pipe");
+
+        ioc_.notify_fork(net::execution_context::fork_prepare);
+        auto pid = ::fork();
+        if (pid < 0)
+        {
+            auto err = errno_error("fork");
+            ioc_.notify_fork(net::execution_context::fork_parent);
+            ::close(fds[0]);
+            ::close(fds[1]);
+            throw err;
+        }
+
+        if (pid == 0)
+        {
+            // The child must not run the supervisor's io_context, nor intercept the supervisor's signals
+            ioc_.notify_fork(net::execution_context::fork_child);
+            auto ignore = error_code();
+            signals_.clear(ignore);
+            ::close(fds[0]);
+#ifdef __linux__
+            ::prctl(PR_SET_PDEATHSIG, SIGINT);
+#endif
+            auto rc = 1;
+            try
+            {
+                rc = worker_fn_(worker_context { index, w.generation, fds[1] });
+            }
+            catch (...)
+            {
+                std::cerr << "worker " << index << ": " << polyfill::explain() << std::endl;
+            }
+            std::cout.flush();
+            std::clog.flush();
+            std::fflush(nullptr);
+            ::_exit(rc);
+        }
+
+        ioc_.notify_fork(net::execution_context::fork_parent);
+        ::close(fds[1]);
+
+        w.pid     = pid;
+        w.started = std::chrono::steady_clock::now();
+        ++w.generation;
+        w.stats_pipe.assign(fds[0]);
+        w.stats_buffer.consume(w.stats_buffer.size());
+        w.pending.clear();
+        read_stats(index);
+
+        spdlog::info("supervisor: started worker {} (pid {})", index, pid);
+    }
+
+    auto supervisor::read_stats(std::size_t index) -> void
+    {
+        auto &w = *workers_[index];
+        net::async_read_until(
+            w.stats_pipe, w.stats_buffer, '\n', [this, index, generation = w.generation](error_code ec, std::size_t n) {
+                auto &w = *workers_[index];
+                if (ec.failed() or w.generation != generation)
+                    return;   // the worker has exited
+
+                auto first = net::buffers_begin(w.stats_buffer.data());
+                auto line  = std::string(first, first + (n - 1));
+                w.stats_buffer.consume(n);
+
+                if (line.empty())
+                    w.latest = std::exchange(w.pending, {});
+                else if (auto space = line.rfind(' '); space != std::string::npos)
+                {
+                    auto value = std::int64_t();
+                    if (std::from_chars(line.data() + space + 1, line.data() + line.size(), value).ec == std::errc())
+                        w.pending[line.substr(0, space)] = value;
+                }
+
+                read_stats(index);
+            });
+    }
+
+    auto supervisor::await_signal() -> void
+    {
+        signals_.async_wait([this](error_code ec, int sig) { handle_signal(ec, sig); });
+    }
+
+    auto supervisor::handle_signal(error_code ec, int sig) -> void
+    {
+        if (ec.failed())
+            return;
+
+        switch (sig)
+        {
+        case SIGCHLD:
+            reap();
+            break;
+        case SIGINT:
+        case SIGTERM:
+            spdlog::info("supervisor: stopping workers");
+            stop();
+            break;
+        case SIGHUP:
+            signal_workers(SIGHUP);
+            break;
+        case SIGUSR1:
+            std::cout << "supervisor: stats of " << live_workers() << " workers\n" << stats() << std::flush;
+            break;
+        default:
+            break;
+        }
+
+        if (stopping_ and live_workers() == 0)
+            return;
+        await_signal();
+    }
+
+    auto supervisor::reap() -> void
+    {
+        auto status = int();
+        auto pid    = pid_t();
+        while ((pid = ::waitpid(-1, &status, WNOHANG)) > 0)
+        {
+            for (std::size_t index = 0; index < workers_.size(); ++index)
+            {
+                auto &w = *workers_[index];
+                if (w.pid != pid)
+                    continue;
+
+                spdlog::log(WIFEXITED(status) and WEXITSTATUS(status) == 0 ? spdlog::level::info : spdlog::level::warn,
+                            "supervisor: worker {} (pid {}) {}",
+                            index,
+                            pid,
+                            describe_exit(status));
+                w.pid       = 0;
+                auto ignore = error_code();
+                w.stats_pipe.close(ignore);
+                if (stopping_)
+                    break;
+
+                auto lived = std::chrono::steady_clock::now() - w.started;
+                w.restart_timer.expires_after(lived < config_.restart_delay ? config_.restart_delay - lived
+                                                                            : std::chrono::steady_clock::duration());
+                w.restart_timer.async_wait([this, index](error_code ec) {
+                    if (ec.failed() or stopping_)
+                        return;
+                    try
+                    {
+                        spawn(index);
+                    }
+                    catch (...)
+                    {
+                        spdlog::error("supervisor: worker {} not restarted: {}", index, polyfill::explain());
+                    }
+                });
+                break;
+            }
+        }
+    }
+
+    auto supervisor::signal_workers(int sig) -> void
+    {
+        for (auto &w : workers_)
+            if (w->pid)
+                ::kill(w->pid, sig);
+    }
+
+    auto supervisor::live_workers() const -> std::size_t
+    {
+        return std::size_t(std::count_if(workers_.begin(), workers_.end(), [](auto &w) { return w->pid != 0; }));
+    }
+
+    auto open_shared_listener(std::string const &port) -> int
+    {
+        using tcp = net::ip::tcp;
+
+        auto ioc      = net::io_context();
+        auto acceptor = tcp::acceptor(ioc);
+        acceptor.open(tcp::v4());
+        acceptor.set_option(tcp::acceptor::reuse_address(true));
+        acceptor.bind(tcp::endpoint(net::ip::address_v4::any(), std::uint16_t(std::stoi(port))));
+        acceptor.listen();
+        return acceptor.release();
+    }
+
+    // ------ stats_publisher ------
+
+    stats_publisher::stats_publisher(executor_type             exec,
+                                     int                       fd,
+                                     std::chrono::milliseconds interval,
+                                     producer_type             produce)
+    : pipe_(exec, fd)
+    , timer_(exec)
+    , interval_(interval)
+    , produce_(std::move(produce))
+    {
+    }
+
+    auto stats_publisher::start() -> void
+    {
+        // The supervisor going away ends the reports, and is not otherwise an error
+        net::co_spawn(
+            pipe_.get_executor(), [this] { return run(); }, [](std::exception_ptr) {});
+    }
+
+    auto stats_publisher::stop() -> void
+    {
+        dispatch(bind_executor(pipe_.get_executor(), [this] {
+            stopped_    = true;
+            auto ignore = error_code();
+            timer_.cancel();
+            pipe_.cancel(ignore);
+        }));
+    }
+
+    auto stats_publisher::run() -> net::awaitable< void >
+    {
+        auto stats = worker_stats();
+        auto text  = std::string();
+        while (not stopped_)
+        {
+            stats.clear();
+            produce_(stats);
+            text.clear();
+            for (auto &[name, value] : stats)
+                text.append(name).append(1, ' ').append(std::to_string(value)).append(1, '\n');
+            text.append(1, '\n');
+
+            co_await net::async_write(pipe_, net::buffer(text), net::use_awaitable);
+            timer_.expires_after(interval_);
+            co_await timer_.async_wait(net::use_awaitable);
+        }
+    }
+
+    auto operator<<(std::ostream &os, worker_stats const &stats) -> std::ostream &
+    {
+        for (auto &[name, value] : stats)
+            os << '\t' << name << " : " << value << '\n';
+        return os;
+    }
+
+}   // namespace application
@@ -0,0 +1,152 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#pragma once
+
+#include "application/net.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+namespace application
+{
+    /// Counters reported by a worker, by name
+    using worker_stats = std::map< std::string, std::int64_t >;
+
+    struct supervisor_config
+    {
+        std::size_t workers = 2;
+
+        /// A worker which exits sooner than this after being started is restarted only after this delay, so that a
+        /// worker which cannot start does not cause a fork loop
+        std::chrono::milliseconds restart_delay = std::chrono::seconds(1);
+    };
+
+    /// Passed to each worker process
+    struct worker_context
+    {
+        std::size_t index;        //! 0 .. workers - 1. A restarted worker keeps the index of the one it replaces.
+        std::size_t generation;   //! number of times this worker has been started before
+        int         stats_fd;     //! write end of the pipe to the supervisor. See stats_publisher.
+    };
+
+    /// Runs a number of worker processes and keeps them running.
+    ///
+    /// Workers are forked from the supervisor and so inherit its descriptors, in particular a listening socket
+    /// opened before the supervisor is started (see open_shared_listener). The kernel then shares incoming
+    /// connections between the workers.
+    ///
+    /// - A worker which exits while the supervisor is running is restarted.
+    /// - SIGINT or SIGTERM sends SIGINT to every worker. The supervisor completes once they have all exited.
+    /// - SIGHUP is forwarded to every worker.
+    /// - SIGUSR1 prints the sum of the stats last reported by each worker.
+    ///
+    /// The worker function runs in the child process, which exits with its return value. It must create its own
+    /// io_context; the supervisor's is unusable in the child.
+    struct supervisor
+    {
+        using executor_type   = net::io_context::executor_type;
+        using worker_function = std::function< int(worker_context) >;
+
+        supervisor(net::io_context &ioc, supervisor_config config, worker_function fn);
+        ~supervisor();
+
+        supervisor(supervisor const &) = delete;
+        supervisor &operator=(supervisor const &) = delete;
+
+        auto start() -> void;
+
+        /// Shut down as if interrupted
+        auto stop() -> void;
+
+        /// The sum, over all workers, of the stats each last reported
+        auto stats() const -> worker_stats;
+
+        auto get_executor() -> executor_type { return signals_.get_executor(); }
+
+      private:
+        using signal_set = net::basic_signal_set< executor_type >;
+        using pipe_type  = net::posix::basic_stream_descriptor< executor_type >;
+        using timer_type = net::basic_waitable_timer< std::chrono::steady_clock,
+                                                      net::wait_traits< std::chrono::steady_clock >,
+                                                      executor_type >;
+
+        struct worker
+        {
+            worker(executor_type exec)
+            : stats_pipe(exec)
+            , restart_timer(exec)
+            {
+            }
+
+            pid_t                                 pid        = 0;
+            std::size_t                           generation = 0;
+            std::chrono::steady_clock::time_point started;
+            pipe_type                             stats_pipe;
+            net::streambuf                        stats_buffer;
+            worker_stats                          pending;   //! report being received
+            worker_stats                          latest;    //! last complete report
+            timer_type                            restart_timer;
+        };
+
+        auto spawn(std::size_t index) -> void;
+        auto read_stats(std::size_t index) -> void;
+        auto await_signal() -> void;
+        auto handle_signal(error_code ec, int sig) -> void;
+        auto reap() -> void;
+        auto signal_workers(int sig) -> void;
+        auto live_workers() const -> std::size_t;
+
+        net::io_context &                        ioc_;
+        supervisor_config                        config_;
+        worker_function                          worker_fn_;
+        signal_set                               signals_;
+        std::vector< std::unique_ptr< worker > > workers_;
+        bool                                     stopping_ = false;
+    };
+
+    /// Open a TCP socket listening on all IPv4 interfaces, to be inherited by worker processes.
+    /// \return the native handle of the socket
+    auto open_shared_listener(std::string const &port) -> int;
+
+    /// Sends a worker's stats to its supervisor at regular intervals.
+    ///
+    /// Each report is a series of lines of the form "name value", followed by an empty line.
+    struct stats_publisher
+    {
+        using executor_type = net::io_context::executor_type;
+        using producer_type = std::function< void(worker_stats &) >;
+
+        stats_publisher(executor_type exec, int fd, std::chrono::milliseconds interval, producer_type produce);
+
+        auto start() -> void;
+
+        auto stop() -> void;
+
+      private:
+        auto run() -> net::awaitable< void >;
+
+        net::posix::basic_stream_descriptor< executor_type > pipe_;
+        net::basic_waitable_timer< std::chrono::steady_clock,
+                                   net::wait_traits< std::chrono::steady_clock >,
+                                   executor_type >
+                                  timer_;
+        std::chrono::milliseconds interval_;
+        producer_type             produce_;
+        bool                      stopped_ = false;
+    };
+
+    auto operator<<(std::ostream &os, worker_stats const &stats) -> std::ostream &;
+
+}   // namespace application
@@ -0,0 +1,68 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#include "application/supervisor.hpp"
+
+#include <catch2/catch.hpp>
+#include <csignal>
+
+namespace
+{
+    using namespace std::literals;
+    using namespace application;
+
+    /// Report `stats` until interrupted
+    auto reporting_worker(worker_context ctx, worker_stats stats) -> int
+    {
+        auto ioc       = net::io_context();
+        auto signals   = net::signal_set(ioc, SIGINT);
+        auto publisher = stats_publisher(ioc.get_executor(), ctx.stats_fd, 10ms, [&](worker_stats &s) { s = stats; });
+        publisher.start();
+        signals.async_wait([&](error_code, int) { publisher.stop(); });
+        ioc.run();
+        return 0;
+    }
+}   // namespace
+
+TEST_CASE("application::supervisor")
+{
+    auto ioc   = net::io_context();
+    auto stats = worker_stats();
+    auto timer = net::steady_timer(ioc);
+
+    SECTION("stats of all workers are summed")
+    {
+        auto sup = supervisor(ioc, { 3, 1s }, [](worker_context ctx) {
+            return reporting_worker(ctx, { { "workers", 1 }, { "index", std::int64_t(ctx.index) } });
+        });
+        sup.start();
+        timer.expires_after(500ms);
+        timer.async_wait([&](error_code) {
+            stats = sup.stats();
+            sup.stop();
+        });
+        ioc.run();
+        CHECK(stats == worker_stats { { "workers", 3 }, { "index", 3 } });
+    }
+
+    SECTION("a worker which exits is restarted")
+    {
+        auto sup = supervisor(ioc, { 1, 50ms }, [](worker_context ctx) {
+            if (ctx.generation == 0)
+                return 3;
+            return reporting_worker(ctx, { { "generation", std::int64_t(ctx.generation) } });
+        });
+        sup.start();
+        timer.expires_after(800ms);
+        timer.async_wait([&](error_code) {
+            stats = sup.stats();
+            sup.stop();
+        });
+        ioc.run();
+        CHECK(stats == worker_stats { { "generation", 1 } });
+    }
+}
@@ -16,4 +16,7 @@ namespace minecraft
                     (login_success, 2),
                     (set_compression, 3))
 
+    // play state (serverbound). Only the packets the proxies need to recognise.
+    WISE_ENUM_CLASS((client_play_packet, std::int32_t), (keep_alive, 0x0f))
+
 }   // namespace minecraft
\ No newline at end of file
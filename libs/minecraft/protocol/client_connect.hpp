@@ -10,6 +10,7 @@
 #include "minecraft/server/set_compression.hpp"
 #include "read_frame.hpp"
 #include "minecraft/protocol/expect_frame.hpp"
+#include "minecraft/protocol/timeline.hpp"
 
 namespace minecraft::protocol
 {
@@ -127,7 +128,11 @@ namespace minecraft::protocol
     template < class NextLayer, class CompletionToken >
     auto async_client_connect(protocol::stream< NextLayer > &s, client_connect_state &state, CompletionToken &&token)
     {
-        auto op = [&s, &state, coro = net::coroutine()](
+        auto op = [&s,
+                   &state,
+                   coro  = net::coroutine(),
+                   whole = timeline::no_span,
+                   step  = timeline::no_span](
                       auto &self, error_code ec = {}, std::size_t /*bytes_transferred*/ = 0) mutable {
             auto log_fail = [&s, &ec](auto &&context) {
                 auto fail = ec.failed();
@@ -138,12 +143,19 @@ namespace minecraft::protocol
             auto log_info = [&s](auto &&context) {
                 spdlog::warn("[client_connect {}]  {}", report(s.next_layer()), context);
             };
+            // a step of the login left open by a failure shows where it failed
+            auto next_step = [&s, &step](char const *name) {
+                s.timeline().end(step);
+                step = name ? s.timeline().begin(name) : timeline::no_span;
+            };
 #include <boost/asio/yield.hpp>
             reenter(coro)
             {
                 //
                 // Hello and inform server of protocol version
                 //
+                whole = s.timeline().begin("client connect");
+                next_step("upstream handshake");
                 yield s.async_write_packet(state.client_handshake, std::move(self));
                 if (log_fail("client_handshake"))
                     return self.complete(ec);
@@ -151,6 +163,7 @@ namespace minecraft::protocol
                 //
                 // send login start frame
                 //
+                next_step("upstream login_start");
                 yield s.async_write_packet(state.client_login_start, std::move(self));
                 if (log_fail("client_login_start"))
                     return self.complete(ec);
@@ -160,6 +173,7 @@ namespace minecraft::protocol
                 //
 
             wait_server_response:
+                next_step("upstream response");
                 yield s.async_read_frame(std::move(self));
                 if (log_fail("read first server frame"))
                     return self.complete(ec);
@@ -184,6 +198,7 @@ namespace minecraft::protocol
                 if (state.which_packet_type.value() == server_login_packet::encryption_request)
                 {
                     log_info("server encryption request");
+                    next_step("upstream encryption");
                     validate(state.server_encryption_request, state.server_key, ec);
                     if (log_fail("validate encryption request"))
                         return self.complete(ec);
@@ -200,6 +215,7 @@ namespace minecraft::protocol
                                  report(s.next_layer()),
                                  spdlog::to_hex(state.secret));
                     s.set_encryption(state.secret);
+                    next_step("upstream login_success");
                     yield s.async_read_frame(std::move(self));
                     if (log_fail("receive first encrypted frame"))
                         return self.complete(ec);
@@ -209,9 +225,14 @@ namespace minecraft::protocol
                 // read any success data here
 
                 if (not log_fail("expect server_login_success"))
+                {
                     spdlog::info("[client_connect {}] login success {}",
                                  s.log_id(),
                                  state.server_login_success);
+                    next_step(nullptr);
+                    s.timeline().end(whole);
+                    s.enter_play();
+                }
                 return self.complete(ec);
             }
 #include <boost/asio/unyield.hpp>
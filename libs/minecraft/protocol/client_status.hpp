@@ -0,0 +1,41 @@
+#pragma once
+
+#include "minecraft/net.hpp"
+#include "minecraft/protocol/connection_state.hpp"
+#include "minecraft/protocol/expect_frame.hpp"
+#include "minecraft/protocol/server_handshake.hpp"
+#include "minecraft/protocol/stream.hpp"
+#include "minecraft/status_packets.hpp"
+
+/// @file client_status.hpp
+///
+/// Query the status of a server as a client would when refreshing the server list
+///
+namespace minecraft::protocol
+{
+    /// Perform the status handshake and request on a connected stream.
+    /// The stream's protocol version, server address and server port are presented in the handshake.
+    template < class NextLayer, class CompletionToken >
+    auto async_client_status(stream< NextLayer > &stream, server::status_response &response, CompletionToken &&token)
+    {
+        auto op = [&stream, &response, coro = net::coroutine()](
+                      auto &self, error_code ec = {}, std::size_t /*bytes_transferred*/ = 0) mutable {
+#include <boost/asio/yield.hpp>
+            if (ec.failed())
+                return self.complete(ec);
+            reenter(coro)
+            {
+                yield async_client_handshake(
+                    stream, stream.protocol_version(), connection_state::status, std::move(self));
+                yield stream.async_write_packet(client::status_request(), std::move(self));
+                yield stream.async_read_frame(std::move(self));
+                expect_frame(stream.current_frame(), response, ec);
+                self.complete(ec);
+            }
+#include <boost/asio/unyield.hpp>
+        };
+
+        return net::async_compose< CompletionToken, void(error_code) >(std::move(op), token, stream);
+    }
+
+}   // namespace minecraft::protocol
@@ -4,6 +4,10 @@
 
 #include "minecraft/protocol/compose_area.hpp"
 #include "minecraft/encode.hpp"
+#include "minecraft/parse.hpp"
+#include "minecraft/protocol/stream_metrics.hpp"
+#include "polyfill/activity.hpp"
+#include "polyfill/timestamp.hpp"
 
 namespace minecraft::protocol
 {
@@ -15,10 +19,18 @@ namespace minecraft::protocol
         return buffers[0];
     }
 
-    net::const_buffer compose_area::commit(int compression_threshold)
+    net::const_buffer compose_area::commit(int compression_threshold, packet_profile::state state)
     {
         const auto uncompressed_size = static_cast<int>(frame().size());
 
+        auto ec        = error_code();
+        auto packet_id = std::int32_t(0);
+        auto first     = static_cast< const char * >(frame().data());
+        parse_var(first, first + frame().size(), packet_id, ec);
+        profile_key_         = packet_profile::make_key(packet_profile::direction::tx, state, packet_id);
+        auto compressed_size = std::size_t(uncompressed_size);
+        auto deflate_ns      = std::uint64_t(0);
+
         if (compression_threshold < 0)
         {
             prepend(uncompressed_size);
@@ -31,11 +43,20 @@ namespace minecraft::protocol
         else
         {
             buffers[1].resize(offset);
+            auto busy  = polyfill::activity("deflate");
+            auto start = polyfill::timestamp::now();
             deflator_(frame(), buffers[1]);
+            deflate_ns = polyfill::timestamp::to_nanoseconds(polyfill::timestamp::now() - start);
             buffers[0].swap(buffers[1]);
+            metrics().tx_uncompressed.inc(uncompressed_size);
+            compressed_size = frame().size();
+            metrics().tx_compressed.inc(compressed_size);
             prepend(uncompressed_size);
             prepend(frame().size());
         }
+        packet_profile::global().record_frame(profile_key_, uncompressed_size, compressed_size, deflate_ns);
+        compression_ns_  = deflate_ns;
+        compressed_size_ = compressed_size;
         return frame();
     }
 
@@ -6,6 +6,7 @@
 #include "minecraft/net.hpp"
 #include "minecraft/types.hpp"
 #include "minecraft/protocol/compression/deflate_impl.hpp"
+#include "minecraft/protocol/packet_profile.hpp"
 
 namespace minecraft::protocol
 {
@@ -15,17 +16,29 @@ namespace minecraft::protocol
         // step 1 - reset and return a compose_buffer that the user may *add to* (do not clear)
         compose_buffer &prepare();
 
-        // step 2 - perform compression and add frame
-        net::const_buffer commit(int compression_threshold);
+        // step 2 - perform compression and add frame. The frame is recorded in the packet_profile under `state`.
+        net::const_buffer commit(int compression_threshold, packet_profile::state state = packet_profile::state::play);
 
         // step 3 - retrieve the frame
         [[nodiscard]] auto frame() const -> net::const_buffer;
 
+        // the packet_profile key of the last frame committed
+        [[nodiscard]] auto profile_key() const -> packet_profile::key { return profile_key_; }
+
+        // the time spent compressing the last frame committed, in nanoseconds
+        [[nodiscard]] auto compression_ns() const -> std::uint64_t { return compression_ns_; }
+
+        // the size of the last frame committed after compression, or before it if it was not compressed
+        [[nodiscard]] auto compressed_size() const -> std::size_t { return compressed_size_; }
+
       private:
         auto prepend(std::int32_t n) -> void;
 
         compression::deflate_impl deflator_;
         std::size_t               offset;
         compose_buffer            buffers[2];
+        packet_profile::key       profile_key_ { packet_profile::direction::tx, packet_profile::state::login, 0 };
+        std::uint64_t             compression_ns_  = 0;
+        std::size_t               compressed_size_ = 0;
     };
 }   // namespace minecraft::protocol
\ No newline at end of file
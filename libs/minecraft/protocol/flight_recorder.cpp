@@ -0,0 +1,50 @@
+#include "minecraft/protocol/flight_recorder.hpp"
+
+#include "minecraft/protocol/packet_profile.hpp"
+
+#include <algorithm>
+#include <ctime>
+#include <fmt/format.h>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+namespace minecraft::protocol
+{
+    auto operator<<(std::ostream &os, flight_recorder const &fr) -> std::ostream &
+    {
+        auto first = fr.next_ > flight_recorder::capacity ? fr.next_ - flight_recorder::capacity : 0;
+        for (auto n = first; n < fr.next_; ++n)
+        {
+            auto &r       = fr.entries_[n % flight_recorder::capacity];
+            auto  seconds = std::time_t(r.time_ns / 1'000'000'000);
+            auto  tm      = std::tm();
+            ::gmtime_r(&seconds, &tm);
+
+            os << fmt::format("\t{:02}:{:02}:{:02}.{:06} {} {:<5} {:>4} {:>7} {:>7} ",
+                              tm.tm_hour,
+                              tm.tm_min,
+                              tm.tm_sec,
+                              r.time_ns % 1'000'000'000 / 1000,
+                              to_string(packet_profile::direction(r.direction)),
+                              to_string(packet_profile::state(r.state)),
+                              r.packet_id < 0 ? std::string("?") : fmt::format("{:#04x}", r.packet_id),
+                              r.frame_length,
+                              r.wire_length);
+            for (std::size_t i = 0; i < std::min< std::size_t >(r.payload_length, trace_format::payload_bytes); ++i)
+                os << fmt::format(" {:02x}", r.payload[i]);
+            os << '\n';
+        }
+        if (first)
+            os << "\t(" << first << " earlier frames)\n";
+        return os;
+    }
+
+    auto to_string(flight_recorder const &fr) -> std::string
+    {
+        auto os = std::ostringstream();
+        os << fr;
+        return os.str();
+    }
+
+}   // namespace minecraft::protocol
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "minecraft/protocol/packet_trace_format.hpp"
+
+#include <array>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+namespace minecraft::protocol
+{
+    /// The last few frames a stream has read and written, kept so that they can be reported when the stream fails.
+    ///
+    /// Frames are recorded in the packet trace's format: the header and the first bytes of the payload. The ring is
+    /// part of the stream and entries are overwritten in place, so recording allocates nothing.
+    struct flight_recorder
+    {
+        static constexpr std::size_t capacity = 16;
+
+        auto record(trace_format::record const &r) -> void { entries_[next_++ % capacity] = r; }
+
+        /// Frames ever recorded, of which the last `capacity` are kept
+        auto recorded() const -> std::uint64_t { return next_; }
+
+      private:
+        friend auto operator<<(std::ostream &os, flight_recorder const &fr) -> std::ostream &;
+
+        std::array< trace_format::record, capacity > entries_;
+        std::uint64_t                                next_ = 0;
+    };
+
+    /// One line per frame, oldest first
+    auto operator<<(std::ostream &os, flight_recorder const &fr) -> std::ostream &;
+
+    auto to_string(flight_recorder const &fr) -> std::string;
+
+}   // namespace minecraft::protocol
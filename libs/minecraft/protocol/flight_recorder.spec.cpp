@@ -0,0 +1,38 @@
+#include "minecraft/protocol/flight_recorder.hpp"
+#include "minecraft/protocol/packet_trace.hpp"
+
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <sstream>
+#include <vector>
+
+TEST_CASE("minecraft::protocol::flight_recorder")
+{
+    using namespace minecraft::protocol;
+
+    auto fr = flight_recorder();
+    CHECK(fr.recorded() == 0);
+
+    auto empty = std::ostringstream();
+    empty << fr;
+    CHECK(empty.str().empty());
+
+    // twenty frames into a ring of sixteen: the first four are overwritten
+    for (std::uint8_t id = 0; id < 20; ++id)
+    {
+        auto frame = std::vector< std::uint8_t >(3, 0xab);
+        frame[0]   = id;
+        auto r     = packet_trace::start_record(0, minecraft::net::buffer(frame));
+        packet_trace::finish_record(r, packet_profile::direction::rx, packet_profile::state::play, 3);
+        fr.record(r);
+    }
+    CHECK(fr.recorded() == 20);
+
+    auto text = to_string(fr);
+    CHECK(std::count(text.begin(), text.end(), '\n') == 17);
+    CHECK(text.find("0x03 ") == std::string::npos);
+    CHECK(text.find("0x04 ") != std::string::npos);
+    CHECK(text.find("0x13  ") != std::string::npos);
+    CHECK(text.find(" 13 ab ab\n") != std::string::npos);
+    CHECK(text.find("(4 earlier frames)") != std::string::npos);
+}
@@ -6,8 +6,10 @@
 
 #include "minecraft/net.hpp"
 #include "minecraft/parse.hpp"
+#include "minecraft/protocol/status_cache.hpp"
 #include "minecraft/report.hpp"
 
+#include <algorithm>
 #include <cstdint>
 #include <spdlog/spdlog.h>
 
@@ -55,160 +57,94 @@ namespace minecraft::protocol
                     ec = error::invalid_packet;
                 return first;
             }
-        };
-    }   // namespace client
-
-    template < class Protocol, class Executor, class CompletionToken >
-    auto async_is_old_style_ping(net::basic_stream_socket< Protocol, Executor > &sock, CompletionToken &&token)
-    {
-        using socket_type = net::basic_stream_socket< Protocol, Executor >;
 
-        auto op = [&sock, coro = net::coroutine(), mem = std::vector< char >(1)](
-                      auto &self, error_code ec = {}, std::size_t /*bytes_transfered*/ = 0) mutable {
-#include <boost/asio/yield.hpp>
-            reenter(coro)
+            /// Parse a complete ping.
+            /// Sets error::incomplete_parse if the buffer does not yet hold the whole ping.
+            const_buffer_iterator parse(const_buffer_iterator first, const_buffer_iterator last, error_code &ec)
             {
-                yield
-                {
-                    auto buf = net::buffer(mem);
-                    sock.async_receive(buf, socket_type::message_peek, std::move(self));
-                }
-                if (ec.failed())
-                {
-                    spdlog::info("is_old_style_ping read failure: {}", report(ec));
-                    return self.complete(ec, false);
-                }
-
-                self.complete(ec, (mem[0] == '\xfe'));
+                first = parse_start(first, (std::min)(first + 3, last), ec);
+
+                std::uint16_t length = 0;
+                first                = minecraft::parse(first, last, pinghost, ec);
+                first                = minecraft::parse(first, last, length, ec);
+                if (not ec.failed() and std::distance(first, last) < length)
+                    ec = error::incomplete_parse;
+                if (not ec.failed())
+                    first = parse_rest(first, first + length, ec);
+                return first;
             }
-#include <boost/asio/unyield.hpp>
         };
+    }   // namespace client
 
-        return net::async_compose< CompletionToken, void(error_code, bool) >(std::move(op), token, sock);
-    }
-
+    /// Determine whether a newly accepted connection is a legacy (pre-netty) server list ping.
+    /// The first byte is read into the stream's receive buffer and left there, so that either the legacy ping or the
+    /// handshake is then parsed from the bytes already received.
     template < class Stream, class CompletionToken >
-    auto async_read_be_utf16(Stream &stream, std::u16string &result, CompletionToken &&token)
+    auto async_is_old_style_ping(Stream &stream, CompletionToken &&token)
     {
-        auto op = [&stream, &result, coro = net::coroutine(), length = std::uint16_t(), buffer = std::vector< char >()](
+        auto op = [&stream, coro = net::coroutine()](
                       auto &self, error_code ec = {}, std::size_t /*bytes_transfered*/ = 0) mutable {
-            using minecraft::parse;
-            if (ec.failed())
-                return self.complete(ec);
 #include <boost/asio/yield.hpp>
             reenter(coro)
             {
-                yield
-                {
-                    buffer.reserve(256);
-                    buffer.resize(2);
-                    auto buf = net::buffer(buffer);
-                    net::async_read(stream, buf, std::move(self));
-                }
-
-                parse(buffer.data(), buffer.data() + 2, length, ec);
+                yield stream.async_fill(1, std::move(self));
                 if (ec.failed())
-                    return self.complete(ec);
-
-                buffer.resize(2 + length * 2);
-                yield
                 {
-                    auto buf = net::buffer(buffer);
-                    buf += 2;
-                    net::async_read(stream, buf, std::move(self));
+                    spdlog::debug("is_old_style_ping read failure: {}", report(ec));
+                    return self.complete(ec, false);
                 }
-                parse(buffer.data(), buffer.data() + buffer.size(), result, ec);
-                self.complete(ec);
+
+                self.complete(ec, *static_cast< char const * >(stream.received().data()) == '\xfe');
             }
 #include <boost/asio/unyield.hpp>
         };
 
-        return net::async_compose< CompletionToken, void(error_code) >(std::move(op), token, stream);
+        return net::async_compose< CompletionToken, void(error_code, bool) >(std::move(op), token, stream);
     }
 
-    struct osp_state
-    {
-        client::old_style_ping ping;
-
-        std::u16string      response;
-        std::vector< char > tmpv;
-        std::uint16_t       tmplen;
-    };
-    template < class NextLayer, class CompletionToken >
-    auto async_old_style_ping(stream< NextLayer > &stream, CompletionToken &&token)
+    /// Serve a legacy (pre-netty) server list ping with the legacy reply current in the status cache.
+    /// The ping is parsed from the stream's receive buffer, which is filled only as far as the parse requires.
+    template < class Stream, class CompletionToken >
+    auto async_old_style_ping(Stream &stream, status_cache const &cache, CompletionToken &&token)
     {
-        auto op = [&stream, coro = net::coroutine(), state = std::make_unique< osp_state >()](
+        auto op = [&stream,
+                   &cache,
+                   coro   = net::coroutine(),
+                   ping   = client::old_style_ping(),
+                   frames = std::shared_ptr< status_frames const >()](
                       auto &self, error_code ec = {}, std::size_t /*bytes_transferred*/ = 0) mutable {
-            using minecraft::parse;
 #include <boost/asio/yield.hpp>
             if (ec.failed())
-                self.complete(ec);
+                return self.complete(ec);
             reenter(coro)
             {
-                yield
-                {
-                    state->tmpv.resize(3);
-                    auto bufs = net::buffer(state->tmpv);
-                    async_read(stream.next_layer(), bufs, std::move(self));
-                }
-                {
-                    auto first = state->tmpv.data();
-                    auto last  = first + 3;
-                    state->ping.parse_start(first, last, ec);
-                }
-                if (ec.failed())
-                    self.complete(ec);
-
-                yield async_read_be_utf16(stream.next_layer(), state->ping.pinghost, std::move(self));
-
-                yield
-                {
-                    state->tmpv.resize(2);
-                    auto bufs = net::buffer(state->tmpv);
-                    async_read(stream.next_layer(), bufs, std::move(self));
-                }
-
-                parse(state->tmpv.data(), state->tmpv.data() + 2, state->tmplen, ec);
-                if (state->ping.plugin != 0xfa)
-                    return self.complete(error::invalid_packet);
-
-                yield
+                for (;;)
                 {
-                    state->tmpv.resize(state->tmplen);
-                    auto bufs = net::buffer(state->tmpv);
-                    async_read(stream.next_layer(), bufs, std::move(self));
+                    {
+                        auto data  = stream.received();
+                        auto first = static_cast< const_buffer_iterator >(data.data());
+                        auto last  = ping.parse(first, first + data.size(), ec);
+                        if (not ec.failed())
+                        {
+                            stream.consume(std::size_t(last - first));
+                            break;
+                        }
+                        if (ec != error::incomplete_parse)
+                            return self.complete(ec);
+                        ec.clear();
+                    }
+                    yield stream.async_fill(stream.received().size() + 1, std::move(self));
                 }
 
-                state->ping.parse_rest(state->tmpv.data(), state->tmpv.data() + state->tmpv.size(), ec);
-                if (ec.failed())
-                    self.complete(ec);
-
-                stream.server_address(state->ping.hostname);
-                stream.server_port(state->ping.port);
+                stream.server_address(ping.hostname);
+                stream.server_port(std::uint16_t(ping.port));
 
                 //
                 // now send ping response
                 //
 
-                state->tmpv.clear();
-                state->tmpv.push_back(0xff);
-                state->response.clear();
-                state->response.append(u"§1");
-                state->response.push_back(0);
-                state->response.append(u"127");
-                state->response.push_back(0);
-                state->response.append(u"Welcome to Awesomeness");
-                state->response.push_back(0);
-                state->response.append(u"1000000");
-                state->response.push_back(0);
-                state->response.append(u"1000000000");
-                encode(state->response, back_inserter(state->tmpv));
-
-                yield
-                {
-                    auto bufs = net::buffer(state->tmpv);
-                    net::async_write(stream.next_layer(), bufs, std::move(self));
-                }
+                frames = cache.current();
+                yield net::async_write(stream.next_layer(), frames->legacy_response(), std::move(self));
 
                 self.complete(ec);
             }
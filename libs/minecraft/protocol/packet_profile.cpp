@@ -0,0 +1,92 @@
+#include "packet_profile.hpp"
+
+#include <algorithm>
+#include <fmt/format.h>
+#include <ostream>
+
+namespace minecraft::protocol
+{
+    auto packet_profile::global() -> packet_profile &
+    {
+        static packet_profile p;
+        return p;
+    }
+
+    auto packet_profile::sum() const -> std::vector< std::uint64_t >
+    {
+        auto result = std::vector< std::uint64_t >(keys * fields);
+        cells_.for_each([&](cells_type const &block) {
+            for (std::size_t i = 0; i < result.size(); ++i)
+                result[i] += block[i].load(std::memory_order_relaxed);
+        });
+        return result;
+    }
+
+    auto packet_profile::rows() const -> std::vector< row >
+    {
+        auto lock   = std::lock_guard(mutex_);
+        auto totals = sum();
+        auto result = std::vector< row >();
+        for (std::size_t i = 0; i < keys; ++i)
+        {
+            auto field = [&](std::size_t f) {
+                auto at = i * fields + f;
+                return totals[at] - (baseline_.empty() ? 0 : baseline_[at]);
+            };
+            if (field(0) == 0)
+                continue;
+            auto k = key { direction(i / 512), state(i / 256 % 2), std::uint8_t(i % 256) };
+            result.push_back(row { k, { field(0), field(1), field(2), field(3), field(4) } });
+        }
+        return result;
+    }
+
+    auto packet_profile::reset() -> void
+    {
+        auto lock = std::lock_guard(mutex_);
+        baseline_ = sum();
+    }
+
+    auto packet_profile::write_table(std::ostream &os, order by) const -> void
+    {
+        auto table = rows();
+        auto cpu   = [](row const &r) { return r.t.compression_ns + r.t.cipher_ns; };
+        std::sort(table.begin(), table.end(), [&](row const &a, row const &b) {
+            return by == order::cpu ? cpu(a) > cpu(b) : a.t.compressed_bytes > b.t.compressed_bytes;
+        });
+
+        os << fmt::format("{:>3} {:>5} {:>6} {:>10} {:>14} {:>14} {:>6} {:>12} {:>12}\n",
+                          "dir",
+                          "state",
+                          "packet",
+                          "frames",
+                          "bytes",
+                          "wire bytes",
+                          "ratio",
+                          "zlib us",
+                          "cipher us");
+        for (auto &r : table)
+            os << fmt::format("{:>3} {:>5} {:>#6x} {:>10} {:>14} {:>14} {:>6.2f} {:>12} {:>12}\n",
+                              to_string(r.k.dir),
+                              to_string(r.k.st),
+                              r.k.packet_id,
+                              r.t.frames,
+                              r.t.uncompressed_bytes,
+                              r.t.compressed_bytes,
+                              r.t.uncompressed_bytes ? double(r.t.compressed_bytes) / double(r.t.uncompressed_bytes)
+                                                     : 1.0,
+                              r.t.compression_ns / 1000,
+                              r.t.cipher_ns / 1000);
+    }
+
+    auto to_string(packet_profile::direction d) -> char const *
+    {
+        return d == packet_profile::direction::rx ? "rx" : "tx";
+    }
+
+    auto to_string(packet_profile::state s) -> char const *
+    {
+        return s == packet_profile::state::login ? "login" : "play";
+    }
+
+}   // namespace minecraft::protocol
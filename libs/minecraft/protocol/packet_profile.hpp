@@ -0,0 +1,116 @@
+#pragma once
+
+#include "polyfill/per_thread_store.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace minecraft::protocol
+{
+    /// Traffic of all protocol streams in the process, by direction, connection state and packet id: frames, bytes
+    /// before and after compression, and time spent compressing and in the cipher.
+    ///
+    /// Fed by every stream as frames are read and composed. Each thread records into its own table, so recording
+    /// is a few plain adds. Times are measured with polyfill::timestamp, and so are only as fine as the selected
+    /// clock.
+    struct packet_profile
+    {
+        enum class direction : std::uint8_t
+        {
+            rx,
+            tx
+        };
+
+        enum class state : std::uint8_t
+        {
+            login,
+            play
+        };
+
+        struct key
+        {
+            direction    dir;
+            state        st;
+            std::uint8_t packet_id;   //! ids above 255 are recorded as 255
+        };
+
+        struct totals
+        {
+            std::uint64_t frames             = 0;
+            std::uint64_t uncompressed_bytes = 0;
+            std::uint64_t compressed_bytes   = 0;   //! after compression, or as uncompressed if sent uncompressed
+            std::uint64_t compression_ns     = 0;   //! inflate or deflate
+            std::uint64_t cipher_ns          = 0;
+        };
+
+        struct row
+        {
+            key    k;
+            totals t;
+        };
+
+        enum class order
+        {
+            bytes,   //! compressed bytes, descending
+            cpu      //! compression and cipher time, descending
+        };
+
+        static auto global() -> packet_profile &;
+
+        static auto make_key(direction dir, state st, std::int32_t packet_id) -> key
+        {
+            return key { dir, st, std::uint8_t(packet_id < 0 ? 0 : packet_id > 255 ? 255 : packet_id) };
+        }
+
+        auto record_frame(key k, std::size_t uncompressed, std::size_t compressed, std::uint64_t compression_ns)
+            -> void
+        {
+            auto cells = local_cells().begin() + index(k);
+            polyfill::bump(cells[0], 1);
+            polyfill::bump(cells[1], uncompressed);
+            polyfill::bump(cells[2], compressed);
+            polyfill::bump(cells[3], compression_ns);
+        }
+
+        auto record_cipher(key k, std::uint64_t ns) -> void { polyfill::bump(local_cells()[index(k) + 4], ns); }
+
+        /// The totals recorded since the last reset, of every key with at least one frame
+        auto rows() const -> std::vector< row >;
+
+        /// Start counting again from zero
+        auto reset() -> void;
+
+        auto write_table(std::ostream &os, order by = order::bytes) const -> void;
+
+      private:
+        packet_profile() = default;
+
+        static constexpr std::size_t fields = 5;
+        static constexpr std::size_t keys   = 2 * 2 * 256;
+
+        using cells_type = std::array< std::atomic< std::uint64_t >, keys * fields >;
+
+        static auto index(key k) -> std::size_t
+        {
+            return ((std::size_t(k.dir) * 2 + std::size_t(k.st)) * 256 + k.packet_id) * fields;
+        }
+
+        auto local_cells() -> cells_type & { return cells_.local(); }
+
+        auto sum() const -> std::vector< std::uint64_t >;
+
+        polyfill::per_thread_store< cells_type > cells_;
+        mutable std::mutex                       mutex_;      //! guards baseline_
+        std::vector< std::uint64_t >             baseline_;   //! sums at the last reset
+    };
+
+    auto to_string(packet_profile::direction d) -> char const *;
+    auto to_string(packet_profile::state s) -> char const *;
+
+}   // namespace minecraft::protocol
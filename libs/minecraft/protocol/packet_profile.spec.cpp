@@ -0,0 +1,79 @@
+#include "minecraft/protocol/packet_profile.hpp"
+#include "minecraft/protocol/stream.hpp"
+
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <sstream>
+
+TEST_CASE("minecraft::protocol::packet_profile")
+{
+    using namespace minecraft;
+    using tcp         = net::ip::tcp;
+    using stream_type = protocol::stream<>;
+    using profile     = protocol::packet_profile;
+
+    auto ioc      = net::io_context();
+    auto acceptor = tcp::acceptor(ioc, tcp::endpoint(net::ip::address_v4::loopback(), 0));
+    auto client   = stream_type::next_layer_type(ioc.get_executor());
+    client.connect(acceptor.local_endpoint());
+    auto server = stream_type::next_layer_type(ioc.get_executor());
+    acceptor.accept(server);
+
+    auto sender   = stream_type(std::move(client));
+    auto receiver = stream_type(std::move(server));
+    auto secret   = protocol::shared_secret { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+    for (auto *s : { &sender, &receiver })
+    {
+        s->set_encryption(secret);
+        s->compression_threshold(64);
+        s->enter_play();
+    }
+
+    auto &p = profile::global();
+    p.reset();
+
+    // packet 0x21 is large and compressible, packet 0x05 is below the compression threshold
+    auto big    = std::string(1, '\x21') + std::string(1000, 'x');
+    auto little = std::string(1, '\x05') + "hello";
+    auto ec     = error_code();
+    net::co_spawn(
+        ioc,
+        [&]() -> net::awaitable< void > {
+            for (auto *f : { &big, &little, &big })
+                co_await sender.write_frame(net::buffer(*f), ec);
+            for (int i = 0; i < 3 and not ec.failed(); ++i)
+                co_await receiver.read_frame(ec);
+        },
+        net::detached);
+    ioc.run();
+    REQUIRE(not ec.failed());
+
+    auto rows = p.rows();
+    auto find = [&rows](profile::direction dir, std::uint8_t id) {
+        auto it = std::find_if(rows.begin(), rows.end(), [&](profile::row const &r) {
+            return r.k.dir == dir and r.k.st == profile::state::play and r.k.packet_id == id;
+        });
+        REQUIRE(it != rows.end());
+        return it->t;
+    };
+
+    for (auto dir : { profile::direction::tx, profile::direction::rx })
+    {
+        auto compressed = find(dir, 0x21);
+        CHECK(compressed.frames == 2);
+        CHECK(compressed.uncompressed_bytes == 2 * big.size());
+        CHECK(compressed.compressed_bytes < compressed.uncompressed_bytes / 10);
+
+        auto plain = find(dir, 0x05);
+        CHECK(plain.frames == 1);
+        CHECK(plain.uncompressed_bytes == little.size());
+        CHECK(plain.compressed_bytes == little.size());
+    }
+
+    auto table = std::ostringstream();
+    p.write_table(table, profile::order::cpu);
+    CHECK(table.str().find("0x21") != std::string::npos);
+
+    p.reset();
+    CHECK(p.rows().empty());
+}
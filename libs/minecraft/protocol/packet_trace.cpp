@@ -0,0 +1,108 @@
+#include "minecraft/protocol/packet_trace.hpp"
+
+#include "minecraft/parse.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace minecraft::protocol
+{
+    namespace
+    {
+        auto errno_error(char const *what) -> system_error
+        {
+            return system_error(error_code(errno, boost::system::system_category()), what);
+        }
+    }   // namespace
+
+    auto packet_trace::global() -> packet_trace &
+    {
+        static packet_trace t;
+        return t;
+    }
+
+    packet_trace::~packet_trace() { close(); }
+
+    auto packet_trace::open(std::string const &path, std::size_t capacity) -> void
+    {
+        close();
+        capacity = std::max< std::size_t >(capacity, 1);
+
+        auto fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0)
+            throw errno_error("packet_trace: open");
+
+        auto size = sizeof(trace_format::file_header) + capacity * sizeof(trace_format::record);
+        if (::ftruncate(fd, off_t(size)) != 0)
+        {
+            auto err = errno_error("packet_trace: ftruncate");
+            ::close(fd);
+            throw err;
+        }
+
+        auto map = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (map == MAP_FAILED)
+        {
+            auto err = errno_error("packet_trace: mmap");
+            ::close(fd);
+            throw err;
+        }
+
+        path_     = path;
+        fd_       = fd;
+        map_      = map;
+        map_size_ = size;
+        header_   = static_cast< trace_format::file_header * >(map);
+        std::memcpy(header_->magic, trace_format::magic, sizeof(header_->magic));
+        header_->version     = trace_format::version;
+        header_->record_size = sizeof(trace_format::record);
+        header_->capacity    = capacity;
+        header_->next        = 0;
+        records_             = reinterpret_cast< trace_format::record * >(header_ + 1);
+    }
+
+    auto packet_trace::close() -> void
+    {
+        if (not map_)
+            return;
+        records_ = nullptr;
+        header_  = nullptr;
+        ::munmap(map_, map_size_);
+        ::close(fd_);
+        map_ = nullptr;
+        fd_  = -1;
+        path_.clear();
+    }
+
+    auto packet_trace::start_record(std::uint64_t connection, net::const_buffer frame) -> trace_format::record
+    {
+        auto now     = std::chrono::system_clock::now().time_since_epoch();
+        auto r       = trace_format::record();
+        r.time_ns    = std::uint64_t(std::chrono::duration_cast< std::chrono::nanoseconds >(now).count());
+        r.connection = connection;
+
+        auto ec    = error_code();
+        auto first = static_cast< const char * >(frame.data());
+        parse_var(first, first + frame.size(), r.packet_id, ec);
+        r.frame_length   = std::uint32_t(frame.size());
+        r.payload_length = std::uint16_t(std::min(frame.size(), trace_format::payload_bytes));
+        std::memcpy(r.payload, frame.data(), r.payload_length);
+        return r;
+    }
+
+    auto packet_trace::write(trace_format::record const &r) -> void
+    {
+        if (not records_)
+            return;
+
+        // A reader may map the file while it is written, so the count is advanced atomically
+        auto n = header_->next.fetch_add(1, std::memory_order_relaxed);
+        records_[n % header_->capacity] = r;
+    }
+
+}   // namespace minecraft::protocol
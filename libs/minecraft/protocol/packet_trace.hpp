@@ -0,0 +1,63 @@
+#pragma once
+
+#include "minecraft/net.hpp"
+#include "minecraft/protocol/packet_profile.hpp"
+#include "minecraft/protocol/packet_trace_format.hpp"
+
+#include <string>
+
+namespace minecraft::protocol
+{
+    /// Records frames of selected connections into a ring in a memory mapped file, for decoding by trace_dump.
+    ///
+    /// A record is a store of 64 bytes into the mapping; the kernel writes the pages out in its own time, so
+    /// tracing does not change the timing of the event loop the way logging hex dumps does. Each process writes
+    /// its own file. A stream records only when tracing is enabled on it (see stream::trace) and the file is open.
+    struct packet_trace
+    {
+        static auto global() -> packet_trace &;
+
+        packet_trace(packet_trace const &) = delete;
+        packet_trace &operator=(packet_trace const &) = delete;
+        ~packet_trace();
+
+        /// Create or truncate `path` and map it as a ring of `capacity` records, closing any file already open.
+        /// \throw system_error
+        auto open(std::string const &path, std::size_t capacity) -> void;
+
+        auto close() -> void;
+
+        auto is_open() const -> bool { return records_ != nullptr; }
+
+        auto path() const -> std::string const & { return path_; }
+
+        /// Begin a record of `frame`, the uncompressed frame starting with the packet id. The payload is captured
+        /// here, so that it may be taken before the frame is compressed in place.
+        static auto start_record(std::uint64_t connection, net::const_buffer frame) -> trace_format::record;
+
+        /// Complete a record begun by start_record
+        static auto finish_record(trace_format::record &r,
+                                  packet_profile::direction dir,
+                                  packet_profile::state     st,
+                                  std::size_t               wire_length) -> void
+        {
+            r.direction   = std::uint8_t(dir);
+            r.state       = std::uint8_t(st);
+            r.wire_length = std::uint32_t(wire_length);
+        }
+
+        /// Write a completed record into the ring, if the file is open
+        auto write(trace_format::record const &r) -> void;
+
+      private:
+        packet_trace() = default;
+
+        std::string                 path_;
+        int                         fd_       = -1;
+        void *                      map_      = nullptr;
+        std::size_t                 map_size_ = 0;
+        trace_format::file_header * header_   = nullptr;
+        trace_format::record *      records_  = nullptr;
+    };
+
+}   // namespace minecraft::protocol
@@ -0,0 +1,54 @@
+#include "minecraft/protocol/packet_trace.hpp"
+
+#include <catch2/catch.hpp>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+TEST_CASE("minecraft::protocol::packet_trace")
+{
+    using namespace minecraft::protocol;
+
+    auto  path  = std::string("packet_trace.spec.trace");
+    auto &trace = packet_trace::global();
+    trace.open(path, 4);
+    REQUIRE(trace.is_open());
+
+    // six frames into a ring of four: the first two are overwritten
+    for (std::uint8_t id = 0; id < 6; ++id)
+    {
+        auto frame = std::vector< std::uint8_t >(40 + id, id);
+        auto r     = packet_trace::start_record(7, minecraft::net::buffer(frame));
+        packet_trace::finish_record(r, packet_profile::direction::tx, packet_profile::state::play, 10 + id);
+        trace.write(r);
+    }
+    trace.close();
+    CHECK(not trace.is_open());
+
+    auto in     = std::ifstream(path, std::ios::binary);
+    auto header = trace_format::file_header();
+    in.read(reinterpret_cast< char * >(&header), sizeof(header));
+    CHECK(std::memcmp(header.magic, trace_format::magic, sizeof(header.magic)) == 0);
+    CHECK(header.version == trace_format::version);
+    CHECK(header.record_size == sizeof(trace_format::record));
+    CHECK(header.capacity == 4);
+    CHECK(header.next.load() == 6);
+
+    auto records = std::vector< trace_format::record >(4);
+    in.read(reinterpret_cast< char * >(records.data()), 4 * sizeof(trace_format::record));
+    for (std::uint64_t n = 2; n < 6; ++n)
+    {
+        auto &r = records[n % 4];
+        CHECK(r.connection == 7);
+        CHECK(r.packet_id == int(n));
+        CHECK(r.frame_length == 40 + n);
+        CHECK(r.wire_length == 10 + n);
+        CHECK(r.payload_length == trace_format::payload_bytes);
+        CHECK(r.payload[trace_format::payload_bytes - 1] == n);
+        CHECK(r.direction == std::uint8_t(packet_profile::direction::tx));
+        CHECK(r.state == std::uint8_t(packet_profile::state::play));
+        CHECK(r.time_ns != 0);
+    }
+    std::remove(path.c_str());
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/// @file packet_trace_format.hpp
+///
+/// The layout of a packet trace file, as written by packet_trace and read by the trace_dump tool.
+///
+/// The file is a header followed by a ring of fixed size records. Record `n` is written to slot
+/// `n % capacity`, so once `next` exceeds the capacity the oldest records have been overwritten. All integers are
+/// in the byte order of the machine which wrote the file.
+///
+namespace minecraft::protocol::trace_format
+{
+    constexpr char          magic[8]      = { 'M', 'C', 'T', 'R', 'A', 'C', 'E', '\0' };
+    constexpr std::uint32_t version       = 1;
+    constexpr std::size_t   payload_bytes = 32;   //! the first bytes of each frame, starting with the packet id
+
+    struct file_header
+    {
+        char                         magic[8];
+        std::uint32_t                version;
+        std::uint32_t                record_size;
+        std::uint64_t                capacity;   //! records in the ring
+        std::atomic< std::uint64_t > next;       //! number of records ever written
+        std::uint8_t                 reserved[32];
+    };
+    static_assert(sizeof(file_header) == 64);
+    static_assert(std::atomic< std::uint64_t >::is_always_lock_free, "the file may be mapped by several processes");
+
+    struct record
+    {
+        std::uint64_t time_ns;          //! since the epoch, by the system clock
+        std::uint64_t connection;       //! identifies the connection within the process
+        std::uint8_t  direction;        //! packet_profile::direction
+        std::uint8_t  state;            //! packet_profile::state
+        std::uint16_t payload_length;   //! bytes of `payload` captured
+        std::int32_t  packet_id;
+        std::uint32_t frame_length;     //! uncompressed, including the packet id
+        std::uint32_t wire_length;      //! after compression, or frame_length if sent uncompressed
+        std::uint8_t  payload[payload_bytes];
+    };
+    static_assert(sizeof(record) == 64);
+
+}   // namespace minecraft::protocol::trace_format
@@ -0,0 +1,273 @@
+#pragma once
+
+#include "minecraft/compose.hpp"
+#include "minecraft/encode.hpp"
+#include "minecraft/multibyte.hpp"
+#include "minecraft/net.hpp"
+#include "minecraft/parse.hpp"
+#include "minecraft/protocol/stream.hpp"
+#include "minecraft/protocol/version.hpp"
+#include "minecraft/report.hpp"
+#include "minecraft/stream_traits.hpp"
+
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <fmt/format.h>
+
+/// @file prelogin_stream.hpp
+///
+/// A lightweight stream used between accepting a connection and the client selecting the login state.
+///
+/// Before login the protocol is never compressed or encrypted and every frame a client may legitimately send is
+/// small, so there is no need for the compose areas, inflate context or growable receive buffers of a full
+/// protocol::stream. A prelogin_stream holds the socket, the handshake parameters and a fixed inline receive buffer.
+/// Once the handshake selects login, upgrade() hands the socket, the handshake parameters and any bytes already
+/// received to a newly allocated protocol::stream.
+///
+namespace minecraft::protocol
+{
+    template < class NextLayer = net::basic_stream_socket< net::ip::tcp, net::io_context::executor_type >,
+               std::size_t Capacity = 512 >
+    struct prelogin_stream
+    {
+        using next_layer_type = NextLayer;
+        using executor_type   = typename NextLayer::executor_type;
+
+        static constexpr std::size_t capacity = Capacity;
+
+        prelogin_stream(NextLayer &&next)
+        : next_layer_(std::move(next))
+        {
+        }
+
+        /// Read a complete frame into the inline buffer.
+        /// Completes with error::huge_frame if the frame could never fit in the buffer.
+        template < class CompletionToken >
+        auto async_read_frame(CompletionToken &&token) ->
+            typename net::async_result< std::decay_t< CompletionToken >, void(error_code, std::size_t) >::return_type
+        {
+            auto op = [this, coro = net::coroutine()](
+                          auto &self, error_code ec = {}, std::size_t bytes_transferred = 0) mutable {
+#include <boost/asio/yield.hpp>
+                reenter(coro) for (;;)
+                {
+                    while (not this->decode_frame(ec))
+                    {
+                        if (ec.failed())
+                            return self.complete(ec, 0);
+                        yield next_layer_.async_read_some(
+                            net::buffer(rx_.data() + rx_size_, rx_.size() - rx_size_), std::move(self));
+                        if (ec.failed())
+                            return self.complete(ec, 0);
+                        rx_size_ += bytes_transferred;
+                    }
+                    return self.complete(ec, frame_size_);
+                }
+#include <boost/asio/unyield.hpp>
+            };
+
+            discard_frame();
+            return net::async_compose< CompletionToken, void(error_code, std::size_t) >(
+                std::move(op), token, next_layer_);
+        }
+
+        /// Ensure at least `n` bytes beyond the current frame have been received, without consuming them.
+        /// Whatever the socket has available is read in the same operation, so a subsequent async_read_frame
+        /// usually completes without touching the socket.
+        /// Completes with error::huge_frame if `n` exceeds the capacity of the inline buffer.
+        template < class CompletionToken >
+        auto async_fill(std::size_t n, CompletionToken &&token) ->
+            typename net::async_result< std::decay_t< CompletionToken >, void(error_code, std::size_t) >::return_type
+        {
+            auto op = [this, n, coro = net::coroutine()](
+                          auto &self, error_code ec = {}, std::size_t bytes_transferred = 0) mutable {
+#include <boost/asio/yield.hpp>
+                reenter(coro)
+                {
+                    if (n > rx_.size())
+                        return self.complete(error::huge_frame, rx_size_);
+                    while (rx_size_ < n)
+                    {
+                        yield next_layer_.async_read_some(
+                            net::buffer(rx_.data() + rx_size_, rx_.size() - rx_size_), std::move(self));
+                        if (ec.failed())
+                            return self.complete(ec, rx_size_);
+                        rx_size_ += bytes_transferred;
+                    }
+                    return self.complete(ec, rx_size_);
+                }
+#include <boost/asio/unyield.hpp>
+            };
+
+            discard_frame();
+            return net::async_compose< CompletionToken, void(error_code, std::size_t) >(
+                std::move(op), token, next_layer_);
+        }
+
+        /// Bytes received and not yet consumed. Valid until the next read or consume.
+        /// \pre there is no current frame (i.e. the last read was async_fill)
+        auto received() const -> net::const_buffer { return net::buffer(rx_.data(), rx_size_); }
+
+        /// Remove `n` bytes from the front of the received data
+        auto consume(std::size_t n) -> void
+        {
+            assert(frame_begin_ == 0 and frame_size_ == 0 and n <= rx_size_);
+            std::memmove(rx_.data(), rx_.data() + n, rx_size_ - n);
+            rx_size_ -= n;
+        }
+
+        /// Asynchronously write one uncompressed frame.
+        /// The frame data must remain valid until the operation completes.
+        template < class CompletionToken >
+        auto async_write_frame(net::const_buffer frame_data, CompletionToken &&token) ->
+            typename net::async_result< std::decay_t< CompletionToken >, void(error_code, std::size_t) >::return_type
+        {
+            auto last   = encode(var_int(std::int32_t(frame_data.size())), tx_header_.data());
+            auto header = net::buffer(tx_header_.data(), std::size_t(last - tx_header_.data()));
+            return net::async_write(next_layer_,
+                                    std::array< net::const_buffer, 2 > { header, frame_data },
+                                    std::forward< CompletionToken >(token));
+        }
+
+        template < class Packet, class CompletionToken >
+        auto async_write_packet(Packet const &p, CompletionToken &&token) ->
+            typename net::async_result< std::decay_t< CompletionToken >, void(error_code, std::size_t) >::return_type
+        {
+            tx_body_.clear();
+            compose(p, tx_body_);
+            return async_write_frame(net::buffer(tx_body_), std::forward< CompletionToken >(token));
+        }
+
+        /// The data of the last frame read. Valid until the next call to async_read_frame.
+        auto current_frame() -> net::mutable_buffer { return net::buffer(rx_.data() + frame_begin_, frame_size_); }
+
+        /// Bytes received beyond the end of the current frame
+        auto pending() const -> net::const_buffer
+        {
+            auto used = frame_begin_ + frame_size_;
+            return net::buffer(rx_.data() + used, rx_size_ - used);
+        }
+
+        /// Move the connection into a full protocol stream, carrying over the handshake parameters and any data
+        /// received beyond the current frame.
+        /// \post this object no longer owns a connection
+        auto upgrade() -> stream< NextLayer >
+        {
+            auto result = stream< NextLayer >(std::move(next_layer_), pending());
+            result.protocol_version(protocol_version_);
+            result.server_address(server_address_);
+            result.server_port(server_port_);
+            rx_size_ = frame_begin_ = frame_size_ = 0;
+            return result;
+        }
+
+        auto get_executor() -> executor_type { return next_layer_.get_executor(); }
+
+        void protocol_version(protocol::version_type version) { protocol_version_ = version; }
+        auto protocol_version() const -> protocol::version_type { return protocol_version_; }
+        auto server_address(std::string const &val) -> void { server_address_ = val; }
+        auto server_address(std::u16string const &val) -> void { convert(val, server_address_); }
+        auto server_address() const -> std::string const & { return server_address_; }
+        auto server_port(std::uint16_t val) -> void { server_port_ = val; }
+        auto server_port() const -> std::uint16_t { return server_port_; }
+
+        auto next_layer() -> next_layer_type & { return next_layer_; }
+        auto next_layer() const -> next_layer_type const & { return next_layer_; }
+
+        auto close() noexcept -> void
+        {
+            error_code ec;
+            next_layer_.close(ec);
+        }
+
+        auto cancel() noexcept -> void
+        {
+            error_code ec;
+            next_layer_.cancel(ec);
+        }
+
+        auto log_id() const -> std::string
+        {
+            if constexpr (has_remote_endpoint_v< NextLayer >)
+            {
+                error_code ec;
+                auto       local  = next_layer_.local_endpoint(ec);
+                auto       remote = next_layer_.remote_endpoint(ec);
+                return fmt::format("[stream {}->{}]", report(local), report(remote));
+            }
+            else
+                return "test";
+        }
+
+      private:
+        auto discard_frame() -> void
+        {
+            auto used = frame_begin_ + frame_size_;
+            if (used)
+            {
+                std::memmove(rx_.data(), rx_.data() + used, rx_size_ - used);
+                rx_size_ -= used;
+                frame_begin_ = frame_size_ = 0;
+            }
+        }
+
+        /// Attempt to locate a complete frame at the front of the receive buffer.
+        /// \return true if a frame is available. If false and ec is not set, more data is required.
+        auto decode_frame(error_code &ec) -> bool
+        {
+            var_int length;
+            auto    first = static_cast< const_buffer_iterator >(rx_.data());
+            auto    next  = parse(first, first + rx_size_, length, ec);
+            if (ec == error::incomplete_parse)
+            {
+                ec.clear();
+                if (rx_size_ == rx_.size())
+                    ec = error::huge_frame;
+                return false;
+            }
+            if (ec.failed())
+                return false;
+            if (length.value() < 0)
+            {
+                ec = error::invalid_packet;
+                return false;
+            }
+
+            auto header = std::size_t(next - first);
+            auto size   = std::size_t(length.value());
+            if (header + size > rx_.size())
+            {
+                ec = error::huge_frame;
+                return false;
+            }
+            if (header + size > rx_size_)
+                return false;
+
+            frame_begin_ = header;
+            frame_size_  = size;
+            return true;
+        }
+
+        next_layer_type next_layer_;
+
+        protocol::version_type protocol_version_ = protocol::version_type::not_set;
+        std::string            server_address_;
+        std::uint16_t          server_port_ = 0;
+
+        std::size_t                  rx_size_     = 0;
+        std::size_t                  frame_begin_ = 0;
+        std::size_t                  frame_size_  = 0;
+        std::array< char, Capacity > rx_;
+        std::array< char, 5 >        tx_header_;
+        compose_buffer               tx_body_;   // only used for status responses
+    };
+
+    template < class Stream, class NextLayer, std::size_t Capacity >
+    Stream &operator<<(Stream &os, prelogin_stream< NextLayer, Capacity > const &arg)
+    {
+        os << arg.log_id();
+        return os;
+    }
+
+}   // namespace minecraft::protocol
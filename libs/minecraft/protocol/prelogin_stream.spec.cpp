@@ -0,0 +1,155 @@
+#include "minecraft/client/handshake.hpp"
+#include "old_style_ping.hpp"
+#include "prelogin_stream.hpp"
+#include "server_handshake.hpp"
+#include "stream.hpp"
+
+#include <boost/beast/_experimental/test/stream.hpp>
+#include <boost/beast/core/buffers_to_string.hpp>
+#include <catch2/catch.hpp>
+
+TEST_CASE("minecraft::prelogin_stream")
+{
+    using namespace minecraft;
+    using test_stream = boost::beast::test::stream;
+    auto ioc          = net::io_context();
+
+    auto client = protocol::stream< test_stream >(test_stream(ioc));
+    auto server = protocol::prelogin_stream< test_stream >(connect(client.next_layer()));
+
+    error_code  ec;
+    std::size_t bytes_transferred = 0;
+    auto        handler           = [&ec, &bytes_transferred](error_code ec_, std::size_t bytes_transferred_) {
+        ec                = ec_;
+        bytes_transferred = bytes_transferred_;
+    };
+
+    SECTION("frames split across reads and coalesced in one read")
+    {
+        // two frames "abc" and "de" followed by the first byte of a third
+        server.next_layer().append("\x03"
+                                   "ab");
+        bytes_transferred = 0;
+        server.async_read_frame(handler);
+        ioc.poll();
+        CHECK(bytes_transferred == 0);
+
+        auto more = std::string("c\x02"
+                                "de\x05");
+        net::write(client.next_layer(), net::buffer(more));
+        ioc.run();
+        ioc.restart();
+        CHECK(not ec.failed());
+        CHECK(bytes_transferred == 3);
+        CHECK(boost::beast::buffers_to_string(server.current_frame()) == "abc");
+
+        server.async_read_frame(handler);
+        ioc.run();
+        ioc.restart();
+        CHECK(not ec.failed());
+        CHECK(boost::beast::buffers_to_string(server.current_frame()) == "de");
+        CHECK(server.pending().size() == 1);
+    }
+
+    SECTION("frames larger than the inline buffer are refused")
+    {
+        auto header = std::string();
+        encode(var_int(std::int32_t(decltype(server)::capacity)), std::back_inserter(header));
+        server.next_layer().append(header);
+        server.async_read_frame(handler);
+        ioc.run();
+        CHECK(ec == error::huge_frame);
+    }
+
+    SECTION("upgrade carries the handshake and pending data into a full stream")
+    {
+        auto hs             = client::handshake();
+        hs.protocol_version = protocol::version_type::v1_15_2;
+        hs.server_address   = "example.com";
+        hs.server_port      = 25565;
+        hs.next_state       = protocol::connection_state::login;
+
+        auto hs_frame = compose_buffer();
+        compose(hs, hs_frame);
+        auto wire = compose_buffer();
+        compose(hs_frame, wire);
+        compose(compose_buffer { 'x', 'y', 'z' }, wire);
+        server.next_layer().append(boost::beast::string_view(wire.data(), wire.size()));
+
+        auto state = protocol::connection_state::initial;
+        protocol::async_server_handshake(server, [&](error_code ec_, protocol::connection_state state_) {
+            ec    = ec_;
+            state = state_;
+        });
+        ioc.run();
+        ioc.restart();
+        REQUIRE(not ec.failed());
+        CHECK(state == protocol::connection_state::login);
+        CHECK(server.server_address() == "example.com");
+
+        auto full = server.upgrade();
+        CHECK(full.protocol_version() == protocol::version_type::v1_15_2);
+        CHECK(full.server_address() == "example.com");
+        CHECK(full.server_port() == 25565);
+
+        full.async_read_frame(handler);
+        ioc.run();
+        CHECK(not ec.failed());
+        CHECK(boost::beast::buffers_to_string(full.current_frame()) == "xyz");
+    }
+
+    SECTION("legacy ping detection leaves the first byte for the handshake")
+    {
+        auto hs             = client::handshake();
+        hs.protocol_version = protocol::version_type::v1_15_2;
+        hs.server_address   = "example.com";
+        hs.server_port      = 25565;
+        hs.next_state       = protocol::connection_state::status;
+
+        auto hs_frame = compose_buffer();
+        compose(hs, hs_frame);
+        auto wire = compose_buffer();
+        compose(hs_frame, wire);
+        server.next_layer().append(boost::beast::string_view(wire.data(), wire.size()));
+
+        auto legacy = true;
+        protocol::async_is_old_style_ping(server, [&](error_code ec_, bool legacy_) {
+            ec     = ec_;
+            legacy = legacy_;
+        });
+        ioc.run();
+        ioc.restart();
+        REQUIRE(not ec.failed());
+        CHECK(not legacy);
+        CHECK(server.received().size() == wire.size());
+
+        auto state = protocol::connection_state::initial;
+        protocol::async_server_handshake(server, [&](error_code ec_, protocol::connection_state state_) {
+            ec    = ec_;
+            state = state_;
+        });
+        ioc.run();
+        CHECK(not ec.failed());
+        CHECK(state == protocol::connection_state::status);
+    }
+
+    SECTION("legacy ping is detected and parsed from buffered data")
+    {
+        server.next_layer().append("\xfe\x01\xfa");
+
+        auto legacy = false;
+        protocol::async_is_old_style_ping(server, [&](error_code ec_, bool legacy_) {
+            ec     = ec_;
+            legacy = legacy_;
+        });
+        ioc.run();
+        REQUIRE(not ec.failed());
+        CHECK(legacy);
+
+        auto ping  = protocol::client::old_style_ping();
+        auto data  = server.received();
+        auto first = static_cast< const_buffer_iterator >(data.data());
+        ping.parse(first, first + data.size(), ec);
+        CHECK(ec == error::incomplete_parse);
+    }
+}
@@ -12,8 +12,10 @@
 #include "minecraft/server/encryption_request.hpp"
 #include "minecraft/server/login_success.hpp"
 #include "minecraft/server/set_compression.hpp"
+#include "polyfill/activity.hpp"
 #include "read_frame.hpp"
 #include "stream.hpp"
+#include "timeline.hpp"
 
 #include <boost/uuid/random_generator.hpp>
 #include <boost/uuid/uuid_io.hpp>
@@ -67,9 +69,19 @@ namespace minecraft::protocol
             return ec;
         };
 
+        /// End the current step of the login in the timeline and begin the next, if any. A step left open by a
+        /// failure shows where the login failed.
+        auto next_step(protocol::timeline &t, char const *name) -> void
+        {
+            t.end(step);
+            step = name ? t.begin(name) : timeline::no_span;
+        }
+
         server_accept_state &state;
         net::coroutine       coro;
         const char *         context = "login start";
+        timeline::span       whole   = timeline::no_span;
+        timeline::span       step    = timeline::no_span;
     };
 
     template < class NextLayer >
@@ -100,6 +112,8 @@ namespace minecraft::protocol
 
             reenter(coro)
             {
+                whole = stream.timeline().begin("server accept");
+                next_step(stream.timeline(), "login_start");
                 yield
                 {
                     auto &pkt = state.client_packet.emplace< client::login_start >();
@@ -117,6 +131,7 @@ namespace minecraft::protocol
                 {
                     context = "encryption request";
 
+                    next_step(stream.timeline(), "encryption_request");
                     yield
                     {
                         auto &pkt = state.server_packet.emplace< server::encryption_request >();
@@ -129,6 +144,7 @@ namespace minecraft::protocol
                     // receive encryption response
                     //
 
+                    next_step(stream.timeline(), "encryption_response");
                     yield
                     {
                         context   = "encryption response";
@@ -140,10 +156,12 @@ namespace minecraft::protocol
                     // decode shared secret
                     //
 
+                    next_step(stream.timeline(), "rsa decrypt");
                     {
                         using net::buffer;
                         auto &request  = std::get< server::encryption_request >(state.server_packet);
                         auto &response = std::get< client::encryption_response >(state.client_packet);
+                        auto  busy     = polyfill::activity("login decryption");
                         auto  secret   = response.decrypt_secret(*state.server_key, request.verify_token, ec);
                         if (log_fail(ec).failed())
                             return self.complete(ec);
@@ -165,6 +183,7 @@ namespace minecraft::protocol
                     //
                 }
 
+                next_step(stream.timeline(), "set_compression");
                 yield
                 {
                     context       = "set compression";
@@ -179,6 +198,7 @@ namespace minecraft::protocol
                 //
                 // send login success
                 //
+                next_step(stream.timeline(), "login_success");
                 yield
                 {
                     context      = "success";
@@ -187,6 +207,12 @@ namespace minecraft::protocol
                     pkt.uuid     = to_string(server_accept_op_base::generate_uuid());
                     stream.async_write_packet(pkt, std::move(self));
                 }
+                if (not ec.failed())
+                {
+                    next_step(stream.timeline(), nullptr);
+                    stream.timeline().end(whole);
+                    stream.enter_play();
+                }
                 return self.complete(log_fail(ec));
             }
 #include <boost/asio/unyield.hpp>
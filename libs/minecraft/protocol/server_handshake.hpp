@@ -44,8 +44,10 @@ namespace minecraft::protocol
         return net::async_compose< CompletionHandler, void(error_code) >(std::move(op), handler, stream);
     }
 
-    template < class NextLayer, class CompletionHandler >
-    auto async_server_handshake(stream< NextLayer > &stream, CompletionHandler &&handler)
+    /// Receive the handshake as a server.
+    /// Stream may be a protocol::stream or a protocol::prelogin_stream.
+    template < class Stream, class CompletionHandler >
+    auto async_server_handshake(Stream &stream, CompletionHandler &&handler)
     {
         auto op = [&stream, coro = net::coroutine(), request = std::make_unique< minecraft::client::handshake >()](
                       auto &self, error_code ec = {}, std::size_t /*bytes_transferred*/ = 0) mutable {
@@ -0,0 +1,181 @@
+#include "status_cache.hpp"
+
+#include "minecraft/encode.hpp"
+#include "minecraft/status_packets.hpp"
+#include "polyfill/multibyte.hpp"
+
+#include <boost/json.hpp>
+#include <fmt/format.h>
+#include <sstream>
+
+namespace minecraft::protocol
+{
+    namespace json = boost::json;
+
+    namespace
+    {
+        auto member(json::object const &obj, json::string_view key) -> json::value const *
+        {
+            auto iter = obj.find(key);
+            if (iter == obj.end())
+                return nullptr;
+            return &iter->value();
+        }
+
+        auto as_string(json::value const *v) -> std::string
+        {
+            if (v and v->is_string())
+                return std::string(v->as_string().data(), v->as_string().size());
+            return std::string();
+        }
+
+        auto as_integer(json::value const *v, std::int64_t def) -> std::int64_t
+        {
+            if (v and v->is_int64())
+                return v->as_int64();
+            if (v and v->is_uint64())
+                return std::int64_t(v->as_uint64());
+            return def;
+        }
+
+        // a description is either a plain string or a chat component
+        auto description_text(json::value const *v) -> std::string
+        {
+            if (v and v->is_object())
+            {
+                auto result = as_string(member(v->as_object(), "text"));
+                if (auto extra = member(v->as_object(), "extra"); extra and extra->is_array())
+                    for (auto &e : extra->as_array())
+                        result += description_text(&e);
+                return result;
+            }
+            return as_string(v);
+        }
+    }   // namespace
+
+    auto status_info::to_json() const -> std::string
+    {
+        auto version        = json::object();
+        version["name"]     = json::string(version_name);
+        version["protocol"] = json::value(static_cast< std::int64_t >(protocol_version));
+
+        auto players      = json::object();
+        players["max"]    = json::value(max_players);
+        players["online"] = json::value(online_players);
+        if (not sample.empty())
+        {
+            auto arr = json::array();
+            for (auto &p : sample)
+            {
+                auto entry    = json::object();
+                entry["name"] = json::string(p.name);
+                entry["id"]   = json::string(p.id);
+                arr.emplace_back(std::move(entry));
+            }
+            players["sample"] = std::move(arr);
+        }
+
+        auto desc    = json::object();
+        desc["text"] = json::string(description);
+
+        auto doc           = json::object();
+        doc["version"]     = std::move(version);
+        doc["players"]     = std::move(players);
+        doc["description"] = std::move(desc);
+        if (not favicon.empty())
+            doc["favicon"] = json::string(favicon);
+
+        auto os = std::ostringstream();
+        os << json::value(std::move(doc));
+        return os.str();
+    }
+
+    auto status_info::from_json(std::string_view text, error_code &ec) -> status_info
+    {
+        auto result = status_info();
+
+        auto doc = json::parse(json::string_view(text.data(), text.size()), ec);
+        if (ec.failed())
+            return result;
+        if (not doc.is_object())
+        {
+            ec = error::invalid_packet;
+            return result;
+        }
+
+        auto &root = doc.as_object();
+        if (auto version = member(root, "version"); version and version->is_object())
+        {
+            result.version_name     = as_string(member(version->as_object(), "name"));
+            result.protocol_version = static_cast< version_type >(as_integer(
+                member(version->as_object(), "protocol"), static_cast< std::int64_t >(result.protocol_version)));
+        }
+        if (auto players = member(root, "players"); players and players->is_object())
+        {
+            auto &obj             = players->as_object();
+            result.max_players    = as_integer(member(obj, "max"), 0);
+            result.online_players = as_integer(member(obj, "online"), 0);
+            if (auto sample = member(obj, "sample"); sample and sample->is_array())
+                for (auto &e : sample->as_array())
+                    if (e.is_object())
+                        result.sample.push_back(
+                            { as_string(member(e.as_object(), "name")), as_string(member(e.as_object(), "id")) });
+        }
+        result.description = description_text(member(root, "description"));
+        result.favicon     = as_string(member(root, "favicon"));
+        return result;
+    }
+
+    auto operator<<(std::ostream &os, status_info const &info) -> std::ostream &
+    {
+        fmt::print(os,
+                   "[status_info [version {} {}] [players {}/{}] [description {}]]",
+                   info.version_name,
+                   static_cast< std::int32_t >(info.protocol_version),
+                   info.online_players,
+                   info.max_players,
+                   info.description);
+        return os;
+    }
+
+    // ------ status_frames ------
+
+    status_frames::status_frames(status_info info)
+    : info_(std::move(info))
+    {
+        auto response = server::status_response();
+        response.json = info_.to_json();
+        compose(response, response_);
+
+        // The legacy reply is a kick packet carrying a null separated UTF-16 string:
+        // §1, protocol, version name, description, online players, max players
+        auto text = fmt::format("\xc2\xa7"
+                                "1{}127{}{}{}{}{}{}{}{}",
+                                '\0',
+                                '\0',
+                                info_.version_name,
+                                '\0',
+                                info_.description,
+                                '\0',
+                                info_.online_players,
+                                '\0',
+                                info_.max_players);
+        auto utf16 = std::u16string();
+        polyfill::convert(text, utf16);
+        legacy_response_.push_back(char(0xff));
+        encode(utf16, back_inserter(legacy_response_));
+    }
+
+    // ------ status_cache ------
+
+    status_cache::status_cache(status_info const &initial)
+    : current_(std::make_shared< status_frames const >(initial))
+    {
+    }
+
+    auto status_cache::update(status_info info) -> void
+    {
+        std::atomic_store(&current_, std::make_shared< status_frames const >(std::move(info)));
+    }
+
+}   // namespace minecraft::protocol
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "minecraft/net.hpp"
+#include "minecraft/protocol/version.hpp"
+#include "minecraft/types.hpp"
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// @file status_cache.hpp
+///
+/// Server list status replies are by far the most frequent request a server receives and their content only
+/// changes when the player count does. The status is therefore composed once, whenever it changes, into frames
+/// that every connection serving a status request shares.
+///
+namespace minecraft::protocol
+{
+    /// The information presented in the server list, both by the modern status protocol and the legacy ping
+    struct status_info
+    {
+        struct player
+        {
+            std::string name;
+            std::string id;
+        };
+
+        std::string           version_name     = "1.15.2";
+        version_type          protocol_version = version_type::v1_15_2;
+        std::int64_t          max_players      = 20;
+        std::int64_t          online_players   = 0;
+        std::vector< player > sample;
+        std::string           description;
+        std::string           favicon;   //! data:image/png;base64,... or empty
+
+        /// Render the status as the JSON document sent in a status response
+        auto to_json() const -> std::string;
+
+        /// Interpret the JSON document in a status response received from another server
+        static auto from_json(std::string_view json, error_code &ec) -> status_info;
+
+        friend auto operator<<(std::ostream &os, status_info const &info) -> std::ostream &;
+    };
+
+    /// Immutable pre-composed status replies
+    struct status_frames
+    {
+        explicit status_frames(status_info info);
+
+        /// The body of the status response frame (packet id and JSON)
+        auto response() const -> net::const_buffer { return net::buffer(response_); }
+
+        /// The complete legacy (pre-netty) ping reply, ready to be written to the socket
+        auto legacy_response() const -> net::const_buffer { return net::buffer(legacy_response_); }
+
+        auto info() const -> status_info const & { return info_; }
+
+      private:
+        status_info    info_;
+        compose_buffer response_;
+        compose_buffer legacy_response_;
+    };
+
+    /// Holds the current status frames. The status may be updated from any thread; connections serving a
+    /// request hold a reference to the frames they are sending until the write completes.
+    struct status_cache
+    {
+        explicit status_cache(status_info const &initial = status_info());
+
+        auto current() const -> std::shared_ptr< status_frames const > { return std::atomic_load(&current_); }
+
+        auto update(status_info info) -> void;
+
+      private:
+        std::shared_ptr< status_frames const > current_;
+    };
+
+}   // namespace minecraft::protocol
@@ -0,0 +1,57 @@
+#include "status_cache.hpp"
+
+#include <catch2/catch.hpp>
+
+TEST_CASE("minecraft::protocol::status_cache")
+{
+    using namespace minecraft;
+
+    auto info           = protocol::status_info();
+    info.description    = "hello";
+    info.online_players = 3;
+    info.max_players    = 10;
+    info.sample.push_back({ "alice", "00000000-0000-0000-0000-000000000001" });
+
+    SECTION("frames")
+    {
+        auto frames = protocol::status_frames(info);
+
+        auto response = frames.response();
+        REQUIRE(response.size() > 1);
+        CHECK(static_cast< char const * >(response.data())[0] == 0x00);   // packet id
+
+        auto legacy = frames.legacy_response();
+        REQUIRE(legacy.size() > 3);
+        CHECK(static_cast< unsigned char const * >(legacy.data())[0] == 0xff);
+    }
+
+    SECTION("json round trip")
+    {
+        auto ec   = error_code();
+        auto back = protocol::status_info::from_json(info.to_json(), ec);
+        REQUIRE(not ec.failed());
+        CHECK(back.description == "hello");
+        CHECK(back.online_players == 3);
+        CHECK(back.max_players == 10);
+        REQUIRE(back.sample.size() == 1);
+        CHECK(back.sample[0].name == "alice");
+    }
+
+    SECTION("malformed json is reported")
+    {
+        auto ec = error_code();
+        protocol::status_info::from_json("{\"players\":", ec);
+        CHECK(ec.failed());
+    }
+
+    SECTION("update replaces the shared frames")
+    {
+        auto cache  = protocol::status_cache(info);
+        auto before = cache.current();
+        info.online_players = 4;
+        cache.update(info);
+        CHECK(cache.current() != before);
+        CHECK(cache.current()->info().online_players == 4);
+        CHECK(before->info().online_players == 3);
+    }
+}
@@ -17,6 +17,16 @@ namespace minecraft::protocol
         {
         }
 
+        /// Construct a stream over a connection on which some data has already been received, for example by a
+        /// prelogin_stream. The data is treated as the start of the receive stream.
+        stream(NextLayer &&next, net::const_buffer already_received)
+        : impl_(construct(std::move(next)))
+        {
+            auto &rx    = impl_->compressed_rx_data_.payload;
+            auto  first = static_cast< const char * >(already_received.data());
+            rx.insert(rx.end(), first, first + already_received.size());
+        }
+
         stream(stream &&other)
         : impl_(other.release())
         {
@@ -56,11 +66,22 @@ namespace minecraft::protocol
         auto async_write_packet(Packet const &p, CompletionToken &&token) ->
             typename net::async_result< std::decay_t< CompletionToken >, void(error_code, std::size_t) >::return_type;
 
+        /// Coroutine forms of the operations above. Failure is reported through `ec` rather than by throwing,
+        /// since a disconnect is a normal event on a busy server and should not cost an exception.
+        auto read_frame(error_code &ec) -> net::awaitable< std::size_t >;
+        auto write_frame(net::const_buffer frame_data, error_code &ec) -> net::awaitable< std::size_t >;
+        template < class Packet >
+        auto write_packet(Packet const &p, error_code &ec) -> net::awaitable< std::size_t >;
+
         /// Return a mutable_buffer representing the data in last frame to be read.
         /// The user may modify the data in this buffer.
         /// The data in the buffer will be valid until the next async_read_frame call
         auto current_frame() -> net::mutable_buffer;
 
+        /// The polyfill::timestamp at which the last of the current frame's data was received from the socket.
+        /// A frame which arrived in the same read as earlier frames shares their timestamp.
+        auto frame_received() const -> std::uint64_t;
+
         auto get_executor() const -> executor_type;
 
         /// Enable encryption and set the shared secret
@@ -74,6 +95,24 @@ namespace minecraft::protocol
             impl_->set_encryption(secret);
         }
 
+        /// Record the frames of this stream in the packet_trace under `id`, or stop if `id` is 0
+        auto trace(std::uint64_t id) -> void;
+
+        auto trace_id() const -> std::uint64_t;
+
+        /// The last frames read and written, for reporting a failure
+        auto recent_frames() const -> flight_recorder const &;
+
+        /// The steps of the login on this stream, recorded once the timeline has been enabled
+        auto timeline() -> protocol::timeline &;
+        auto timeline() const -> protocol::timeline const &;
+
+        /// The bytes, frames and processing time of the stream so far
+        auto usage() const -> stream_usage const &;
+
+        /// Note that the login has succeeded. Subsequent frames are recorded in the packet_profile as play packets.
+        auto enter_play() -> void;
+
         auto compression_threshold(std::int32_t threshold) -> void;
         auto compression_threshold() const -> std::int32_t;
         auto player_name(std::string const &val) -> void;
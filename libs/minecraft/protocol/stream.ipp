@@ -19,7 +19,7 @@ namespace minecraft::protocol
         auto& input_buffer = area.prepare();
         auto source = to_span(frame_data);
         input_buffer.insert(input_buffer.end(), source.begin(), source.end());
-        auto buf = area.commit(impl_->compression_threshold_);
+        auto buf = impl_->commit_frame();
 //        spdlog::info("{} writing a frame: {:n} - {:n}", *this, buf.size(), spdlog::to_hex(to_span(buf)));
         return impl_->async_write(buf,std::forward< CompletionToken >(token));
     }
@@ -31,7 +31,27 @@ namespace minecraft::protocol
     {
         auto &area = impl_->compose_area_;
         compose(p, area.prepare());
-        return impl_->async_write(area.commit(impl_->compression_threshold_), std::forward< CompletionToken >(token));
+        return impl_->async_write(impl_->commit_frame(), std::forward< CompletionToken >(token));
+    }
+
+    template < class NextLayer >
+    auto stream< NextLayer >::read_frame(error_code &ec) -> net::awaitable< std::size_t >
+    {
+        return async_read_frame(net::redirect_error(net::use_awaitable, ec));
+    }
+
+    template < class NextLayer >
+    auto stream< NextLayer >::write_frame(net::const_buffer frame_data, error_code &ec)
+        -> net::awaitable< std::size_t >
+    {
+        return async_write_frame(frame_data, net::redirect_error(net::use_awaitable, ec));
+    }
+
+    template < class NextLayer >
+    template < class Packet >
+    auto stream< NextLayer >::write_packet(Packet const &p, error_code &ec) -> net::awaitable< std::size_t >
+    {
+        return async_write_packet(p, net::redirect_error(net::use_awaitable, ec));
     }
 
     template < class NextLayer >
@@ -60,6 +80,54 @@ namespace minecraft::protocol
         return impl_->current_frame();
     }
 
+    template < class NextLayer >
+    auto stream< NextLayer >::trace(std::uint64_t id) -> void
+    {
+        impl_->trace_id_ = id;
+    }
+
+    template < class NextLayer >
+    auto stream< NextLayer >::trace_id() const -> std::uint64_t
+    {
+        return impl_->trace_id_;
+    }
+
+    template < class NextLayer >
+    auto stream< NextLayer >::recent_frames() const -> flight_recorder const &
+    {
+        return impl_->recorder_;
+    }
+
+    template < class NextLayer >
+    auto stream< NextLayer >::timeline() -> protocol::timeline &
+    {
+        return impl_->timeline_;
+    }
+
+    template < class NextLayer >
+    auto stream< NextLayer >::timeline() const -> protocol::timeline const &
+    {
+        return impl_->timeline_;
+    }
+
+    template < class NextLayer >
+    auto stream< NextLayer >::usage() const -> stream_usage const &
+    {
+        return impl_->usage_;
+    }
+
+    template < class NextLayer >
+    auto stream< NextLayer >::enter_play() -> void
+    {
+        impl_->profile_state_ = packet_profile::state::play;
+    }
+
+    template < class NextLayer >
+    auto stream< NextLayer >::frame_received() const -> std::uint64_t
+    {
+        return impl_->frame_received_;
+    }
+
     template < class NextLayer >
     auto stream< NextLayer >::get_executor() const -> executor_type
     {
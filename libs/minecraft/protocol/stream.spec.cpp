@@ -1,10 +1,13 @@
 #include "minecraft/client/handshake.hpp"
+#include "polyfill/timestamp.hpp"
 #include "stream.hpp"
 
 #include <boost/beast/_experimental/test/handler.hpp>
 #include <boost/beast/_experimental/test/stream.hpp>
 #include <boost/beast/core/buffers_to_string.hpp>
 #include <catch2/catch.hpp>
+#include <cstdio>
+#include <fstream>
 
 
 TEST_CASE("minecraft::stream")
@@ -41,5 +44,77 @@ TEST_CASE("minecraft::stream")
         CHECK(not ec.failed());
         auto frame_body = receiver.current_frame();
         CHECK(boost::beast::buffers_to_string(frame_body) == frame_data);
+        CHECK(receiver.frame_received() != 0);
+        CHECK(receiver.frame_received() <= polyfill::timestamp::now());
+
+        CHECK(sender.usage().frames_out == 1);
+        CHECK(sender.usage().bytes_out == 6);
+        CHECK(receiver.usage().frames_in == 1);
+        CHECK(receiver.usage().bytes_in == 6);
+        CHECK(receiver.usage().bytes_out == 0);
+
+        // frames are kept for post-mortem whether or not the stream is traced
+        CHECK(sender.recent_frames().recorded() == 1);
+        CHECK(receiver.recent_frames().recorded() == 1);
+    }
+
+    SECTION("a traced stream records its frames")
+    {
+        auto &trace = protocol::packet_trace::global();
+        trace.open("stream.spec.trace", 16);
+        sender.trace(1);
+        receiver.trace(2);
+
+        auto frame_data = std::string("Hello");
+        sender.async_write_frame(net::buffer(frame_data), [](error_code, std::size_t) {});
+        receiver.async_read_frame([](error_code, std::size_t) {});
+        boost::beast::test::run(ioc);
+        sender.trace(0);
+        sender.async_write_frame(net::buffer(frame_data), [](error_code, std::size_t) {});
+        boost::beast::test::run(ioc);
+        trace.close();
+
+        auto in     = std::ifstream("stream.spec.trace", std::ios::binary);
+        auto header = protocol::trace_format::file_header();
+        auto tx     = protocol::trace_format::record();
+        auto rx     = protocol::trace_format::record();
+        in.read(reinterpret_cast< char * >(&header), sizeof(header));
+        in.read(reinterpret_cast< char * >(&tx), sizeof(tx));
+        in.read(reinterpret_cast< char * >(&rx), sizeof(rx));
+        CHECK(header.next.load() == 2);
+        CHECK(tx.connection == 1);
+        CHECK(tx.direction == std::uint8_t(protocol::packet_profile::direction::tx));
+        CHECK(tx.packet_id == 'H');
+        CHECK(tx.frame_length == 5);
+        CHECK(rx.connection == 2);
+        CHECK(rx.direction == std::uint8_t(protocol::packet_profile::direction::rx));
+        CHECK(std::string(reinterpret_cast< char const * >(rx.payload), rx.payload_length) == frame_data);
+        std::remove("stream.spec.trace");
+    }
+
+    SECTION("coroutine forms report a disconnect through the error code")
+    {
+        auto frame_data = std::string("Hello");
+        auto received   = std::string();
+        auto threw      = false;
+        net::co_spawn(
+            ioc,
+            [&]() -> net::awaitable< void > {
+                co_await sender.write_frame(net::buffer(frame_data), ec);
+                REQUIRE(not ec.failed());
+                sender.next_layer().close();
+
+                bytes_transferred = co_await receiver.read_frame(ec);
+                REQUIRE(not ec.failed());
+                received = boost::beast::buffers_to_string(receiver.current_frame());
+
+                co_await receiver.read_frame(ec);
+            },
+            [&](std::exception_ptr ep) { threw = bool(ep); });
+        boost::beast::test::run(ioc);
+        CHECK(not threw);
+        CHECK(bytes_transferred == 5);
+        CHECK(received == frame_data);
+        CHECK(ec == net::error::eof);
     }
-}
\ No newline at end of file
+}
@@ -57,6 +57,9 @@ namespace minecraft::protocol
 
         auto decode_frame_length(error_code &ec) -> void;
 
+        /// Record the current frame in the packet_profile
+        auto record_rx_frame(std::size_t compressed_size, std::uint64_t inflate_ns) -> void;
+
         bool compression_enabled() const { return compression_threshold_ >= 0; }
 
         auto set_encryption(shared_secret const &secret) -> void
@@ -1,4 +1,8 @@
+#include "minecraft/parse.hpp"
+#include "minecraft/protocol/stream_metrics.hpp"
 #include "minecraft/report.hpp"
+#include "polyfill/activity.hpp"
+#include "polyfill/timestamp.hpp"
 
 namespace minecraft::protocol
 {
@@ -20,7 +24,11 @@ namespace minecraft::protocol
     auto stream_impl< NextLayer >::async_read_frame(CompletionToken &&token) ->
         typename net::async_result< std::decay_t< CompletionToken >, void(error_code, std::size_t) >::return_type
     {
-        auto op = [this, coro = net::coroutine(), ec_ = error_code()](
+        auto op = [this,
+                   coro             = net::coroutine(),
+                   ec_              = error_code(),
+                   compressed_size_ = std::size_t(),
+                   inflate_ns_      = std::uint64_t()](
                       auto &self, error_code ec = {}, std::size_t /*bytes_transferred*/ = 0) mutable {
 #include <boost/asio/yield.hpp>
             reenter(coro) for (;;)
@@ -72,7 +80,13 @@ namespace minecraft::protocol
                         uncompressed_rx_data_.payload_size  = original_length.value();
                         uncompressed_rx_data_.data_position = 0;
                         uncompressed_rx_data_.payload.resize(uncompressed_rx_data_.payload_size);
-                        ec = inflator_(compressed_rx_data_.get_data(), uncompressed_rx_data_.get_data());
+                        compressed_size_ = compressed_rx_data_.get_data().size();
+                        auto busy        = polyfill::activity("inflate");
+                        auto start       = polyfill::timestamp::now();
+                        ec          = inflator_(compressed_rx_data_.get_data(), uncompressed_rx_data_.get_data());
+                        inflate_ns_ = polyfill::timestamp::to_nanoseconds(polyfill::timestamp::now() - start);
+                        metrics().rx_compressed.inc(compressed_rx_data_.get_data().size());
+                        metrics().rx_uncompressed.inc(uncompressed_rx_data_.payload_size);
                         if (ec.failed())
                         {
                             spdlog::error(FMT_STRING("{}::packet inflation failed: packet_length={} offset={} "
@@ -82,6 +96,14 @@ namespace minecraft::protocol
                                           compressed_rx_data_.data_position,
                                           original_length.value(),
                                           spdlog::to_hex(to_span(current_frame_data_)));
+
+                            // keep the compressed bytes, which is all there is of the frame
+                            auto record = packet_trace::start_record(trace_id_, compressed_rx_data_.get_data());
+                            record.packet_id    = -1;
+                            record.frame_length = std::uint32_t(original_length.value());
+                            packet_trace::finish_record(
+                                record, packet_profile::direction::rx, profile_state_, compressed_size_);
+                            recorder_.record(record);
                             return self.complete(ec, uncompressed_rx_data_.payload.size());
                         }
 
@@ -98,6 +120,8 @@ namespace minecraft::protocol
                                   log_id(),
                                   spdlog::to_hex(to_span(current_frame_data_)));
                 }
+                frame_received_ = last_read_time_;
+                record_rx_frame(compressed_size_ ? compressed_size_ : current_frame_data_.size(), inflate_ns_);
                 return self.complete(ec, current_frame_data_.size());
             }
 #include <boost/asio/unyield.hpp>
@@ -111,6 +135,29 @@ namespace minecraft::protocol
             std::move(op), token, this->next_layer());
     }
 
+    template < class NextLayer >
+    auto stream_impl< NextLayer >::record_rx_frame(std::size_t compressed_size, std::uint64_t inflate_ns) -> void
+    {
+        auto ec        = error_code();
+        auto packet_id = std::int32_t(0);
+        auto first     = static_cast< const char * >(current_frame_data_.data());
+        parse_var(first, first + current_frame_data_.size(), packet_id, ec);
+
+        auto  key     = packet_profile::make_key(packet_profile::direction::rx, profile_state_, packet_id);
+        auto &profile = packet_profile::global();
+        profile.record_frame(key, current_frame_data_.size(), compressed_size, inflate_ns);
+        ++usage_.frames_in;
+        usage_.compression_ns += inflate_ns;
+        if (encryption_)
+            profile.record_cipher(key, std::uint64_t(rx_cipher_ns_per_byte_ * double(compressed_size)));
+
+        auto record = packet_trace::start_record(trace_id_, current_frame_data_);
+        packet_trace::finish_record(record, packet_profile::direction::rx, profile_state_, compressed_size);
+        recorder_.record(record);
+        if (trace_id_)
+            packet_trace::global().write(record);
+    }
+
     template < class NextLayer >
     template < class CompletionToken >
     auto stream_impl< NextLayer >::async_read_more(CompletionToken &&token) ->
@@ -134,11 +181,20 @@ namespace minecraft::protocol
                     }
                     auto buf = net::dynamic_buffer(encryption_->rx_cipher_);
                     buf.shrink(buf.size() - (original_size_ + bytes_transferred));
+                    usage_.bytes_in += bytes_transferred;
                     if (ec)
                         return self.complete(ec, bytes_transferred);
+                    last_read_time_ = polyfill::timestamp::now();
 
-                    encryption_->rx_context_.update(buf.data(0, buf.size()),
-                                                    net::dynamic_buffer(compressed_rx_data_.payload));
+                    metrics().rx_decrypted.inc(buf.size());
+                    {
+                        auto start = polyfill::timestamp::now();
+                        encryption_->rx_context_.update(buf.data(0, buf.size()),
+                                                        net::dynamic_buffer(compressed_rx_data_.payload));
+                        auto ns = polyfill::timestamp::to_nanoseconds(polyfill::timestamp::now() - start);
+                        usage_.cipher_ns += ns;
+                        rx_cipher_ns_per_byte_ = double(ns) / double(buf.size());
+                    }
                     encryption_->rx_cipher_.clear();
                 }
                 else
@@ -152,6 +208,8 @@ namespace minecraft::protocol
                     }
                     auto buf = net::dynamic_buffer(compressed_rx_data_.payload);
                     buf.shrink(buf.size() - (original_size_ + bytes_transferred));
+                    usage_.bytes_in += bytes_transferred;
+                    last_read_time_ = polyfill::timestamp::now();
                 }
 
                 return self.complete(ec, bytes_transferred);
@@ -176,7 +234,14 @@ namespace minecraft::protocol
                 if (encryption_)
                 {
                     assert(encryption_->tx_cipher_.empty());
-                    encryption_->tx_context_.update(plaintext, net::dynamic_buffer(encryption_->tx_cipher_));
+                    {
+                        auto start = polyfill::timestamp::now();
+                        encryption_->tx_context_.update(plaintext, net::dynamic_buffer(encryption_->tx_cipher_));
+                        auto ns = polyfill::timestamp::to_nanoseconds(polyfill::timestamp::now() - start);
+                        usage_.cipher_ns += ns;
+                        packet_profile::global().record_cipher(compose_area_.profile_key(), ns);
+                    }
+                    metrics().tx_encrypted.inc(plaintext.size());
                     yield net::async_write(next_layer(), net::dynamic_buffer(encryption_->tx_cipher_), std::move(self));
                     assert(ec.failed() or encryption_->tx_cipher_.empty());
                 }
@@ -184,6 +249,7 @@ namespace minecraft::protocol
                 {
                     yield net::async_write(next_layer(), plaintext, std::move(self));
                 }
+                usage_.bytes_out += bytes_transferred;
                 return self.complete(ec, bytes_transferred);
             }
 #include <boost/asio/unyield.hpp>
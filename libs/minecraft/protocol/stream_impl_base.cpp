@@ -6,6 +6,22 @@
 
 namespace minecraft::protocol
 {
+    auto stream_impl_base::commit_frame() -> net::const_buffer
+    {
+        // the payload is captured before it is compressed in place
+        auto record = packet_trace::start_record(trace_id_, compose_area_.frame());
+        auto frame  = compose_area_.commit(compression_threshold_, profile_state_);
+        ++usage_.frames_out;
+        usage_.compression_ns += compose_area_.compression_ns();
+
+        packet_trace::finish_record(
+            record, packet_profile::direction::tx, profile_state_, compose_area_.compressed_size());
+        recorder_.record(record);
+        if (trace_id_)
+            packet_trace::global().write(record);
+        return frame;
+    }
+
     std::ostream &operator<<(std::ostream &os, stream_impl_base const &base)
     {
         fmt::print(os,
@@ -6,7 +6,11 @@
 
 #include "minecraft/protocol/compose_area.hpp"
 #include "minecraft/protocol/encryption_state.hpp"
+#include "minecraft/protocol/flight_recorder.hpp"
 #include "minecraft/protocol/frame_data.hpp"
+#include "minecraft/protocol/packet_profile.hpp"
+#include "minecraft/protocol/packet_trace.hpp"
+#include "minecraft/protocol/timeline.hpp"
 #include "minecraft/protocol/version.hpp"
 #include "minecraft/protocol/compression/inflate_impl.hpp"
 
@@ -14,12 +18,29 @@
 
 namespace minecraft::protocol
 {
+    /// The work done by one stream over its life. Times are measured with polyfill::timestamp.
+    struct stream_usage
+    {
+        std::uint64_t bytes_in       = 0;   //! read from the socket
+        std::uint64_t bytes_out      = 0;   //! written to the socket
+        std::uint64_t frames_in      = 0;
+        std::uint64_t frames_out     = 0;
+        std::uint64_t compression_ns = 0;   //! inflate and deflate
+        std::uint64_t cipher_ns      = 0;   //! decryption and encryption
+    };
+
     struct stream_impl_base
     {
+        /// Compose the frame in the compose area and account for it
+        auto commit_frame() -> net::const_buffer;
+
         protocol::version_type protocol_version_ = protocol::version_type::not_set;
 
         int compression_threshold_ = -1;
 
+        // frames are profiled as login packets until the login has succeeded
+        packet_profile::state profile_state_ = packet_profile::state::login;
+
         // has_state if encryption is enabled
         std::optional< encryption_state > encryption_;
 
@@ -33,7 +54,21 @@ namespace minecraft::protocol
         frame_data                compressed_rx_data_;   // data is always read into the compressed buffer
         compression::inflate_impl inflator_;
         frame_data                uncompressed_rx_data_;   // and optionally uncompressed into here
-        net::mutable_buffer       current_frame_data_ = {};
+        net::mutable_buffer       current_frame_data_    = {};
+        std::uint64_t             last_read_time_        = 0;   // polyfill::timestamp of the last read completion
+        std::uint64_t             frame_received_        = 0;   // ... of the read which completed the current frame
+        double                    rx_cipher_ns_per_byte_ = 0;   // of the last decryption, shared among its frames
+
+        stream_usage usage_;
+
+        // frames are recorded in the packet_trace under this id while it is non zero
+        std::uint64_t trace_id_ = 0;
+
+        // the last frames read and written
+        flight_recorder recorder_;
+
+        // the steps of the login, for the timeline_trace
+        protocol::timeline timeline_;
 
         // client parameters / discovered by server
         std::string   hostname;
@@ -0,0 +1,28 @@
+#include "stream_metrics.hpp"
+
+namespace minecraft::protocol
+{
+    auto metrics() -> stream_metrics const &
+    {
+        static auto const m = [] {
+            auto &reg         = polyfill::metrics::registry::global();
+            auto  compression = [&reg](char const *direction, char const *form) {
+                return reg.counter("minecraft_compression_bytes_total",
+                                   "Bytes into and out of frame compression",
+                                   { { "direction", direction }, { "form", form } });
+            };
+            auto cipher = [&reg](char const *direction) {
+                return reg.counter(
+                    "minecraft_cipher_bytes_total", "Bytes encrypted and decrypted", { { "direction", direction } });
+            };
+            return stream_metrics { compression("tx", "uncompressed"),
+                                    compression("tx", "compressed"),
+                                    compression("rx", "compressed"),
+                                    compression("rx", "uncompressed"),
+                                    cipher("tx"),
+                                    cipher("rx") };
+        }();
+        return m;
+    }
+
+}   // namespace minecraft::protocol
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "polyfill/metrics.hpp"
+
+namespace minecraft::protocol
+{
+    /// Work done by all protocol streams in the process, published in polyfill::metrics::registry::global()
+    struct stream_metrics
+    {
+        polyfill::metrics::counter tx_uncompressed;   //! bytes given to the compressor
+        polyfill::metrics::counter tx_compressed;     //! bytes produced by the compressor
+        polyfill::metrics::counter rx_compressed;     //! bytes given to the decompressor
+        polyfill::metrics::counter rx_uncompressed;   //! bytes produced by the decompressor
+        polyfill::metrics::counter tx_encrypted;
+        polyfill::metrics::counter rx_decrypted;
+    };
+
+    auto metrics() -> stream_metrics const &;
+
+}   // namespace minecraft::protocol
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace minecraft::protocol
+{
+    /// Spans of time in the life of one connection, such as the steps of a login, for a timeline written by
+    /// timeline_trace.
+    ///
+    /// A timeline records nothing until it is enabled, so that the login operations may mark their steps
+    /// unconditionally at the cost of a test each. Spans may nest; a span which has not ended when the timeline is
+    /// written is shown as ending then.
+    struct timeline
+    {
+        using span = std::size_t;
+
+        static constexpr span no_span = ~span(0);
+
+        struct entry
+        {
+            char const *  name;       //! a string literal
+            std::uint64_t begin_ns;   //! steady clock
+            std::uint64_t end_ns;     //! 0 while the span is open
+        };
+
+        static auto now() -> std::uint64_t
+        {
+            return std::uint64_t(std::chrono::duration_cast< std::chrono::nanoseconds >(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+        }
+
+        auto enable() -> void
+        {
+            enabled_ = true;
+            entries_.reserve(16);
+        }
+
+        auto enabled() const -> bool { return enabled_; }
+
+        /// Open a span. `name` must outlive the timeline.
+        /// \return the span to pass to end, or no_span if the timeline is not enabled
+        auto begin(char const *name) -> span
+        {
+            if (not enabled_)
+                return no_span;
+            entries_.push_back(entry { name, now(), 0 });
+            return entries_.size() - 1;
+        }
+
+        auto end(span s) -> void
+        {
+            if (s < entries_.size())
+                entries_[s].end_ns = now();
+        }
+
+        auto entries() const -> std::vector< entry > const & { return entries_; }
+
+      private:
+        std::vector< entry > entries_;
+        bool                 enabled_ = false;
+    };
+
+}   // namespace minecraft::protocol
@@ -0,0 +1,152 @@
+#include "minecraft/protocol/timeline_trace.hpp"
+
+#include "minecraft/net.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <fmt/format.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace minecraft::protocol
+{
+    namespace
+    {
+        auto json_escape(std::string_view s) -> std::string
+        {
+            auto result = std::string();
+            result.reserve(s.size());
+            for (auto c : s)
+            {
+                if (c == '"' or c == '\\')
+                    result.append(1, '\\').append(1, c);
+                else if (static_cast< unsigned char >(c) < 0x20)
+                    result += fmt::format("\\u{:04x}", int(c));
+                else
+                    result.append(1, c);
+            }
+            return result;
+        }
+
+        /// Microseconds, as the format requires, to the nanosecond
+        auto micros(std::uint64_t ns) -> std::string { return fmt::format("{}.{:03}", ns / 1000, ns % 1000); }
+    }   // namespace
+
+    auto timeline_trace::global() -> timeline_trace &
+    {
+        static timeline_trace t;
+        return t;
+    }
+
+    timeline_trace::~timeline_trace() { close(); }
+
+    auto timeline_trace::open(std::string const &path, std::uint32_t sample_every, std::string_view process_name)
+        -> void
+    {
+        close();
+        file_ = std::fopen(path.c_str(), "w");
+        if (not file_)
+            throw system_error(error_code(errno, boost::system::system_category()), "timeline_trace: open");
+        path_         = path;
+        pid_          = int(::getpid());
+        sample_every_ = sample_every;
+        connections_  = 0;
+        fmt::print(file_,
+                   R"([{{"name":"process_name","ph":"M","pid":{},"tid":0,"args":{{"name":"{}"}}}})",
+                   pid_,
+                   json_escape(process_name));
+        std::fflush(file_);
+        stopping_ = false;
+        writer_   = std::thread([this] { run_writer(); });
+    }
+
+    auto timeline_trace::close() -> void
+    {
+        if (not file_)
+            return;
+        {
+            auto lock = std::lock_guard(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_one();
+        writer_.join();
+        std::fputs("\n]\n", file_);
+        std::fclose(std::exchange(file_, nullptr));
+    }
+
+    auto timeline_trace::enqueue(std::string text) -> void
+    {
+        {
+            auto lock = std::lock_guard(mutex_);
+            queue_.push_back(std::move(text));
+        }
+        cv_.notify_one();
+    }
+
+    auto timeline_trace::run_writer() -> void
+    {
+        auto batch = std::vector< std::string >();
+        auto lock  = std::unique_lock(mutex_);
+        for (;;)
+        {
+            cv_.wait(lock, [this] { return stopping_ or not queue_.empty(); });
+            if (queue_.empty())
+                return;
+            batch.swap(queue_);
+            lock.unlock();
+            for (auto &text : batch)
+                std::fwrite(text.data(), 1, text.size(), file_);
+            std::fflush(file_);
+            batch.clear();
+            lock.lock();
+        }
+    }
+
+    auto timeline_trace::sample() -> bool { return sample_every_ and connections_++ % sample_every_ == 0; }
+
+    auto timeline_trace::select(std::string_view player, bool on) -> void
+    {
+        if (on)
+            selected_.emplace(player);
+        else if (auto i = selected_.find(player); i != selected_.end())
+            selected_.erase(i);
+    }
+
+    auto timeline_trace::selected(std::string_view player) const -> bool { return selected_.contains(player); }
+
+    auto timeline_trace::write(std::uint64_t                             connection,
+                               std::string_view                          label,
+                               std::initializer_list< timeline const * > timelines) -> void
+    {
+        if (not file_)
+            return;
+
+        auto now     = timeline::now();
+        auto entries = std::vector< timeline::entry >();
+        for (auto *t : timelines)
+            if (t and t->enabled())
+                entries.insert(entries.end(), t->entries().begin(), t->entries().end());
+
+        // by start, and the longer of two spans starting together first, so that the viewer nests them
+        auto end_of = [now](timeline::entry const &e) { return e.end_ns ? e.end_ns : now; };
+        std::sort(entries.begin(), entries.end(), [&](auto const &l, auto const &r) {
+            return l.begin_ns < r.begin_ns or (l.begin_ns == r.begin_ns and end_of(l) > end_of(r));
+        });
+
+        auto text = fmt::format(",\n" R"({{"name":"thread_name","ph":"M","pid":{},"tid":{},"args":{{"name":"{}"}}}})",
+                                pid_,
+                                connection,
+                                json_escape(label));
+        for (auto &e : entries)
+            text += fmt::format(",\n" R"({{"name":"{}","ph":"X","ts":{},"dur":{},"pid":{},"tid":{}{}}})",
+                                json_escape(e.name),
+                                micros(e.begin_ns),
+                                micros(end_of(e) - e.begin_ns),
+                                pid_,
+                                connection,
+                                e.end_ns ? "" : R"(,"args":{"unfinished":true})");
+        enqueue(std::move(text));
+    }
+
+}   // namespace minecraft::protocol
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "minecraft/protocol/timeline.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace minecraft::protocol
+{
+    /// Writes the timelines of sampled connections to a file in the Chrome trace event format, which Perfetto
+    /// (ui.perfetto.dev) and chrome://tracing open. Each connection is shown as a thread of the process, with a
+    /// slice per span.
+    ///
+    /// The file is a JSON array which is closed by close(). A file left unclosed by a crash is still readable,
+    /// since both viewers accept an array without its closing bracket.
+    ///
+    /// Connections are sampled in two ways: one in every `sample_every` connections, and the connections of
+    /// players selected by name. Since the name is not known until the login starts, every connection records
+    /// its timeline while any player is selected, and only those of selected players are written.
+    ///
+    /// Used by the thread which runs the connections, without locking. Events are formatted on that thread and
+    /// written to the file by a thread of its own, so that a slow disk never blocks the event loop.
+    struct timeline_trace
+    {
+        static auto global() -> timeline_trace &;
+
+        timeline_trace(timeline_trace const &) = delete;
+        timeline_trace &operator=(timeline_trace const &) = delete;
+        ~timeline_trace();
+
+        /// Create or truncate `path`, closing any file already open. A `sample_every` of 0 samples only selected
+        /// players. `process_name` labels the process in the viewer.
+        /// \throw system_error
+        auto open(std::string const &path, std::uint32_t sample_every, std::string_view process_name) -> void;
+
+        /// Write out the events queued so far and close the file
+        auto close() -> void;
+
+        auto is_open() const -> bool { return file_ != nullptr; }
+
+        auto path() const -> std::string const & { return path_; }
+
+        /// Decide whether a new connection is one of the one in `sample_every`
+        auto sample() -> bool;
+
+        /// Whether a new connection should record its timeline in case its player is selected
+        auto any_selected() const -> bool { return not selected_.empty(); }
+
+        auto select(std::string_view player, bool on) -> void;
+
+        auto selected(std::string_view player) const -> bool;
+
+        /// Write the spans of the timelines, which are of one connection, as the thread `connection` labelled
+        /// `label`. Timelines which are not enabled are skipped.
+        auto write(std::uint64_t                             connection,
+                   std::string_view                          label,
+                   std::initializer_list< timeline const * > timelines) -> void;
+
+      private:
+        timeline_trace() = default;
+
+        auto enqueue(std::string text) -> void;
+        auto run_writer() -> void;
+
+        std::string                          path_;
+        std::FILE *                          file_         = nullptr;   //! written only by writer_ while it runs
+        int                                  pid_          = 0;
+        std::uint32_t                        sample_every_ = 0;
+        std::uint64_t                        connections_  = 0;
+        std::set< std::string, std::less<> > selected_;
+
+        std::mutex                 mutex_;
+        std::condition_variable    cv_;
+        std::vector< std::string > queue_;   //! formatted events waiting for writer_
+        bool                       stopping_ = false;
+        std::thread                writer_;
+    };
+
+}   // namespace minecraft::protocol
@@ -0,0 +1,59 @@
+#include "minecraft/protocol/timeline_trace.hpp"
+
+#include <catch2/catch.hpp>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+TEST_CASE("minecraft::protocol::timeline_trace")
+{
+    using namespace minecraft::protocol;
+
+    auto  path      = std::string("timeline_trace.spec.json");
+    auto &timelines = timeline_trace::global();
+    timelines.open(path, 2, "spec");
+    REQUIRE(timelines.is_open());
+
+    // one connection in two
+    CHECK(timelines.sample());
+    CHECK(not timelines.sample());
+    CHECK(timelines.sample());
+
+    CHECK(not timelines.any_selected());
+    timelines.select("Notch", true);
+    CHECK(timelines.any_selected());
+    CHECK(timelines.selected("Notch"));
+    CHECK(not timelines.selected("jeb_"));
+    timelines.select("Notch", false);
+    CHECK(not timelines.any_selected());
+
+    auto off = timeline();
+    CHECK(off.begin("ignored") == timeline::no_span);
+    CHECK(off.entries().empty());
+
+    auto t = timeline();
+    t.enable();
+    auto login = t.begin("login");
+    auto step  = t.begin("login_start");
+    t.end(step);
+    t.begin("encryption_response");   // left open, as by a failed login
+    t.end(login);
+    REQUIRE(t.entries().size() == 3);
+    CHECK(t.entries()[0].end_ns >= t.entries()[1].end_ns);
+
+    timelines.write(7, "connection 7 \"quoted\"", { &t, &off, nullptr });
+    timelines.close();
+    CHECK(not timelines.is_open());
+
+    auto in   = std::ifstream(path);
+    auto text = (std::ostringstream() << in.rdbuf()).str();
+    CHECK(text.rfind(R"([{"name":"process_name","ph":"M",)", 0) == 0);
+    CHECK(text.find(R"("tid":7,"args":{"name":"connection 7 \"quoted\""}})") != std::string::npos);
+    CHECK(text.find(R"({"name":"login","ph":"X",)") < text.find(R"({"name":"login_start","ph":"X",)"));
+    CHECK(text.find(R"({"name":"encryption_response","ph":"X",)") != std::string::npos);
+    CHECK(text.find(R"("args":{"unfinished":true})") != std::string::npos);
+    CHECK(text.find("ignored") == std::string::npos);
+    CHECK(text.size() >= 3);
+    CHECK(text.substr(text.size() - 3) == "\n]\n");
+    std::remove(path.c_str());
+}
@@ -0,0 +1,31 @@
+#include "minecraft/server/keep_alive.hpp"
+
+#include "minecraft/encode.hpp"
+#include "minecraft/parse.hpp"
+
+#include <fmt/ostream.h>
+
+namespace minecraft::server
+{
+    std::ostream &operator<<(std::ostream &os, keep_alive const &arg)
+    {
+        fmt::print(os, "[frame {} [keep_alive_id {}]]", wise_enum::to_string(arg.id()), arg.keep_alive_id);
+        return os;
+    }
+
+    const_buffer_iterator
+    parse(const_buffer_iterator first, const_buffer_iterator last, keep_alive &packet, error_code &ec)
+    {
+        using minecraft::parse;
+        first = parse(first, last, packet.keep_alive_id, ec);
+        return first;
+    }
+
+    void compose(keep_alive const &packet, std::vector< char > &target)
+    {
+        auto iter = std::back_inserter(target);
+        iter      = encode(variable_length(packet.id()), iter);
+        encode(packet.keep_alive_id, iter);
+    }
+
+}   // namespace minecraft::server
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "minecraft/net.hpp"
+#include "minecraft/server/play_id.hpp"
+#include "minecraft/types.hpp"
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace minecraft::server
+{
+    /// Sent periodically during play. The client must echo the id back in a serverbound keep alive.
+    struct keep_alive
+    {
+        static auto constexpr id() { return play_id::keep_alive; }
+
+        std::int64_t keep_alive_id = 0;
+
+        friend std::ostream &operator<<(std::ostream &os, keep_alive const &arg);
+    };
+
+    void compose(keep_alive const &packet, std::vector< char > &target);
+
+    const_buffer_iterator
+    parse(const_buffer_iterator first, const_buffer_iterator last, keep_alive &packet, error_code &ec);
+
+}   // namespace minecraft::server
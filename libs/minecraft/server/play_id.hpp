@@ -8,6 +8,7 @@ namespace minecraft::server
                     (chat_message, 0x0f),
                     (spawn_position, 0x4E),
                     (join_game, 0x26),
+                    (keep_alive, 0x21),
                     (player_position_and_look, 0x36));
 
 }
\ No newline at end of file
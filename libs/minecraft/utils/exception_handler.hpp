@@ -3,6 +3,7 @@
 #include "minecraft/net.hpp"
 #include "minecraft/report.hpp"
 #include "polyfill/explain.hpp"
+#include "polyfill/net/disconnect.hpp"
 
 #include <memory>
 #include <spdlog/spdlog.h>
@@ -31,13 +32,23 @@ namespace minecraft::utils
                 if (ec == net::error::operation_aborted)
                     return;
                 spdlog::error("{}::[{}]({})", *self, context, report(ec));
+                if (not polyfill::net::is_disconnect(ec))
+                    log_recent_frames();
             }
             catch (...)
             {
                 spdlog::error("{}::[{}] - exception: {}", *self, context, polyfill::explain());
+                log_recent_frames();
             }
         }
 
+        /// Log the frames which led up to the failure, if Self keeps them (see protocol::flight_recorder)
+        void log_recent_frames() const
+        {
+            if constexpr (requires(Self const &s) { s.recent_frames(); })
+                spdlog::error("{}::[{}] recent frames:\n{}", *self, context, self->recent_frames());
+        }
+
         std::shared_ptr< Self > self;
         std::string             context;
     };
@@ -0,0 +1,87 @@
+#include "logging.hpp"
+
+#include "polyfill/metrics.hpp"
+#include "polyfill/timestamp.hpp"
+
+#include <algorithm>
+#include <spdlog/async.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+
+namespace minecraft::utils
+{
+    namespace
+    {
+        auto suppressed_total() -> polyfill::metrics::counter const &
+        {
+            static auto const c = polyfill::metrics::registry::global().counter(
+                "log_messages_suppressed_total", "Log messages suppressed by rate limits");
+            return c;
+        }
+    }   // namespace
+
+    auto install_logger(logging_config const &config) -> void
+    {
+        auto level  = spdlog::get_level();
+        auto sink   = std::make_shared< spdlog::sinks::stdout_color_sink_mt >();
+        auto logger = std::shared_ptr< spdlog::logger >();
+        if (config.queue_size == 0)
+            logger = std::make_shared< spdlog::logger >("", std::move(sink));
+        else
+        {
+            spdlog::init_thread_pool(config.queue_size, 1);
+            logger = std::make_shared< spdlog::async_logger >(
+                "",
+                std::move(sink),
+                spdlog::thread_pool(),
+                config.drop_when_full ? spdlog::async_overflow_policy::overrun_oldest
+                                      : spdlog::async_overflow_policy::block);
+        }
+        logger->set_level(level);
+        logger->flush_on(spdlog::level::err);
+        spdlog::set_default_logger(std::move(logger));
+
+        // Sampled on the scraping thread. Holds the pool weakly, so that shutdown_logger can destroy it.
+        if (config.queue_size)
+            polyfill::metrics::registry::global().gauge(
+                "log_messages_dropped",
+                "Log messages dropped because the logging queue was full",
+                {},
+                [pool = std::weak_ptr(spdlog::thread_pool())] {
+                    auto p = pool.lock();
+                    return p ? std::int64_t(p->overrun_counter()) : std::int64_t(0);
+                });
+    }
+
+    auto shutdown_logger() -> void
+    {
+        // Anything logged from now on, for example by destructors, is written synchronously. The pool's destructor
+        // waits for the queued messages to be written.
+        install_logger(logging_config { 0 });
+        spdlog::details::registry::instance().set_tp(nullptr);
+    }
+
+    log_limiter::log_limiter(double per_second, std::size_t burst)
+    : per_ns_(per_second / 1e9)
+    , burst_(double(std::max< std::size_t >(burst, 1)))
+    , tokens_(burst_)
+    , last_(polyfill::timestamp::now())
+    {
+    }
+
+    auto log_limiter::admit(std::uint64_t &suppressed) -> bool
+    {
+        auto now = polyfill::timestamp::now();
+        tokens_  = std::min(burst_, tokens_ + double(polyfill::timestamp::to_nanoseconds(now - last_)) * per_ns_);
+        last_    = now;
+        if (tokens_ < 1)
+        {
+            ++suppressed_;
+            suppressed_total().inc();
+            return false;
+        }
+        tokens_ -= 1;
+        suppressed = std::exchange(suppressed_, 0);
+        return true;
+    }
+
+}   // namespace minecraft::utils
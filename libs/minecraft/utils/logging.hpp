@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <spdlog/fmt/ostr.h>
+#include <spdlog/spdlog.h>
+
+namespace minecraft::utils
+{
+    struct logging_config
+    {
+        /// Messages which may wait for the logging thread. 0 logs synchronously on the calling thread.
+        std::size_t queue_size = 8192;
+
+        /// When the queue is full, drop the oldest message rather than wait for the logging thread. Dropped
+        /// messages are counted.
+        bool drop_when_full = true;
+    };
+
+    /// Replace the default logger with one which formats on the calling thread but writes from a thread of its
+    /// own, so that a slow terminal or disk never blocks an event loop. Keeps the current log level.
+    ///
+    /// Call before starting the threads which log, and after forking a worker process. Publishes
+    /// `log_messages_dropped` in the global metrics registry.
+    auto install_logger(logging_config const &config) -> void;
+
+    /// Write out queued messages and stop the logging thread. Messages logged afterwards are written synchronously.
+    auto shutdown_logger() -> void;
+
+    /// Limits how often a message is logged, for example by one connection or at one call site.
+    ///
+    /// A token bucket: `burst` messages may be logged at once, after which the limit is `per_second`. The first
+    /// message logged after some have been suppressed says how many. Not thread safe; a limiter belongs to one
+    /// connection or one event loop. Suppressed messages are counted in `log_messages_suppressed_total`.
+    struct log_limiter
+    {
+        explicit log_limiter(double per_second = 10, std::size_t burst = 20);
+
+        /// Return true if a message may be logged now. `suppressed` is set to the number of messages refused since
+        /// the last one allowed.
+        auto admit(std::uint64_t &suppressed) -> bool;
+
+        template < class Format, class... Args >
+        auto log(spdlog::level::level_enum level, Format const &format, Args const &... args) -> void
+        {
+            // Check the level first, so that a disabled level costs neither a token nor a format
+            if (not spdlog::default_logger_raw()->should_log(level))
+                return;
+            auto suppressed = std::uint64_t();
+            if (not admit(suppressed))
+                return;
+            if (suppressed)
+                spdlog::log(level, "{} ({} similar messages suppressed)", fmt::format(format, args...), suppressed);
+            else
+                spdlog::log(level, format, args...);
+        }
+
+        template < class Format, class... Args >
+        auto info(Format const &format, Args const &... args) -> void
+        {
+            log(spdlog::level::info, format, args...);
+        }
+
+        template < class Format, class... Args >
+        auto warn(Format const &format, Args const &... args) -> void
+        {
+            log(spdlog::level::warn, format, args...);
+        }
+
+        template < class Format, class... Args >
+        auto error(Format const &format, Args const &... args) -> void
+        {
+            log(spdlog::level::err, format, args...);
+        }
+
+      private:
+        double        per_ns_;
+        double        burst_;
+        double        tokens_;
+        std::uint64_t last_;   //! polyfill::timestamp
+        std::uint64_t suppressed_ = 0;
+    };
+
+    /// A log argument which is produced only when the message is formatted, for output which is costly to build,
+    /// such as a dump. A message which is below the log level or refused by a log_limiter costs nothing.
+    template < class Function >
+    struct deferred
+    {
+        Function produce;
+
+        friend auto operator<<(std::ostream &os, deferred const &d) -> std::ostream & { return os << d.produce(); }
+    };
+
+    template < class Function >
+    deferred(Function) -> deferred< Function >;
+
+}   // namespace minecraft::utils
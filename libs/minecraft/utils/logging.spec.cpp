@@ -0,0 +1,64 @@
+#include "minecraft/utils/logging.hpp"
+
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <spdlog/sinks/ostream_sink.h>
+#include <sstream>
+#include <thread>
+
+TEST_CASE("minecraft::utils::log_limiter")
+{
+    using namespace minecraft::utils;
+
+    SECTION("a burst is allowed, then messages are suppressed until the bucket refills")
+    {
+        auto limiter    = log_limiter(1000, 3);
+        auto suppressed = std::uint64_t(99);
+        CHECK(limiter.admit(suppressed));
+        CHECK(suppressed == 0);
+        CHECK(limiter.admit(suppressed));
+        CHECK(limiter.admit(suppressed));
+        CHECK(not limiter.admit(suppressed));
+        CHECK(not limiter.admit(suppressed));
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        CHECK(limiter.admit(suppressed));
+        CHECK(suppressed == 2);
+    }
+
+    SECTION("the first message after suppression says how many were suppressed")
+    {
+        auto os     = std::ostringstream();
+        auto logger = std::make_shared< spdlog::logger >("", std::make_shared< spdlog::sinks::ostream_sink_st >(os));
+        logger->set_pattern("%v");
+        auto previous = spdlog::default_logger();
+        spdlog::set_default_logger(logger);
+
+        auto limiter = log_limiter(0.001, 1);
+        limiter.info(FMT_STRING("hello {}"), 1);
+        limiter.info("hello {}", 2);
+        limiter.info("hello {}", 3);
+        CHECK(os.str() == "hello 1\n");
+
+        // a deferred argument is not produced for a suppressed message
+        auto produced = 0;
+        limiter.info("dump {}", deferred { [&produced] { return ++produced; } });
+        CHECK(produced == 0);
+
+        auto quick = log_limiter(1000, 1);
+        quick.info("first");
+        quick.info("second");
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        quick.info("third");
+        CHECK(os.str() == "hello 1\nfirst\nthird (1 similar messages suppressed)\n");
+
+        // a disabled level does not use up the allowance
+        logger->set_level(spdlog::level::warn);
+        auto fresh = log_limiter(0.001, 1);
+        fresh.info("not logged");
+        fresh.warn("warning");
+        CHECK(os.str() == "hello 1\nfirst\nthird (1 similar messages suppressed)\nwarning\n");
+
+        spdlog::set_default_logger(previous);
+    }
+}
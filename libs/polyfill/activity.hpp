@@ -0,0 +1,42 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#pragma once
+
+#include <atomic>
+
+namespace polyfill
+{
+    /// Names the work the current thread is doing for the life of the object, so that a monitor on another thread
+    /// can say what an event loop was busy with when it stalled. Activities nest; the innermost is reported.
+    ///
+    /// Marking an activity is two relaxed loads and stores of a thread local, so it may be used on the hot path.
+    struct activity
+    {
+        explicit activity(char const *name) noexcept
+        : previous_(slot().load(std::memory_order_relaxed))
+        {
+            slot().store(name, std::memory_order_relaxed);
+        }
+
+        ~activity() { slot().store(previous_, std::memory_order_relaxed); }
+
+        activity(activity const &) = delete;
+        activity &operator=(activity const &) = delete;
+
+        /// The calling thread's current activity, which other threads may read while this thread is running
+        static auto slot() noexcept -> std::atomic< char const * > &
+        {
+            thread_local std::atomic< char const * > current { nullptr };
+            return current;
+        }
+
+      private:
+        char const *previous_;
+    };
+
+}   // namespace polyfill
@@ -0,0 +1,38 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#include "latency_histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace polyfill
+{
+    auto latency_histogram::mean() const -> std::uint64_t
+    {
+        auto n = count();
+        return n ? sum_.load(std::memory_order_relaxed) / n : 0;
+    }
+
+    auto latency_histogram::percentile(double p) const -> std::uint64_t
+    {
+        auto n = count();
+        if (n == 0)
+            return 0;
+
+        auto target = std::max< std::uint64_t >(1, std::uint64_t(std::ceil(std::clamp(p, 0.0, 100.0) / 100.0 * n)));
+        auto seen   = std::uint64_t(0);
+        for (std::size_t bucket = 0; bucket < bucket_count; ++bucket)
+        {
+            seen += counts_[bucket].load(std::memory_order_relaxed);
+            if (seen >= target)
+                return std::min(highest_in(bucket), max());
+        }
+        return max();
+    }
+
+}   // namespace polyfill
@@ -0,0 +1,78 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#pragma once
+
+#include "polyfill/per_thread_store.hpp"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace polyfill
+{
+    /// A histogram of durations in the style of HdrHistogram: each power of two is divided into 32 linear
+    /// sub-buckets, so any value is reported within about 3% of its true value, from 1ns up to about 18 minutes,
+    /// in fixed memory and with constant time recording.
+    ///
+    /// Recording is a bump(), as for polyfill::metrics, so a histogram must be recorded to by one thread at a time.
+    /// It may be read by any thread.
+    struct latency_histogram
+    {
+        static constexpr unsigned      sub_bucket_bits = 5;
+        static constexpr std::uint64_t sub_buckets     = std::uint64_t(1) << sub_bucket_bits;
+        static constexpr unsigned      max_bits        = 40;   //! larger values are recorded as 2^40 - 1
+        static constexpr std::size_t   bucket_count    = (max_bits - sub_bucket_bits + 1) * sub_buckets;
+
+        auto record(std::uint64_t ns) -> void
+        {
+            if (ns >= (std::uint64_t(1) << max_bits))
+                ns = (std::uint64_t(1) << max_bits) - 1;
+            bump(counts_[bucket_of(ns)], 1);
+            bump(count_, 1);
+            bump(sum_, ns);
+            if (ns > max_.load(std::memory_order_relaxed))
+                max_.store(ns, std::memory_order_relaxed);
+        }
+
+        auto count() const -> std::uint64_t { return count_.load(std::memory_order_relaxed); }
+        auto max() const -> std::uint64_t { return max_.load(std::memory_order_relaxed); }
+        auto mean() const -> std::uint64_t;
+
+        /// The smallest recorded value which `p` percent of the values do not exceed, rounded up to the top of its
+        /// bucket. 0 if nothing has been recorded.
+        auto percentile(double p) const -> std::uint64_t;
+
+        static auto bucket_of(std::uint64_t ns) -> std::size_t
+        {
+            auto width = unsigned(std::bit_width(ns));
+            if (width <= sub_bucket_bits)
+                return std::size_t(ns);
+            auto shift = width - sub_bucket_bits - 1;
+            return std::size_t((shift + 1) * sub_buckets + ((ns >> shift) - sub_buckets));
+        }
+
+        /// The largest value which is recorded in `bucket`
+        static auto highest_in(std::size_t bucket) -> std::uint64_t
+        {
+            if (bucket < 2 * sub_buckets)
+                return bucket;
+            auto shift = unsigned(bucket / sub_buckets - 1);
+            auto sub   = bucket % sub_buckets + sub_buckets;
+            return ((sub + 1) << shift) - 1;
+        }
+
+      private:
+        std::array< std::atomic< std::uint64_t >, bucket_count > counts_ {};
+        std::atomic< std::uint64_t >                             count_ { 0 };
+        std::atomic< std::uint64_t >                             sum_ { 0 };
+        std::atomic< std::uint64_t >                             max_ { 0 };
+    };
+
+}   // namespace polyfill
@@ -0,0 +1,118 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#include "polyfill/latency_histogram.hpp"
+#include "polyfill/timestamp.hpp"
+
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+TEST_CASE("polyfill::latency_histogram")
+{
+    using polyfill::latency_histogram;
+
+    auto h = std::make_unique< latency_histogram >();
+
+    SECTION("empty")
+    {
+        CHECK(h->count() == 0);
+        CHECK(h->percentile(50) == 0);
+        CHECK(h->max() == 0);
+    }
+
+    SECTION("buckets cover every value, in order, within the stated precision")
+    {
+        auto last = std::size_t(0);
+        for (std::uint64_t v = 0; v < (std::uint64_t(1) << 20); v += 1 + v / 100)
+        {
+            auto b = latency_histogram::bucket_of(v);
+            REQUIRE(b >= last);
+            REQUIRE(b < latency_histogram::bucket_count);
+            REQUIRE(latency_histogram::highest_in(b) >= v);
+            REQUIRE(double(latency_histogram::highest_in(b) - v) <= 1 + double(v) / latency_histogram::sub_buckets);
+            if (b > 0)
+                REQUIRE(latency_histogram::highest_in(b - 1) < v);
+            last = b;
+        }
+        CHECK(latency_histogram::bucket_of((std::uint64_t(1) << latency_histogram::max_bits) - 1) ==
+              latency_histogram::bucket_count - 1);
+    }
+
+    SECTION("small values are exact")
+    {
+        for (std::uint64_t v = 1; v <= 10; ++v)
+            h->record(v);
+        CHECK(h->count() == 10);
+        CHECK(h->percentile(50) == 5);
+        CHECK(h->percentile(100) == 10);
+        CHECK(h->mean() == 5);
+    }
+
+    SECTION("percentiles of a long tail")
+    {
+        // 1..100000 microseconds, uniformly
+        for (std::uint64_t us = 1; us <= 100'000; ++us)
+            h->record(us * 1000);
+        CHECK(h->max() == 100'000'000);
+        CHECK(h->percentile(50) == Approx(50'000'000).epsilon(0.04));
+        CHECK(h->percentile(99) == Approx(99'000'000).epsilon(0.04));
+        CHECK(h->percentile(99.9) == Approx(99'900'000).epsilon(0.04));
+        CHECK(h->percentile(100) == 100'000'000);
+    }
+
+    SECTION("huge values are clamped")
+    {
+        h->record(~std::uint64_t(0));
+        CHECK(h->max() == (std::uint64_t(1) << latency_histogram::max_bits) - 1);
+    }
+}
+
+TEST_CASE("polyfill::timestamp")
+{
+    using namespace polyfill::timestamp;
+
+    CHECK(parse("tsc") == source::tsc);
+    CHECK_THROWS_AS(parse("sundial"), std::invalid_argument);
+
+    for (auto s : { source::steady, source::coarse, source::tsc })
+    {
+        select(s);
+        auto t0 = now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        auto elapsed = to_nanoseconds(now() - t0);
+        INFO(s);
+        CHECK(elapsed >= 40'000'000);
+        CHECK(elapsed < 1'000'000'000);
+    }
+    select(source::steady);
+}
+
+TEST_CASE("polyfill::latency_histogram recording cost", "[.][benchmark]")
+{
+    constexpr int iterations = 50'000'000;
+
+    auto h = std::make_unique< polyfill::latency_histogram >();
+    for (auto s : { polyfill::timestamp::source::steady,
+                    polyfill::timestamp::source::coarse,
+                    polyfill::timestamp::source::tsc })
+    {
+        polyfill::timestamp::select(s);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i)
+        {
+            auto t0 = polyfill::timestamp::now();
+            h->record(polyfill::timestamp::to_nanoseconds(polyfill::timestamp::now() - t0));
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << s << " : " << std::chrono::duration< double, std::nano >(elapsed).count() / iterations
+                  << " ns per two timestamps and a record\n";
+    }
+    polyfill::timestamp::select(polyfill::timestamp::source::steady);
+}
@@ -0,0 +1,219 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace polyfill::metrics
+{
+    namespace detail
+    {
+        auto store() -> cell_store &
+        {
+            static cell_store s;
+            return s;
+        }
+
+        auto value(std::size_t index) -> std::int64_t
+        {
+            auto result = std::int64_t(0);
+            store().for_each(
+                [&](thread_cells const &block) { result += block.values[index].load(std::memory_order_relaxed); });
+            return result;
+        }
+
+        auto allocate_cells(std::size_t n) -> std::size_t
+        {
+            static std::mutex  mutex;
+            static std::size_t allocated = 0;
+
+            auto lock = std::lock_guard(mutex);
+            if (allocated + n > max_cells)
+                throw std::length_error("polyfill::metrics: too many metrics");
+            return std::exchange(allocated, allocated + n);
+        }
+    }   // namespace detail
+
+    namespace
+    {
+        auto write_escaped(std::ostream &os, std::string_view s, bool quote) -> void
+        {
+            for (auto c : s)
+            {
+                if (c == '\\')
+                    os << "\\\\";
+                else if (c == '\n')
+                    os << "\\n";
+                else if (c == '"' and quote)
+                    os << "\\\"";
+                else
+                    os << c;
+            }
+        }
+
+        /// Write `{a="1",b="2"}`, with an extra label such as the bucket bound if given
+        auto write_labels(std::ostream &os, labels_type const &labels, std::string_view extra_name = {},
+                          std::string_view extra_value = {}) -> void
+        {
+            if (labels.empty() and extra_name.empty())
+                return;
+            auto sep = '{';
+            auto one = [&](std::string_view name, std::string_view value) {
+                os << std::exchange(sep, ',') << name << "=\"";
+                write_escaped(os, value, true);
+                os << '"';
+            };
+            for (auto &[name, value] : labels)
+                one(name, value);
+            if (not extra_name.empty())
+                one(extra_name, extra_value);
+            os << '}';
+        }
+    }   // namespace
+
+    auto registry::kind_name(kind k) -> char const *
+    {
+        switch (k)
+        {
+        case kind::counter:
+            return "counter";
+        case kind::gauge:
+            return "gauge";
+        case kind::histogram:
+            return "histogram";
+        }
+        return "untyped";
+    }
+
+    auto histogram::buckets() const -> std::vector< std::int64_t >
+    {
+        auto result = std::vector< std::int64_t >(bounds_->size() + 1);
+        for (std::size_t i = 0; i < result.size(); ++i)
+            result[i] = detail::value(first_ + i);
+        return result;
+    }
+
+    auto registry::global() -> registry &
+    {
+        static registry r;
+        return r;
+    }
+
+    auto registry::find_or_add(std::string_view name, std::string_view help, kind type, labels_type &labels)
+        -> std::pair< series &, bool >
+    {
+        auto fam = std::find_if(families_.begin(), families_.end(), [&](family const &f) { return f.name == name; });
+        if (fam == families_.end())
+            fam = families_.insert(families_.end(), family { std::string(name), std::string(help), type, {} });
+        else if (fam->type != type)
+            throw std::logic_error("polyfill::metrics: " + std::string(name) + " registered with another type");
+
+        auto member = std::find_if(
+            fam->members.begin(), fam->members.end(), [&](series const &s) { return s.labels == labels; });
+        if (member != fam->members.end())
+            return { *member, false };
+        fam->members.push_back(series { std::move(labels), 0, {}, {} });
+        return { fam->members.back(), true };
+    }
+
+    auto registry::counter(std::string_view name, std::string_view help, labels_type labels) -> metrics::counter
+    {
+        auto lock           = std::lock_guard(mutex_);
+        auto [member, made] = find_or_add(name, help, kind::counter, labels);
+        if (made)
+            member.first = detail::allocate_cells(1);
+        return metrics::counter { member.first };
+    }
+
+    auto registry::gauge(std::string_view name, std::string_view help, labels_type labels) -> metrics::gauge
+    {
+        auto lock           = std::lock_guard(mutex_);
+        auto [member, made] = find_or_add(name, help, kind::gauge, labels);
+        if (made)
+            member.first = detail::allocate_cells(1);
+        else if (member.sample)
+            throw std::logic_error("polyfill::metrics: " + std::string(name) + " is a sampled gauge");
+        return metrics::gauge { member.first };
+    }
+
+    auto registry::gauge(std::string_view                name,
+                         std::string_view                help,
+                         labels_type                     labels,
+                         std::function< std::int64_t() > sample) -> void
+    {
+        auto lock = std::lock_guard(mutex_);
+        find_or_add(name, help, kind::gauge, labels).first.sample = std::move(sample);
+    }
+
+    auto registry::histogram(std::string_view            name,
+                             std::string_view            help,
+                             std::vector< std::int64_t > bounds,
+                             labels_type                 labels) -> metrics::histogram
+    {
+        std::sort(bounds.begin(), bounds.end());
+        auto lock           = std::lock_guard(mutex_);
+        auto [member, made] = find_or_add(name, help, kind::histogram, labels);
+        if (made)
+        {
+            member.bounds = std::make_shared< std::vector< std::int64_t > const >(std::move(bounds));
+            member.first  = detail::allocate_cells(member.bounds->size() + 2);
+        }
+        return metrics::histogram { member.first, member.bounds };
+    }
+
+    auto registry::write_text(std::ostream &os) const -> void
+    {
+        auto lock = std::lock_guard(mutex_);
+        for (auto &fam : families_)
+        {
+            os << "# HELP " << fam.name << ' ';
+            write_escaped(os, fam.help, false);
+            os << "\n# TYPE " << fam.name << ' ' << kind_name(fam.type) << '\n';
+
+            for (auto &member : fam.members)
+            {
+                if (fam.type != kind::histogram)
+                {
+                    os << fam.name;
+                    write_labels(os, member.labels);
+                    os << ' ' << (member.sample ? member.sample() : detail::value(member.first)) << '\n';
+                    continue;
+                }
+
+                auto h          = metrics::histogram { member.first, member.bounds };
+                auto buckets    = h.buckets();
+                auto cumulative = std::int64_t(0);
+                for (std::size_t i = 0; i < buckets.size(); ++i)
+                {
+                    cumulative += buckets[i];
+                    os << fam.name << "_bucket";
+                    write_labels(
+                        os, member.labels, "le", i < member.bounds->size() ? std::to_string((*member.bounds)[i]) : "+Inf");
+                    os << ' ' << cumulative << '\n';
+                }
+                os << fam.name << "_sum";
+                write_labels(os, member.labels);
+                os << ' ' << h.sum() << '\n';
+                os << fam.name << "_count";
+                write_labels(os, member.labels);
+                os << ' ' << cumulative << '\n';
+            }
+        }
+    }
+
+    auto registry::text() const -> std::string
+    {
+        auto os = std::ostringstream();
+        write_text(os);
+        return os.str();
+    }
+
+}   // namespace polyfill::metrics
@@ -0,0 +1,174 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#pragma once
+
+#include "polyfill/per_thread_store.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/// @file metrics.hpp
+///
+/// Counters, gauges and histograms for the hot path.
+///
+/// Every thread which updates a metric has its own block of cells, so an update is a plain add to memory no other
+/// thread writes, with no locked instruction and no cache line contention. The cells of all threads are summed
+/// when the metrics are read. The values of threads which have exited are retained.
+///
+namespace polyfill::metrics
+{
+    namespace detail
+    {
+        /// The most cells which may be registered in a process. A counter or gauge uses one cell, a histogram one per
+        /// bucket plus one.
+        constexpr std::size_t max_cells = 4096;
+
+        struct alignas(64) thread_cells
+        {
+            std::array< std::atomic< std::int64_t >, max_cells > values {};
+        };
+
+        using cell_store = per_thread_store< thread_cells >;
+
+        auto store() -> cell_store &;
+
+        inline auto local_cells() -> thread_cells &
+        {
+            if (auto cells = cell_store::this_thread())
+                return *cells;
+            return store().local();
+        }
+
+        inline auto add(std::size_t index, std::int64_t n) -> void { bump(local_cells().values[index], n); }
+
+        /// The sum of a cell over all threads
+        auto value(std::size_t index) -> std::int64_t;
+
+        /// Reserve `n` consecutive cells
+        auto allocate_cells(std::size_t n) -> std::size_t;
+    }   // namespace detail
+
+    using labels_type = std::vector< std::pair< std::string, std::string > >;
+
+    struct counter
+    {
+        auto inc(std::int64_t n = 1) const -> void { detail::add(index_, n); }
+
+        auto value() const -> std::int64_t { return detail::value(index_); }
+
+        std::size_t index_;
+    };
+
+    /// A gauge which is moved up and down, for example by the number of connections in a state. The value is the
+    /// sum of the movements made by all threads.
+    struct gauge
+    {
+        auto inc(std::int64_t n = 1) const -> void { detail::add(index_, n); }
+        auto dec(std::int64_t n = 1) const -> void { detail::add(index_, -n); }
+
+        auto value() const -> std::int64_t { return detail::value(index_); }
+
+        std::size_t index_;
+    };
+
+    /// Observations counted in buckets with fixed upper bounds
+    struct histogram
+    {
+        auto observe(std::int64_t v) const -> void
+        {
+            auto bucket = std::size_t(0);
+            while (bucket < bounds_->size() and v > (*bounds_)[bucket])
+                ++bucket;
+            detail::add(first_ + bucket, 1);
+            detail::add(first_ + bounds_->size() + 1, v);
+        }
+
+        auto bounds() const -> std::vector< std::int64_t > const & { return *bounds_; }
+
+        /// Observations in each bucket (not cumulative). The last bucket has no upper bound.
+        auto buckets() const -> std::vector< std::int64_t >;
+
+        auto sum() const -> std::int64_t { return detail::value(first_ + bounds_->size() + 1); }
+
+        std::size_t                                          first_;
+        std::shared_ptr< std::vector< std::int64_t > const > bounds_;
+    };
+
+    /// A set of named metrics which can be written in the Prometheus text format.
+    ///
+    /// Metrics are registered once, typically at startup, and the returned handles copied freely. Registering the
+    /// same name and labels again returns the same metric. Registration and reading are thread safe.
+    struct registry
+    {
+        /// The registry used by the libraries and served by the applications
+        static auto global() -> registry &;
+
+        auto counter(std::string_view name, std::string_view help, labels_type labels = {}) -> metrics::counter;
+
+        auto gauge(std::string_view name, std::string_view help, labels_type labels = {}) -> metrics::gauge;
+
+        /// A gauge whose value is sampled when the metrics are read, for example the length of a queue. `sample` is
+        /// called by the thread reading the metrics, with the registry locked.
+        auto gauge(std::string_view name,
+                   std::string_view help,
+                   labels_type      labels,
+                   std::function< std::int64_t() > sample) -> void;
+
+        auto histogram(std::string_view            name,
+                       std::string_view            help,
+                       std::vector< std::int64_t > bounds,
+                       labels_type                 labels = {}) -> metrics::histogram;
+
+        /// Write every metric in the Prometheus text exposition format, version 0.0.4
+        auto write_text(std::ostream &os) const -> void;
+
+        auto text() const -> std::string;
+
+      private:
+        enum class kind
+        {
+            counter,
+            gauge,
+            histogram
+        };
+
+        struct series
+        {
+            labels_type                                          labels;
+            std::size_t                                          first = 0;
+            std::shared_ptr< std::vector< std::int64_t > const > bounds;
+            std::function< std::int64_t() >                      sample;
+        };
+
+        struct family
+        {
+            std::string           name;
+            std::string           help;
+            kind                  type;
+            std::vector< series > members;
+        };
+
+        static auto kind_name(kind k) -> char const *;
+
+        auto find_or_add(std::string_view name, std::string_view help, kind type, labels_type &labels)
+            -> std::pair< series &, bool >;
+
+        mutable std::mutex    mutex_;
+        std::vector< family > families_;
+    };
+
+}   // namespace polyfill::metrics
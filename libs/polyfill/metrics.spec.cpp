@@ -0,0 +1,117 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#include "polyfill/metrics.hpp"
+
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+TEST_CASE("polyfill::metrics")
+{
+    using namespace polyfill::metrics;
+
+    auto reg = registry();
+
+    SECTION("counters are summed over threads, including threads which have exited")
+    {
+        auto c = reg.counter("test_events_total", "Events");
+        c.inc();
+        auto threads = std::vector< std::thread >();
+        for (int t = 0; t < 4; ++t)
+            threads.emplace_back([c] {
+                for (int i = 0; i < 1000; ++i)
+                    c.inc();
+            });
+        for (auto &t : threads)
+            t.join();
+        CHECK(c.value() == 4001);
+
+        // a new thread may reuse the cells of an exited one without losing its counts
+        std::thread([c] { c.inc(10); }).join();
+        CHECK(c.value() == 4011);
+    }
+
+    SECTION("registering again returns the same metric")
+    {
+        auto a = reg.counter("test_requests_total", "Requests", { { "method", "get" } });
+        auto b = reg.counter("test_requests_total", "Requests", { { "method", "get" } });
+        auto c = reg.counter("test_requests_total", "Requests", { { "method", "put" } });
+        a.inc();
+        b.inc();
+        c.inc(5);
+        CHECK(a.value() == 2);
+        CHECK(c.value() == 5);
+        CHECK_THROWS_AS(reg.gauge("test_requests_total", "Requests"), std::logic_error);
+    }
+
+    SECTION("Prometheus text format")
+    {
+        reg.counter("test_bytes_total", "Bytes \"moved\"", { { "direction", "in" } }).inc(42);
+        auto g = reg.gauge("test_connections", "Open connections", { { "state", "play" } });
+        g.inc(3);
+        g.dec();
+        reg.gauge("test_queue_depth", "Waiting", {}, [] { return std::int64_t(7); });
+        auto h = reg.histogram("test_latency_us", "Latency", { 100, 10 });
+        for (auto v : { 5, 10, 50, 500 })
+            h.observe(v);
+
+        CHECK(reg.text() == "# HELP test_bytes_total Bytes \"moved\"\n"
+                            "# TYPE test_bytes_total counter\n"
+                            "test_bytes_total{direction=\"in\"} 42\n"
+                            "# HELP test_connections Open connections\n"
+                            "# TYPE test_connections gauge\n"
+                            "test_connections{state=\"play\"} 2\n"
+                            "# HELP test_queue_depth Waiting\n"
+                            "# TYPE test_queue_depth gauge\n"
+                            "test_queue_depth 7\n"
+                            "# HELP test_latency_us Latency\n"
+                            "# TYPE test_latency_us histogram\n"
+                            "test_latency_us_bucket{le=\"10\"} 2\n"
+                            "test_latency_us_bucket{le=\"100\"} 3\n"
+                            "test_latency_us_bucket{le=\"+Inf\"} 4\n"
+                            "test_latency_us_sum 565\n"
+                            "test_latency_us_count 4\n");
+    }
+}
+
+TEST_CASE("polyfill::metrics increment cost", "[.][benchmark]")
+{
+    constexpr int iterations = 50'000'000;
+    constexpr int threads    = 2;
+
+    auto reg = polyfill::metrics::registry();
+    auto c   = reg.counter("bench_total", "Benchmark");
+
+    auto time = [](char const *what, auto &&body) {
+        auto start = std::chrono::steady_clock::now();
+        auto ts    = std::vector< std::thread >();
+        for (int t = 0; t < threads; ++t)
+            ts.emplace_back(body);
+        for (auto &t : ts)
+            t.join();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << what << " : "
+                  << std::chrono::duration< double, std::nano >(elapsed).count() / (double(iterations) * threads)
+                  << " ns per increment\n";
+    };
+
+    time("per-thread counter   ", [c] {
+        for (int i = 0; i < iterations; ++i)
+            c.inc();
+    });
+
+    auto shared = std::atomic< std::int64_t >(0);
+    time("shared atomic counter", [&shared] {
+        for (int i = 0; i < iterations; ++i)
+            shared.fetch_add(1, std::memory_order_relaxed);
+    });
+
+    CHECK(c.value() == shared.load());
+}
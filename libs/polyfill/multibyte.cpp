@@ -57,4 +57,12 @@ namespace polyfill
         return result;
     }
 
+    void convert(std::string const &source, std::u16string &target)
+    {
+        target.clear();
+        auto first = source.data();
+        auto last  = first + source.size();
+        utf8::utf8to16(first, last, back_inserter(target));
+    }
+
 }   // namespace polyfill
\ No newline at end of file
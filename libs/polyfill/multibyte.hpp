@@ -21,4 +21,9 @@ namespace polyfill
     void append(std::string const &source, std::u8string &target);
 
     std::u8string to_utf8(std::string const& from);
+
+    //
+    // From UTF8 to UTF16
+    //
+    void convert(std::string const &source, std::u16string &target);
 }   // namespace polyfill
\ No newline at end of file
@@ -0,0 +1,235 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#pragma once
+#include "polyfill/net.hpp"
+#include "polyfill/net/detail/channel_ops.hpp"
+#include "polyfill/net/detail/mpsc_ring.hpp"
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+namespace polyfill::net
+{
+    /// A bounded channel carrying messages from any number of threads to a consumer running on one executor.
+    ///
+    /// Messages are held in a lock-free ring. Producers call try_send, which never blocks, or async_send, which
+    /// waits for space when the ring is full. The consumer waits with async_wait and then drains the channel with
+    /// try_receive. However many messages arrive while the consumer is busy or waiting, it is woken by a single
+    /// post to its executor.
+    ///
+    /// Typical consumer:
+    /// @code
+    /// for (;;)
+    /// {
+    ///     co_await channel.async_wait(net::use_awaitable);   // throws eof once closed and drained
+    ///     while (auto msg = channel.try_receive())
+    ///         handle(*msg);
+    /// }
+    /// @endcode
+    ///
+    /// Messages from one producer are received in the order sent, provided the producer does not send again
+    /// while one of its async_sends is outstanding.
+    /// The channel must outlive all outstanding operations.
+    template < class T, class Executor = net::io_context::executor_type >
+    struct async_channel
+    {
+        using value_type    = T;
+        using executor_type = Executor;
+
+        /// @param exec The consumer's executor. Wait completions are delivered here.
+        /// @param capacity Number of messages which may be queued. Rounded up to a power of two.
+        async_channel(executor_type exec, std::size_t capacity)
+        : exec_(std::move(exec))
+        , ring_(capacity)
+        {
+        }
+
+        async_channel(async_channel const &) = delete;
+        async_channel &operator=(async_channel const &) = delete;
+
+        auto get_executor() const -> executor_type { return exec_; }
+
+        auto capacity() const -> std::size_t { return ring_.capacity(); }
+
+        /// Queue a message without waiting. May be called from any thread.
+        /// @return false if the channel is full or closed, in which case `value` has not been moved from.
+        auto try_send(T &&value) -> bool
+        {
+            if (closed_.load(std::memory_order_relaxed) or not ring_.try_push(value))
+                return false;
+            wake_consumer();
+            return true;
+        }
+
+        /// Queue a message, waiting for space if the channel is full. May be called from any thread.
+        /// Completes with net::error::operation_aborted if the channel is closed before the message is queued.
+        /// @tparam CompletionToken A completion token whose handler is compatible with void(error_code)
+        template < class CompletionToken >
+        auto async_send(T value, CompletionToken &&token)
+        {
+            return net::async_compose< CompletionToken, void(error_code) >(
+                detail::channel_send_op< async_channel, T > { this, std::move(value) }, token);
+        }
+
+        /// Take the oldest queued message. Consumer only.
+        auto try_receive() -> std::optional< T >
+        {
+            auto result = ring_.try_pop();
+            refill();
+            if (not result)
+                result = ring_.try_pop();
+            return result;
+        }
+
+        /// Wait until there is at least one message to receive. Consumer only; one wait at a time.
+        /// Completes with net::error::eof once the channel has been closed and drained.
+        /// @tparam CompletionToken A completion token whose handler is compatible with void(error_code)
+        template < class CompletionToken >
+        auto async_wait(CompletionToken &&token)
+        {
+            return net::async_compose< CompletionToken, void(error_code) >(
+                detail::channel_wait_op< async_channel > { this }, token, exec_);
+        }
+
+        /// Refuse further messages. Messages already queued may still be received. Outstanding sends which
+        /// are waiting for space are completed with net::error::operation_aborted. May be called from any thread.
+        auto close() -> void
+        {
+            auto aborted = std::deque< std::unique_ptr< detail::channel_send_waiter_base< T > > >();
+            {
+                auto lock = std::lock_guard(mutex_);
+                closed_.store(true, std::memory_order_relaxed);
+                aborted.swap(senders_);
+                senders_waiting_.store(0, std::memory_order_relaxed);
+            }
+            for (auto &sender : aborted)
+                sender->post(error::operation_aborted);
+            wake_consumer();
+        }
+
+      private:
+        template < class, class >
+        friend struct detail::channel_send_op;
+        template < class >
+        friend struct detail::channel_wait_op;
+
+        enum consumer_state : int
+        {
+            idle,
+            waiting,
+            notified
+        };
+
+        template < class Self >
+        void start_wait(Self &&self)
+        {
+            assert(consumer_state_.load(std::memory_order_relaxed) == idle);
+            waiter_ = std::make_unique< detail::channel_waiter< std::decay_t< Self > > >(std::move(self));
+
+            if (ready())
+            {
+                consumer_state_.store(notified, std::memory_order_relaxed);
+                waiter_->post(error_code());
+                return;
+            }
+
+            // Publish the wait, then look again in case a producer queued a message before it could see us
+            consumer_state_.store(waiting, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (ready())
+                notify_waiter();
+        }
+
+        auto end_wait() -> error_code
+        {
+            consumer_state_.store(idle, std::memory_order_relaxed);
+            if (closed_.load(std::memory_order_acquire) and ring_.empty() and
+                senders_waiting_.load(std::memory_order_acquire) == 0)
+                return error::eof;
+            return error_code();
+        }
+
+        template < class Self >
+        void start_send(T value, Self &&self)
+        {
+            using waiter_type = detail::channel_send_waiter< T, std::decay_t< Self > >;
+
+            auto lock = std::unique_lock(mutex_);
+            if (closed_.load(std::memory_order_relaxed))
+            {
+                lock.unlock();
+                net::post(boost::beast::bind_front_handler(std::move(self), error_code(error::operation_aborted)));
+                return;
+            }
+            if (senders_.empty() and ring_.try_push(value))
+            {
+                lock.unlock();
+                wake_consumer();
+                net::post(boost::beast::bind_front_handler(std::move(self), error_code()));
+                return;
+            }
+            senders_.push_back(std::make_unique< waiter_type >(std::move(value), std::move(self)));
+            senders_waiting_.fetch_add(1, std::memory_order_seq_cst);
+            lock.unlock();
+            wake_consumer();
+        }
+
+        /// Move messages from waiting senders into space freed by the consumer
+        auto refill() -> void
+        {
+            if (senders_waiting_.load(std::memory_order_acquire) == 0)
+                return;
+
+            auto lock = std::lock_guard(mutex_);
+            while (not senders_.empty() and ring_.try_push(senders_.front()->value))
+            {
+                senders_.front()->post(error_code());
+                senders_.pop_front();
+                senders_waiting_.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+
+        auto ready() const -> bool
+        {
+            return not ring_.empty() or senders_waiting_.load(std::memory_order_acquire) != 0 or
+                   closed_.load(std::memory_order_acquire);
+        }
+
+        /// Called by producers after queueing. Only the first producer to find the consumer waiting posts to it.
+        auto wake_consumer() -> void
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (consumer_state_.load(std::memory_order_relaxed) == waiting)
+                notify_waiter();
+        }
+
+        auto notify_waiter() -> void
+        {
+            auto expected = int(waiting);
+            if (consumer_state_.compare_exchange_strong(expected, notified, std::memory_order_acq_rel))
+                waiter_->post(error_code());
+        }
+
+        executor_type          exec_;
+        detail::mpsc_ring< T > ring_;
+
+        // consumer wait
+        std::atomic< int >                              consumer_state_ { idle };
+        std::unique_ptr< detail::channel_waiter_base > waiter_;
+
+        // slow path: senders waiting for space
+        std::mutex                                                        mutex_;
+        std::deque< std::unique_ptr< detail::channel_send_waiter_base< T > > > senders_;
+        std::atomic< std::size_t >                                        senders_waiting_ { 0 };
+        std::atomic< bool >                                               closed_ { false };
+    };
+
+}   // namespace polyfill::net
@@ -0,0 +1,229 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#include "polyfill/net/async_channel.hpp"
+
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("polyfill::net::async_channel")
+{
+    using namespace polyfill;
+
+    auto ioc  = net::io_context();
+    auto chan = net::async_channel< std::string >(ioc.get_executor(), 3);
+    REQUIRE(chan.capacity() == 4);
+
+    SECTION("try_send refuses when full and leaves the value intact")
+    {
+        for (auto s : { "a", "b", "c", "d" })
+            CHECK(chan.try_send(std::string(s)));
+        auto extra = std::string("e");
+        CHECK(not chan.try_send(std::move(extra)));
+        CHECK(extra == "e");
+
+        for (auto s : { "a", "b", "c", "d" })
+        {
+            auto msg = chan.try_receive();
+            REQUIRE(msg.has_value());
+            CHECK(*msg == s);
+        }
+        CHECK(not chan.try_receive().has_value());
+    }
+
+    SECTION("a burst of messages wakes the consumer once")
+    {
+        int  wakeups = 0;
+        auto ec      = error_code();
+        chan.async_wait([&](error_code ec_) {
+            ++wakeups;
+            ec = ec_;
+        });
+        ioc.poll();
+        CHECK(wakeups == 0);
+
+        CHECK(chan.try_send("x"));
+        CHECK(chan.try_send("y"));
+        CHECK(chan.try_send("z"));
+        ioc.poll();
+        CHECK(wakeups == 1);
+        CHECK(not ec.failed());
+
+        auto received = std::string();
+        while (auto msg = chan.try_receive())
+            received += *msg;
+        CHECK(received == "xyz");
+    }
+
+    SECTION("async_send waits for space")
+    {
+        auto completed = std::vector< std::string >();
+        for (auto s : { "1", "2", "3", "4", "5", "6" })
+            chan.async_send(s, net::bind_executor(ioc, [&completed, s](error_code ec) {
+                                CHECK(not ec.failed());
+                                completed.push_back(s);
+                            }));
+        ioc.poll();
+        CHECK(completed.size() == 4);
+
+        auto received = std::string();
+        while (auto msg = chan.try_receive())
+            received += *msg;
+        ioc.restart();
+        ioc.poll();
+        CHECK(received == "123456");
+        CHECK(completed.size() == 6);
+    }
+
+    SECTION("close fails waiting senders and ends the consumer once drained")
+    {
+        for (auto s : { "a", "b", "c", "d" })
+            CHECK(chan.try_send(std::string(s)));
+        auto send_ec = error_code();
+        chan.async_send("e", net::bind_executor(ioc, [&](error_code ec) { send_ec = ec; }));
+        chan.close();
+        CHECK(not chan.try_send("f"));
+
+        auto             received = std::string();
+        std::exception_ptr failure;
+        net::co_spawn(
+            ioc,
+            [&]() -> net::awaitable< void > {
+                for (;;)
+                {
+                    co_await chan.async_wait(net::use_awaitable);
+                    while (auto msg = chan.try_receive())
+                        received += *msg;
+                }
+            },
+            [&](std::exception_ptr ep) { failure = ep; });
+        ioc.run();
+        CHECK(send_ec == net::error::operation_aborted);
+        CHECK(received == "abcd");
+        REQUIRE(failure);
+        try
+        {
+            std::rethrow_exception(failure);
+        }
+        catch (system_error &se)
+        {
+            CHECK(se.code() == net::error::eof);
+        }
+    }
+
+    SECTION("messages from several threads all arrive in per-producer order")
+    {
+        constexpr int producers = 4;
+        constexpr int per       = 20'000;
+
+        auto big      = net::async_channel< std::pair< int, int > >(ioc.get_executor(), 64);
+        auto last     = std::vector< int >(producers, -1);
+        auto count    = 0;
+        auto in_order = true;
+
+        net::co_spawn(
+            ioc,
+            [&]() -> net::awaitable< void > {
+                while (count < producers * per)
+                {
+                    co_await big.async_wait(net::use_awaitable);
+                    while (auto msg = big.try_receive())
+                    {
+                        in_order = in_order and msg->second == last[msg->first] + 1;
+                        last[msg->first] = msg->second;
+                        ++count;
+                    }
+                }
+            },
+            net::detached);
+
+        auto threads = std::vector< std::thread >();
+        for (int p = 0; p < producers; ++p)
+            threads.emplace_back([&big, p] {
+                for (int i = 0; i < per; ++i)
+                    while (not big.try_send({ p, i }))
+                        std::this_thread::yield();
+            });
+        ioc.run();
+        for (auto &t : threads)
+            t.join();
+
+        CHECK(count == producers * per);
+        CHECK(in_order);
+    }
+}
+
+TEST_CASE("polyfill::net::async_channel throughput", "[.][benchmark]")
+{
+    using namespace polyfill;
+
+    auto run = [](int producers, int per, bool async_producers) {
+        auto ioc     = net::io_context(1);
+        auto chan    = net::async_channel< std::uint64_t >(ioc.get_executor(), 1024);
+        auto count   = 0;
+        auto wakeups = 0;
+
+        net::co_spawn(
+            ioc,
+            [&]() -> net::awaitable< void > {
+                while (count < producers * per)
+                {
+                    co_await chan.async_wait(net::use_awaitable);
+                    ++wakeups;
+                    while (chan.try_receive())
+                        ++count;
+                }
+            },
+            net::detached);
+
+        // each producer runs its own io_context, as an io shard would
+        auto shards  = std::vector< std::unique_ptr< net::io_context > >();
+        auto threads = std::vector< std::thread >();
+        auto start   = std::chrono::steady_clock::now();
+        for (int p = 0; p < producers; ++p)
+        {
+            auto &shard = *shards.emplace_back(std::make_unique< net::io_context >(1));
+            if (async_producers)
+                net::co_spawn(
+                    shard,
+                    [&chan, per]() -> net::awaitable< void > {
+                        for (std::uint64_t i = 0; i < std::uint64_t(per); ++i)
+                            if (not chan.try_send(std::uint64_t(i)))
+                                co_await chan.async_send(i, net::use_awaitable);
+                    },
+                    net::detached);
+            else
+                net::post(shard, [&chan, per] {
+                    for (std::uint64_t i = 0; i < std::uint64_t(per); ++i)
+                        while (not chan.try_send(std::uint64_t(i)))
+                            std::this_thread::yield();
+                });
+            threads.emplace_back([&shard] { shard.run(); });
+        }
+        ioc.run();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        for (auto &t : threads)
+            t.join();
+
+        CHECK(count == producers * per);
+        auto secs = std::chrono::duration< double >(elapsed).count();
+        std::cout << producers << " producer(s), " << (async_producers ? "async_send" : "try_send  ") << " : "
+                  << (double(count) / secs / 1e6) << " M msg/s, " << double(count) / wakeups
+                  << " msgs per wakeup\n";
+    };
+
+    constexpr int messages = 2'000'000;
+    for (int producers : { 1, 2, 4 })
+    {
+        run(producers, messages / producers, false);
+        run(producers, messages / producers, true);
+    }
+}
@@ -0,0 +1,115 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#pragma once
+#include "polyfill/net.hpp"
+
+#include <boost/beast/core/bind_handler.hpp>
+#include <cassert>
+#include <optional>
+#include <utility>
+
+namespace polyfill::net::detail
+{
+    /// A type-erased suspended operation which is resumed by posting it to its own executor
+    struct channel_waiter_base
+    {
+        virtual ~channel_waiter_base() = default;
+
+        virtual void post(error_code ec) = 0;
+    };
+
+    template < class Self >
+    struct channel_waiter : channel_waiter_base
+    {
+        explicit channel_waiter(Self &&self)
+        : self_(std::move(self))
+        {
+        }
+
+        void post(error_code ec) override
+        {
+            // the waiter may be destroyed as soon as the operation is posted
+            assert(self_.has_value());
+            auto self = std::move(*self_);
+            self_.reset();
+            net::post(boost::beast::bind_front_handler(std::move(self), ec));
+        }
+
+        std::optional< Self > self_;
+    };
+
+    /// A sender waiting for space in the channel, together with the value it is sending
+    template < class T >
+    struct channel_send_waiter_base : channel_waiter_base
+    {
+        explicit channel_send_waiter_base(T &&value)
+        : value(std::move(value))
+        {
+        }
+
+        T value;
+    };
+
+    template < class T, class Self >
+    struct channel_send_waiter : channel_send_waiter_base< T >
+    {
+        channel_send_waiter(T &&value, Self &&self)
+        : channel_send_waiter_base< T >(std::move(value))
+        , self_(std::move(self))
+        {
+        }
+
+        void post(error_code ec) override
+        {
+            assert(self_.has_value());
+            auto self = std::move(*self_);
+            self_.reset();
+            net::post(boost::beast::bind_front_handler(std::move(self), ec));
+        }
+
+        std::optional< Self > self_;
+    };
+
+    template < class Channel >
+    struct channel_wait_op
+    {
+        template < class Self >
+        void operator()(Self &self)
+        {
+            channel_->start_wait(std::move(self));
+        }
+
+        template < class Self >
+        void operator()(Self &self, error_code)
+        {
+            self.complete(channel_->end_wait());
+        }
+
+        Channel *channel_;
+    };
+
+    template < class Channel, class T >
+    struct channel_send_op
+    {
+        template < class Self >
+        void operator()(Self &self)
+        {
+            channel_->start_send(std::move(*value_), std::move(self));
+        }
+
+        template < class Self >
+        void operator()(Self &self, error_code ec)
+        {
+            self.complete(ec);
+        }
+
+        Channel *           channel_;
+        std::optional< T > value_;
+    };
+
+}   // namespace polyfill::net::detail
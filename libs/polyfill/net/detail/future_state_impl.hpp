@@ -7,104 +7,143 @@
 
 #pragma once
 #include "polyfill/net.hpp"
+#include "polyfill/net/detail/future_invoker.hpp"
 
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <new>
 #include <optional>
-#include <variant>
+#include <type_traits>
 
 namespace polyfill::net::detail
 {
-    /// A signal type indicating that the future does not yet have state
-    struct future_pending
-    {
-    };
-
-    /// A signal type that indicates that the future state has completed the promise by invoking the future's handler
-    /// with either an error or a value
-    struct future_completed
-    {
-    };
-
+    /// The shared state between a promise and its future.
+    ///
+    /// The promise side stores a value or error and the future side stores an invoker. Each side writes its own
+    /// data and then attempts to move the state out of `pending`. Whichever side loses that race has observed the
+    /// other side's data (acquire) and completes the future by notifying the invoker:
+    ///
+    ///     pending --set_value/set_error--> ready   --set_invoker--> completed
+    ///     pending --set_invoker----------> waiting --set_value/set_error--> completed
+    ///                                          waiting --cancel_wait--> completed (result discarded)
+    ///
+    /// The invoker is constructed in storage inside the state. Handlers too large for that storage fall back to
+    /// the heap.
     template < class T >
     struct future_state_impl
     {
         using optional_value = std::optional< T >;
-        using variant_type   = std::variant< future_pending, error_code, optional_value, future_completed >;
 
-        explicit future_state_impl()
-        : invoker_()
-        , var_()
-        , mutex_()
+        /// Size of the inline invoker storage. Large enough for a composed wait operation with a coroutine or
+        /// simple lambda handler.
+        static constexpr std::size_t inline_invoker_size = 128;
+
+        enum class state : unsigned char
         {
-        }
+            pending,     //! neither side has arrived
+            ready,       //! the promise has stored a value or error
+            waiting,     //! the future has stored an invoker
+            completed,   //! the invoker has been notified
+        };
+
+        future_state_impl() = default;
+
+        future_state_impl(future_state_impl const &) = delete;
+        future_state_impl &operator=(future_state_impl const &) = delete;
+
+        ~future_state_impl() { destroy_invoker(); }
 
         void set_value(T val)
         {
-            auto lock = std::unique_lock(mutex_);
-            assert(std::holds_alternative< future_pending >(var_));
-            if (invoker_)
-            {
-                auto pinvoker = std::move(invoker_);
-                var_          = future_completed();
-                lock.unlock();
-                pinvoker->notify_value(optional_value(std::move(val)));
-            }
-            else
-                var_ = optional_value(std::move(val));
+            value_.emplace(std::move(val));
+            publish_result();
         }
 
         void set_error(error_code ec)
         {
-            auto lock = std::unique_lock(mutex_);
-            assert(std::holds_alternative< future_pending >(var_));
-            if (invoker_)
-            {
-                auto pinvoker = std::move(invoker_);
-                var_          = future_completed();
-                lock.unlock();
-                pinvoker->notify_error(ec);
-            }
-            else
-                var_ = ec;
+            error_ = ec;
+            publish_result();
         }
 
-        void set_invoker(std::unique_ptr< detail::future_invoker_base< T > > pinvoker)
+        template < class Handler >
+        void set_invoker(Handler &&handler)
         {
-            auto lock = std::unique_lock(mutex_);
+            using invoker_type = future_invoker< T, std::decay_t< Handler > >;
             assert(not invoker_);
 
-            if (std::holds_alternative< future_pending >(var_))
-            {
-                invoker_ = std::move(pinvoker);
-                return;
-            }
-            else if (std::holds_alternative< error_code >(var_))
-            {
-                auto ec = std::get< error_code >(var_);
-                var_    = future_completed();
-                lock.unlock();
-                pinvoker->notify_error(ec);
+            if constexpr (sizeof(invoker_type) <= inline_invoker_size and
+                          alignof(invoker_type) <= alignof(std::max_align_t))
+                invoker_ = new (&invoker_storage_) invoker_type(std::forward< Handler >(handler));
+            else
+                invoker_ = new invoker_type(std::forward< Handler >(handler));
+
+            auto expected = state::pending;
+            if (state_.compare_exchange_strong(
+                    expected, state::waiting, std::memory_order_acq_rel, std::memory_order_acquire))
                 return;
-            }
-            else if (std::holds_alternative< optional_value >(var_))
-            {
-                auto val = std::move(std::get< optional_value >(var_));
-                var_     = future_completed();
-                lock.unlock();
-                assert(val.has_value());
-                pinvoker->notify_value(std::move(val));
+
+            assert(expected == state::ready && "future waited on more than once");
+            state_.store(state::completed, std::memory_order_relaxed);
+            complete();
+        }
+
+        /// Complete an outstanding wait with operation_aborted. A result subsequently provided by the promise is
+        /// discarded. Has no effect if no wait is outstanding.
+        void cancel_wait()
+        {
+            auto expected = state::waiting;
+            if (not state_.compare_exchange_strong(
+                    expected, state::completed, std::memory_order_acq_rel, std::memory_order_acquire))
                 return;
-            }
-            else if (std::holds_alternative< future_completed >(var_))
-            {
-                assert(!"promise invoked more than once");
-            }
-            assert(!"serious logic error");
+
+            invoker_->notify_error(error::operation_aborted);
+            destroy_invoker();
         }
 
       private:
-        std::unique_ptr< detail::future_invoker_base< T > > invoker_;
-        variant_type                                        var_;
-        std::mutex                                          mutex_;
+        void publish_result()
+        {
+            auto expected = state::pending;
+            if (state_.compare_exchange_strong(
+                    expected, state::ready, std::memory_order_acq_rel, std::memory_order_acquire))
+                return;
+
+            assert(expected != state::ready && "promise invoked more than once");
+
+            // the wait may be cancelled concurrently, in which case the result is discarded
+            if (expected == state::waiting and
+                state_.compare_exchange_strong(
+                    expected, state::completed, std::memory_order_acq_rel, std::memory_order_acquire))
+                complete();
+        }
+
+        /// Called by whichever side completed the state. Both the result and the invoker are visible.
+        void complete()
+        {
+            if (value_.has_value())
+                invoker_->notify_value(std::move(value_));
+            else
+                invoker_->notify_error(error_);
+            destroy_invoker();
+        }
+
+        void destroy_invoker()
+        {
+            if (not invoker_)
+                return;
+            if (static_cast< void * >(invoker_) == static_cast< void * >(&invoker_storage_))
+                invoker_->~future_invoker_base();
+            else
+                delete invoker_;
+            invoker_ = nullptr;
+        }
+
+        std::atomic< state >                                                       state_ { state::pending };
+        optional_value                                                             value_;
+        error_code                                                                 error_;
+        future_invoker_base< T > *                                                 invoker_ = nullptr;
+        std::aligned_storage_t< inline_invoker_size, alignof(std::max_align_t) > invoker_storage_;
     };
 
 }   // namespace polyfill::net::detail
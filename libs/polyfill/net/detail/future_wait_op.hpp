@@ -21,7 +21,7 @@ namespace polyfill::net::detail
         void operator()(Self &self)
         {
             // initial operation
-            shared_state_->set_invoker(std::make_unique< future_invoker< T, Self > >(std::move(self)));
+            shared_state_->set_invoker(std::move(self));
         }
 
         template < class Self >
@@ -0,0 +1,120 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+
+namespace polyfill::net::detail
+{
+    /// A bounded lock-free queue with any number of producers and one consumer.
+    ///
+    /// Each cell carries a sequence number which tells producers and the consumer whose turn it is to use the
+    /// cell (after Dmitry Vyukov's bounded MPMC queue). Since there is only one consumer, the head index is a plain
+    /// member and popping needs no read-modify-write.
+    template < class T >
+    struct mpsc_ring
+    {
+        /// \param capacity is rounded up to a power of two
+        explicit mpsc_ring(std::size_t capacity)
+        : mask_(round_up(capacity) - 1)
+        , cells_(new cell[mask_ + 1])
+        {
+            for (std::size_t i = 0; i <= mask_; ++i)
+                cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        mpsc_ring(mpsc_ring const &) = delete;
+        mpsc_ring &operator=(mpsc_ring const &) = delete;
+
+        ~mpsc_ring()
+        {
+            while (try_pop())
+                ;
+        }
+
+        /// Attempt to enqueue a value. May be called from any thread.
+        /// \return false if the ring is full, in which case `value` has not been moved from.
+        auto try_push(T &value) -> bool
+        {
+            auto pos = tail_.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                auto &c    = cells_[pos & mask_];
+                auto  seq  = c.sequence.load(std::memory_order_acquire);
+                auto  diff = std::intptr_t(seq) - std::intptr_t(pos);
+                if (diff == 0)
+                {
+                    if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        new (&c.storage) T(std::move(value));
+                        c.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0)
+                    return false;
+                else
+                    pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+
+        /// Dequeue the oldest value. Consumer only.
+        auto try_pop() -> std::optional< T >
+        {
+            auto &c = cells_[head_ & mask_];
+            if (c.sequence.load(std::memory_order_acquire) != head_ + 1)
+                return std::nullopt;
+
+            auto p      = std::launder(reinterpret_cast< T * >(&c.storage));
+            auto result = std::optional< T >(std::move(*p));
+            p->~T();
+            c.sequence.store(head_ + mask_ + 1, std::memory_order_release);
+            ++head_;
+            return result;
+        }
+
+        /// True if there is nothing for the consumer to pop. Consumer only; a concurrent push may complete at any
+        /// moment.
+        auto empty() const -> bool
+        {
+            return cells_[head_ & mask_].sequence.load(std::memory_order_acquire) != head_ + 1;
+        }
+
+        auto capacity() const -> std::size_t { return mask_ + 1; }
+
+      private:
+        static auto round_up(std::size_t n) -> std::size_t
+        {
+            std::size_t result = 1;
+            while (result < n)
+                result <<= 1;
+            return result;
+        }
+
+        struct cell
+        {
+            std::atomic< std::size_t >                          sequence;
+            std::aligned_storage_t< sizeof(T), alignof(T) > storage;
+        };
+
+        std::size_t               mask_;
+        std::unique_ptr< cell[] > cells_;
+
+        // producers and the consumer work on different cache lines
+        alignas(64) std::atomic< std::size_t > tail_ { 0 };
+        alignas(64) std::size_t head_ = 0;
+    };
+
+}   // namespace polyfill::net::detail
@@ -0,0 +1,222 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#pragma once
+#include "polyfill/net.hpp"
+#include "polyfill/net/future.hpp"
+
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace polyfill::net
+{
+    template < class T >
+    struct cancellable_op;
+
+    template < class T, class Executor >
+    auto cancellable(future< T, Executor > f) -> cancellable_op< T >;
+}   // namespace polyfill::net
+
+namespace polyfill::net::detail
+{
+    using when_executor_type = typename awaitable< void >::executor_type;
+
+    // ------ operand normalisation ------
+
+    template < class T >
+    auto as_cancellable(cancellable_op< T > op) -> cancellable_op< T >
+    {
+        return op;
+    }
+
+    template < class T >
+    auto as_cancellable(awaitable< T > op) -> cancellable_op< T >
+    {
+        return { std::move(op), {} };
+    }
+
+    template < class T, class Executor >
+    auto as_cancellable(future< T, Executor > f) -> cancellable_op< T >
+    {
+        return cancellable(std::move(f));
+    }
+
+    /// Operations returning void are represented by std::monostate in a combined result
+    template < class T >
+    using monostate_if_void_t = std::conditional_t< std::is_void_v< T >, std::monostate, T >;
+
+    template < class Arg >
+    using when_value_t = typename decltype(as_cancellable(std::declval< Arg >()))::value_type;
+
+    template < class Arg >
+    using when_result_t = monostate_if_void_t< when_value_t< Arg > >;
+
+    // ------ shared state ------
+
+    /// State shared by the children of one when_all or when_any. Only touched on the awaiting coroutine's
+    /// executor.
+    template < class Results >
+    struct when_state
+    {
+        when_state(when_executor_type exec, std::vector< std::function< void() > > cancels)
+        : done(exec)
+        , cancels(std::move(cancels))
+        , remaining(this->cancels.size())
+        {
+        }
+
+        /// Record the outcome of the first child to settle the combinator and cancel the others.
+        /// \return true if this child settled it
+        auto settle(std::size_t index) -> bool
+        {
+            if (settled)
+                return false;
+            settled = true;
+            for (std::size_t i = 0; i < cancels.size(); ++i)
+                if (i != index and cancels[i])
+                    cancels[i]();
+            return true;
+        }
+
+        auto fail(std::size_t index, std::exception_ptr ep) -> void
+        {
+            if (settle(index))
+                error = ep;
+        }
+
+        auto child_done() -> void
+        {
+            if (--remaining == 0)
+                done.set_value(std::monostate());
+        }
+
+        promise< std::monostate, when_executor_type > done;
+        std::vector< std::function< void() > >        cancels;
+        std::size_t                                   remaining;
+        bool                                          settled = false;
+        std::exception_ptr                            error;
+        Results                                       results;
+    };
+
+    template < class State, class T, class OnValue >
+    auto spawn_child(when_executor_type exec,
+                     std::shared_ptr< State > state,
+                     std::size_t              index,
+                     awaitable< T >           op,
+                     OnValue                  on_value) -> void
+    {
+        co_spawn(
+            exec,
+            [state, index, op = std::move(op), on_value]() mutable -> awaitable< void > {
+                try
+                {
+                    if constexpr (std::is_void_v< T >)
+                    {
+                        co_await std::move(op);
+                        on_value(std::monostate());
+                    }
+                    else
+                        on_value(co_await std::move(op));
+                }
+                catch (...)
+                {
+                    state->fail(index, std::current_exception());
+                }
+                state->child_done();
+            },
+            detached);
+    }
+
+    template < std::size_t... Is, class... Ts >
+    auto when_all_impl(std::index_sequence< Is... >, cancellable_op< Ts >... ops)
+        -> awaitable< std::tuple< monostate_if_void_t< Ts >... > >
+    {
+        using state_type = when_state< std::tuple< std::optional< monostate_if_void_t< Ts > >... > >;
+
+        auto exec  = co_await this_coro::executor;
+        auto state = std::make_shared< state_type >(exec, std::vector< std::function< void() > > { ops.cancel... });
+        auto done  = state->done.get_future();
+
+        (spawn_child(exec,
+                     state,
+                     Is,
+                     std::move(ops.op),
+                     [state](auto &&value) { std::get< Is >(state->results).emplace(std::move(value)); }),
+         ...);
+
+        co_await done.async_wait(use_awaitable);
+        if (state->error)
+            std::rethrow_exception(state->error);
+        co_return std::tuple< monostate_if_void_t< Ts >... >(std::move(*std::get< Is >(state->results))...);
+    }
+
+    template < std::size_t... Is, class... Ts >
+    auto when_any_impl(std::index_sequence< Is... >, cancellable_op< Ts >... ops)
+        -> awaitable< std::variant< monostate_if_void_t< Ts >... > >
+    {
+        using variant_type = std::variant< monostate_if_void_t< Ts >... >;
+        using state_type   = when_state< std::optional< variant_type > >;
+
+        auto exec  = co_await this_coro::executor;
+        auto state = std::make_shared< state_type >(exec, std::vector< std::function< void() > > { ops.cancel... });
+        auto done  = state->done.get_future();
+
+        (spawn_child(exec,
+                     state,
+                     Is,
+                     std::move(ops.op),
+                     [state](auto &&value) {
+                         if (state->settle(Is))
+                             state->results.emplace(std::in_place_index< Is >, std::move(value));
+                     }),
+         ...);
+
+        co_await done.async_wait(use_awaitable);
+        if (state->error)
+            std::rethrow_exception(state->error);
+        co_return std::move(*state->results);
+    }
+
+    /// Shared between an operation wrapped by with_timeout and its cancel function
+    struct timeout_control
+    {
+        using timer_type =
+            basic_waitable_timer< std::chrono::steady_clock, wait_traits< std::chrono::steady_clock >, when_executor_type >;
+
+        auto cancel_op() -> void
+        {
+            if (cancel_inner)
+                cancel_inner();
+        }
+
+        auto cancel() -> void
+        {
+            cancelled = true;
+            cancel_op();
+            if (timer)
+                timer->cancel();
+        }
+
+        std::function< void() >     cancel_inner;
+        std::optional< timer_type > timer;
+        bool                        cancelled = false;
+    };
+
+    template < class T >
+    auto run_with_timeout(awaitable< T >                      op,
+                          std::shared_ptr< timeout_control >  ctl,
+                          std::chrono::steady_clock::duration limit) -> awaitable< T >;
+
+}   // namespace polyfill::net::detail
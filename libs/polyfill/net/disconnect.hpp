@@ -0,0 +1,23 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#pragma once
+
+#include "polyfill/net.hpp"
+
+namespace polyfill::net
+{
+    /// Return true if the error is one that ends a connection in the normal course of events: the peer closed or
+    /// reset the connection, or the operation was cancelled by our own shutdown.
+    inline auto is_disconnect(error_code const &ec) -> bool
+    {
+        return ec == net::error::eof or ec == net::error::connection_reset or ec == net::error::connection_aborted or
+               ec == net::error::broken_pipe or ec == net::error::operation_aborted or
+               ec == net::error::not_connected or ec == net::error::bad_descriptor;
+    }
+
+}   // namespace polyfill::net
@@ -0,0 +1,130 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#include "polyfill/net.hpp"
+
+#include <array>
+#include <boost/asio/local/connect_pair.hpp>
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <iostream>
+
+namespace
+{
+    using namespace polyfill;
+
+    /// The shape of the relay's forwarding loop: read some data from one socket and write it to another. The client
+    /// side writes a message and waits for it to come back, so each round is four asynchronous operations.
+    template < class Executor >
+    struct echo_rig
+    {
+        using socket_type = net::basic_stream_socket< net::local::stream_protocol, Executor >;
+
+        echo_rig(Executor exec, std::size_t rounds)
+        : client_(exec)
+        , server_(exec)
+        , rounds_(rounds)
+        {
+            net::local::connect_pair(client_, server_);
+        }
+
+        void start()
+        {
+            client_write();
+            server_read();
+        }
+
+        void client_write()
+        {
+            net::async_write(client_, net::buffer(client_buf_), [this](error_code ec, std::size_t) {
+                if (not ec.failed())
+                    client_read();
+            });
+        }
+
+        void client_read()
+        {
+            net::async_read(client_, net::buffer(client_buf_), [this](error_code ec, std::size_t) {
+                if (not ec.failed() and ++done_ < rounds_)
+                    client_write();
+                else
+                    server_.close();
+            });
+        }
+
+        void server_read()
+        {
+            server_.async_read_some(net::buffer(server_buf_), [this](error_code ec, std::size_t n) {
+                if (not ec.failed())
+                    server_write(n);
+            });
+        }
+
+        void server_write(std::size_t n)
+        {
+            net::async_write(server_, net::buffer(server_buf_.data(), n), [this](error_code ec, std::size_t) {
+                if (not ec.failed())
+                    server_read();
+            });
+        }
+
+        socket_type              client_, server_;
+        std::array< char, 64 >   client_buf_ {}, server_buf_ {};
+        std::size_t              rounds_;
+        std::size_t              done_ = 0;
+    };
+
+    template < class Executor >
+    auto time_echo(net::io_context &ioc, Executor exec, std::size_t rounds) -> double
+    {
+        auto rig   = echo_rig< Executor >(exec, rounds);
+        auto start = std::chrono::steady_clock::now();
+        rig.start();
+        ioc.run();
+        ioc.restart();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        CHECK(rig.done_ == rounds);
+        return std::chrono::duration< double, std::nano >(elapsed).count() / double(rounds * 4);
+    }
+
+    template < class Executor >
+    auto time_post(net::io_context &ioc, Executor exec, std::size_t count) -> double
+    {
+        std::size_t calls = 0;
+        auto        start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < count; ++i)
+            net::post(exec, [&calls] { ++calls; });
+        ioc.run();
+        ioc.restart();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        CHECK(calls == count);
+        return std::chrono::duration< double, std::nano >(elapsed).count() / double(count);
+    }
+}   // namespace
+
+TEST_CASE("polyfill::net executor overhead", "[.][benchmark]")
+{
+    auto ioc      = net::io_context(1);
+    auto concrete = ioc.get_executor();
+    auto erased   = net::executor(concrete);
+
+    constexpr std::size_t rounds = 200'000;
+    constexpr std::size_t posts  = 2'000'000;
+
+    // warm up
+    time_echo(ioc, concrete, rounds / 10);
+
+    auto echo_concrete = time_echo(ioc, concrete, rounds);
+    auto echo_erased   = time_echo(ioc, erased, rounds);
+    auto post_concrete = time_post(ioc, concrete, posts);
+    auto post_erased   = time_post(ioc, erased, posts);
+
+    std::cout << "socket op, io_context::executor_type : " << echo_concrete << " ns\n"
+              << "socket op, net::executor             : " << echo_erased << " ns\n"
+              << "post, io_context::executor_type      : " << post_concrete << " ns\n"
+              << "post, net::executor                  : " << post_erased << " ns\n";
+}
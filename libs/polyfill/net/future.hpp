@@ -11,15 +11,15 @@
 
 namespace polyfill::net
 {
-    template < class T>
+    template < class T, class Executor = net::io_context::executor_type >
     struct promise;
 
-    template < class T>
+    template < class T, class Executor = net::io_context::executor_type >
     struct future
     {
         using impl_class    = detail::future_state_impl< T >;
         using impl_type     = std::shared_ptr< impl_class >;
-        using executor_type = net::executor;
+        using executor_type = Executor;
 
 
         /// @brief Asynchronously wait for fulfilment of the associated promise.
@@ -36,10 +36,16 @@ namespace polyfill::net
 
         auto operator()() -> awaitable< T>;
 
+        /// @brief Cancel an outstanding async_wait, which completes with net::error::operation_aborted.
+        ///
+        /// Any value or error subsequently provided by the promise is discarded, and the future may not be waited
+        /// on again. Has no effect if no wait is outstanding. May be called from any thread.
+        auto cancel() -> void;
+
         auto get_executor() const -> executor_type { return exec_; }
 
       private:
-        friend promise< T >;
+        friend promise< T, Executor >;
 
         future(impl_type impl, executor_type exec);
 
@@ -47,12 +53,14 @@ namespace polyfill::net
         executor_type exec_;
     };
 
-    template < class T>
+    /// @tparam Executor The executor type of the promise and its futures. Defaults to the concrete io_context
+    /// executor so that completions are not dispatched through a polymorphic executor.
+    template < class T, class Executor >
     struct promise
     {
         using impl_class    = detail::future_state_impl< T >;
         using impl_type     = std::shared_ptr< impl_class >;
-        using executor_type = net::executor;
+        using executor_type = Executor;
 
         promise(executor_type const& exec);
 
@@ -66,9 +74,9 @@ namespace polyfill::net
 
         void set_error(error_code ec);
 
-        future< T > get_future();
+        future< T, Executor > get_future();
 
-        future< T > get_future(net::executor fe);
+        future< T, Executor > get_future(executor_type fe);
 
         auto get_executor() const -> executor_type;
 
@@ -1,52 +1,60 @@
 namespace polyfill::net
 {
-    template < class T >
-    future< T >::future(impl_type impl, executor_type exec)
+    template < class T, class Executor >
+    future< T, Executor >::future(impl_type impl, executor_type exec)
     : impl_(std::move(impl))
     , exec_(std::move(exec))
     {
     }
 
-    template < class T >
+    template < class T, class Executor >
     template < class CompletionHandler >
-    auto future< T >::async_wait(CompletionHandler &&token)
+    auto future< T, Executor >::async_wait(CompletionHandler &&token)
     {
         return net::async_compose< CompletionHandler, void(error_code, std::optional< T >) >(
             detail::future_wait_op< T > { impl_ }, token, *this);
     }
 
-    template < class T >
-    auto future< T >::operator()() -> awaitable< T >
+    template < class T, class Executor >
+    auto future< T, Executor >::operator()() -> awaitable< T >
     {
         auto ot = co_await async_wait(net::use_awaitable);
         co_return std::move(*ot);
     }
 
+    template < class T, class Executor >
+    auto future< T, Executor >::cancel() -> void
+    {
+        impl_->cancel_wait();
+    }
+
     // ------ promise ------
 
-    template < class T >
-    promise< T >::promise(executor_type const &exec)
+    template < class T, class Executor >
+    promise< T, Executor >::promise(executor_type const &exec)
     : impl_(std::make_shared< detail::future_state_impl< T > >())
     , exec_(exec)
     {
     }
 
-    template < class T >
-    promise< T >::promise(promise &&other) noexcept
+    template < class T, class Executor >
+    promise< T, Executor >::promise(promise &&other) noexcept
     : impl_(std::move(other.impl_))
+    , exec_(other.exec_)
     {
     }
 
-    template < class T >
-    auto promise< T >::operator=(promise &&other) noexcept -> promise &
+    template < class T, class Executor >
+    auto promise< T, Executor >::operator=(promise &&other) noexcept -> promise &
     {
         destroy();
         impl_ = std::move(other.impl_);
+        exec_ = other.exec_;
         return *this;
     }
 
-    template < class T >
-    promise< T >::~promise() noexcept
+    template < class T, class Executor >
+    promise< T, Executor >::~promise() noexcept
     {
         try
         {
@@ -58,35 +66,38 @@ namespace polyfill::net
         }
     }
 
-    template < class T >
-    auto promise< T >::set_value(T val) -> void
+    template < class T, class Executor >
+    auto promise< T, Executor >::set_value(T val) -> void
     {
         impl_->set_value(std::move(val));
         impl_.reset();
     }
 
-    template < class T >
-    auto promise< T >::set_error(error_code ec) -> void
+    template < class T, class Executor >
+    auto promise< T, Executor >::set_error(error_code ec) -> void
     {
         impl_->set_error(std::move(ec));
         impl_.reset();
     }
 
-    template < class T >
-    auto promise< T >::get_future() -> future<T>{ return future< T >(impl_, get_executor()); }
+    template < class T, class Executor >
+    auto promise< T, Executor >::get_future() -> future< T, Executor >
+    {
+        return future< T, Executor >(impl_, get_executor());
+    }
 
-    template < class T >
-    auto promise< T >::get_future(net::executor fe) -> future<T>
+    template < class T, class Executor >
+    auto promise< T, Executor >::get_future(executor_type fe) -> future< T, Executor >
     {
-        return future< T >(impl_, fe);
+        return future< T, Executor >(impl_, fe);
     }
 
-    template < class T >
-    auto promise< T >::get_executor() const -> executor_type { return exec_; }
+    template < class T, class Executor >
+    auto promise< T, Executor >::get_executor() const -> executor_type { return exec_; }
 
 
-    template < class T >
-    auto promise< T >::destroy() -> void
+    template < class T, class Executor >
+    auto promise< T, Executor >::destroy() -> void
     {
         if (impl_)
         {
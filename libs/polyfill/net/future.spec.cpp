@@ -80,6 +80,21 @@ TEST_CASE("polyfill::net::future")
         ioc.run();
     }
 
+    SECTION("cancelled wait discards the value")
+    {
+        bool called = false;
+        f.async_wait([&called](polyfill::error_code ec, std::optional< std::string > s) {
+            CHECK(ec.message() == "Operation canceled");
+            CHECK(not s.has_value());
+            called = true;
+        });
+
+        f.cancel();
+        p.set_value("Hello");
+        ioc.run();
+        CHECK(called);
+    }
+
     SECTION("broken promise after wait")
     {
         f.async_wait([](polyfill::error_code ec, std::optional< std::string > s) {
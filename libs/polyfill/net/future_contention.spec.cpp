@@ -0,0 +1,98 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#include "polyfill/net/future.hpp"
+
+#include <atomic>
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using namespace polyfill;
+
+    /// Hand `count` values from `producers` threads to waiters on one io_context thread. The waits are initiated
+    /// while the producers run, so set_value and async_wait race on the same state.
+    auto time_handoff(std::size_t count, std::size_t producers) -> double
+    {
+        auto ioc  = net::io_context(1);
+        auto exec = ioc.get_executor();
+
+        auto promises = std::vector< net::promise< std::size_t > >();
+        auto futures  = std::vector< net::future< std::size_t > >();
+        promises.reserve(count);
+        futures.reserve(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            promises.emplace_back(exec);
+            futures.push_back(promises.back().get_future());
+        }
+
+        std::size_t completed = 0;
+        auto        go        = std::atomic< bool >(false);
+        auto        threads   = std::vector< std::thread >();
+        for (std::size_t t = 0; t < producers; ++t)
+            threads.emplace_back([&, t] {
+                while (not go.load(std::memory_order_acquire))
+                    ;
+                for (auto i = t; i < count; i += producers)
+                    promises[i].set_value(i);
+            });
+
+        auto start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto &f : futures)
+            f.async_wait([&completed](error_code ec, std::optional< std::size_t > v) {
+                if (not ec.failed() and v.has_value())
+                    ++completed;
+            });
+        ioc.run();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        for (auto &t : threads)
+            t.join();
+        CHECK(completed == count);
+        return std::chrono::duration< double, std::nano >(elapsed).count() / double(count);
+    }
+
+    /// Value set and waited for on the same thread, one at a time: the cost of the state machine without contention
+    auto time_uncontended(std::size_t count) -> double
+    {
+        auto ioc       = net::io_context(1);
+        auto exec      = ioc.get_executor();
+        auto completed = std::size_t(0);
+        auto work      = net::make_work_guard(ioc);
+
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            auto p = net::promise< std::size_t >(exec);
+            auto f = p.get_future();
+            p.set_value(i);
+            f.async_wait([&completed](error_code, std::optional< std::size_t >) { ++completed; });
+            ioc.poll();
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        CHECK(completed == count);
+        return std::chrono::duration< double, std::nano >(elapsed).count() / double(count);
+    }
+}   // namespace
+
+TEST_CASE("polyfill::net::future contention", "[.][benchmark]")
+{
+    constexpr std::size_t count = 500'000;
+
+    // warm up
+    time_uncontended(count / 10);
+
+    std::cout << "uncontended set/wait : " << time_uncontended(count) << " ns\n";
+    for (std::size_t producers : { 1, 2, 4 })
+        std::cout << "handoff, " << producers << " producer(s) : " << time_handoff(count, producers) << " ns\n";
+}
@@ -0,0 +1,259 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#pragma once
+
+#include "polyfill/net.hpp"
+
+#include <array>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace polyfill::net
+{
+    /// A small pool of memory blocks from which asynchronous operation state is allocated.
+    ///
+    /// A loop which performs one asynchronous operation at a time (for example a forwarding coroutine) allocates
+    /// and frees an operation of the same size on every iteration. Binding the loop's completion handlers to a
+    /// handler_memory means the block is reused instead of being returned to the heap.
+    /// Requests larger than SlotSize, or made while all slots are in use, fall back to the heap.
+    ///
+    /// Not thread safe. Intended to be owned by one connection and used only on that connection's executor.
+    template < std::size_t SlotSize = 1024, std::size_t Slots = 2 >
+    struct handler_memory
+    {
+        handler_memory()                       = default;
+        handler_memory(handler_memory const &) = delete;
+        handler_memory &operator=(handler_memory const &) = delete;
+
+        auto allocate(std::size_t size) -> void *
+        {
+            if (size <= SlotSize)
+                for (std::size_t i = 0; i < Slots; ++i)
+                    if (not in_use_[i])
+                    {
+                        in_use_[i] = true;
+                        ++recycled_;
+                        return &storage_[i];
+                    }
+            ++heap_allocations_;
+            return ::operator new(size);
+        }
+
+        auto deallocate(void *p) -> void
+        {
+            for (std::size_t i = 0; i < Slots; ++i)
+                if (p == &storage_[i])
+                {
+                    in_use_[i] = false;
+                    return;
+                }
+            ::operator delete(p);
+        }
+
+        /// Number of allocations served from the pool
+        auto recycled() const -> std::size_t { return recycled_; }
+
+        /// Number of allocations which fell back to the heap
+        auto heap_allocations() const -> std::size_t { return heap_allocations_; }
+
+      private:
+        using slot_type = std::aligned_storage_t< SlotSize, alignof(std::max_align_t) >;
+
+        std::array< slot_type, Slots > storage_;
+        std::array< bool, Slots >      in_use_ {};
+        std::size_t                    recycled_         = 0;
+        std::size_t                    heap_allocations_ = 0;
+    };
+
+    /// A standard allocator drawing from a handler_memory
+    template < class T, class Memory = handler_memory<> >
+    struct recycling_allocator
+    {
+        using value_type = T;
+
+        explicit recycling_allocator(Memory &mem) noexcept
+        : memory_(std::addressof(mem))
+        {
+        }
+
+        template < class U >
+        recycling_allocator(recycling_allocator< U, Memory > const &other) noexcept
+        : memory_(other.memory_)
+        {
+        }
+
+        template < class U >
+        struct rebind
+        {
+            using other = recycling_allocator< U, Memory >;
+        };
+
+        auto allocate(std::size_t n) const -> T * { return static_cast< T * >(memory_->allocate(sizeof(T) * n)); }
+
+        auto deallocate(T *p, std::size_t /*n*/) const -> void { memory_->deallocate(p); }
+
+        template < class U >
+        friend bool operator==(recycling_allocator const &l, recycling_allocator< U, Memory > const &r) noexcept
+        {
+            return l.memory_ == r.memory_;
+        }
+
+        template < class U >
+        friend bool operator!=(recycling_allocator const &l, recycling_allocator< U, Memory > const &r) noexcept
+        {
+            return l.memory_ != r.memory_;
+        }
+
+      private:
+        template < class, class >
+        friend struct recycling_allocator;
+
+        Memory *memory_;
+    };
+
+    /// A completion token or handler with an associated allocator.
+    /// The target's associated executor is preserved.
+    template < class T, class Allocator >
+    struct allocator_binder
+    {
+        using target_type    = T;
+        using allocator_type = Allocator;
+
+        template < class U >
+        allocator_binder(Allocator const &alloc, U &&target)
+        : alloc_(alloc)
+        , target_(std::forward< U >(target))
+        {
+        }
+
+        /// Convert from a binder of a completion token to a binder of the handler it produces
+        template < class U >
+        allocator_binder(allocator_binder< U, Allocator > &&other)
+        : alloc_(other.get_allocator())
+        , target_(std::move(other.get()))
+        {
+        }
+
+        auto get() -> target_type & { return target_; }
+        auto get() const -> target_type const & { return target_; }
+
+        auto get_allocator() const noexcept -> allocator_type { return alloc_; }
+
+        template < class... Args >
+        auto operator()(Args &&... args) -> decltype(std::declval< T & >()(std::forward< Args >(args)...))
+        {
+            return target_(std::forward< Args >(args)...);
+        }
+
+        friend bool asio_handler_is_continuation(allocator_binder *this_handler)
+        {
+            return boost_asio_handler_cont_helpers::is_continuation(this_handler->target_);
+        }
+
+      private:
+        Allocator alloc_;
+        T         target_;
+    };
+
+    /// Associate the allocations made on behalf of `token` with `mem`.
+    /// \param mem must outlive every operation initiated with the returned token
+    template < class Memory, class CompletionToken >
+    auto bind_recycling(Memory &mem, CompletionToken &&token)
+    {
+        using allocator_type = recycling_allocator< void, Memory >;
+        return allocator_binder< std::decay_t< CompletionToken >, allocator_type >(
+            allocator_type(mem), std::forward< CompletionToken >(token));
+    }
+
+}   // namespace polyfill::net
+
+namespace polyfill::net::detail
+{
+    template < class T, class Allocator, class Signature, class = void >
+    struct allocator_binder_result_base
+    {
+    };
+
+    template < class T, class Allocator, class Signature >
+    struct allocator_binder_result_base<
+        T,
+        Allocator,
+        Signature,
+        std::void_t< typename net::async_result< T, Signature >::completion_handler_type > >
+    {
+        using completion_handler_type =
+            allocator_binder< typename net::async_result< T, Signature >::completion_handler_type, Allocator >;
+    };
+}   // namespace polyfill::net::detail
+
+namespace boost::asio
+{
+    template < class T, class Allocator, class Executor >
+    struct associated_executor< polyfill::net::allocator_binder< T, Allocator >, Executor >
+    {
+        using type = typename associated_executor< T, Executor >::type;
+
+        static auto get(polyfill::net::allocator_binder< T, Allocator > const &b,
+                        Executor const &ex = Executor()) noexcept -> type
+        {
+            return associated_executor< T, Executor >::get(b.get(), ex);
+        }
+    };
+
+    /// Allows allocator_binder to wrap completion tokens such as use_awaitable. The handler produced by the
+    /// underlying token is itself wrapped so that the operation sees the bound allocator.
+    template < class T, class Allocator, class Signature >
+    struct async_result< polyfill::net::allocator_binder< T, Allocator >, Signature >
+    : polyfill::net::detail::allocator_binder_result_base< T, Allocator, Signature >
+    {
+        using return_type = typename async_result< T, Signature >::return_type;
+
+        template < class Handler >
+        explicit async_result(Handler &h)
+        : target_(h.get())
+        {
+        }
+
+        async_result(async_result const &) = delete;
+        async_result &operator=(async_result const &) = delete;
+
+        auto get() -> return_type { return target_.get(); }
+
+        template < class Initiation >
+        struct init_wrapper
+        {
+            template < class Handler, class... Args >
+            void operator()(Handler &&handler, Args &&... args)
+            {
+                std::move(initiation)(
+                    polyfill::net::allocator_binder< std::decay_t< Handler >, Allocator >(
+                        alloc, std::forward< Handler >(handler)),
+                    std::forward< Args >(args)...);
+            }
+
+            Initiation initiation;
+            Allocator  alloc;
+        };
+
+        template < class Initiation, class RawToken, class... Args >
+        static auto initiate(Initiation &&initiation, RawToken &&token, Args &&... args) -> return_type
+        {
+            return async_initiate< T, Signature >(
+                init_wrapper< std::decay_t< Initiation > > { std::forward< Initiation >(initiation),
+                                                            token.get_allocator() },
+                token.get(),
+                std::forward< Args >(args)...);
+        }
+
+      private:
+        async_result< T, Signature > target_;
+    };
+
+}   // namespace boost::asio
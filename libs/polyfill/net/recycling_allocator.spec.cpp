@@ -0,0 +1,60 @@
+#include "polyfill/net/recycling_allocator.hpp"
+
+#include <boost/asio/local/connect_pair.hpp>
+#include <catch2/catch.hpp>
+
+TEST_CASE("polyfill::net::recycling_allocator")
+{
+    using namespace polyfill;
+    using socket_type = net::basic_stream_socket< net::local::stream_protocol, net::io_context::executor_type >;
+
+    auto ioc = net::io_context();
+    auto a   = socket_type(ioc.get_executor());
+    auto b   = socket_type(ioc.get_executor());
+    net::local::connect_pair(a, b);
+
+    auto mem  = net::handler_memory<>();
+    auto data = std::array< char, 16 > {};
+
+    SECTION("handlers")
+    {
+        int  rounds = 0;
+        auto loop   = [&](auto &self) -> void {
+            net::async_write(a, net::buffer(data), net::bind_recycling(mem, [&](error_code ec, std::size_t) {
+                                 REQUIRE(not ec.failed());
+                                 net::async_read(
+                                     b, net::buffer(data), net::bind_recycling(mem, [&](error_code ec, std::size_t) {
+                                         REQUIRE(not ec.failed());
+                                         if (++rounds < 100)
+                                             self(self);
+                                     }));
+                             }));
+        };
+        loop(loop);
+        ioc.run();
+
+        CHECK(rounds == 100);
+        CHECK(mem.recycled() >= 200);
+        CHECK(mem.heap_allocations() == 0);
+    }
+
+    SECTION("coroutines")
+    {
+        int rounds = 0;
+        net::co_spawn(
+            ioc.get_executor(),
+            [&]() -> net::awaitable< void > {
+                for (; rounds < 100; ++rounds)
+                {
+                    co_await net::async_write(a, net::buffer(data), net::bind_recycling(mem, net::use_awaitable));
+                    co_await net::async_read(b, net::buffer(data), net::bind_recycling(mem, net::use_awaitable));
+                }
+            },
+            net::detached);
+        ioc.run();
+
+        CHECK(rounds == 100);
+        CHECK(mem.recycled() >= 200);
+        CHECK(mem.heap_allocations() == 0);
+    }
+}
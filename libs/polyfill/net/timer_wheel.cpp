@@ -0,0 +1,189 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#include "timer_wheel.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace polyfill::net
+{
+    // ------ entry ------
+
+    timer_wheel::entry::entry(std::function< void() > on_expiry)
+    : on_expiry_(std::move(on_expiry))
+    {
+    }
+
+    timer_wheel::entry::~entry() { cancel(); }
+
+    auto timer_wheel::entry::cancel() -> void
+    {
+        if (linked())
+        {
+            unlink();
+            --wheel_->size_;
+        }
+    }
+
+    // ------ timer_wheel ------
+
+    timer_wheel::timer_wheel(executor_type exec, clock_type::duration resolution)
+    : resolution_(resolution)
+    , origin_(clock_type::now())
+    , timer_(exec)
+    {
+        assert(resolution_.count() > 0);
+    }
+
+    timer_wheel::~timer_wheel()
+    {
+        for (auto &wheel : wheels_)
+            for (auto &slot : wheel)
+                while (slot.linked())
+                    slot.next->unlink();
+    }
+
+    auto timer_wheel::arm(entry &e, clock_type::duration timeout) -> void
+    {
+        e.cancel();
+
+        // Measure from the clock rather than from the last tick, which is stale if the loop has been blocked, so
+        // that the entry never expires early. An idle wheel does not tick, so it is brought up to date.
+        auto current = std::max< std::uint64_t >(now_tick_, (clock_type::now() - origin_) / resolution_);
+        if (size_ == 0)
+            now_tick_ = current;
+
+        // Round up, and allow for the current tick being partly over
+        auto ticks = std::uint64_t((std::max(timeout, clock_type::duration::zero()) + resolution_ -
+                                    clock_type::duration(1)) /
+                                   resolution_);
+        e.wheel_  = this;
+        e.expiry_ = current + ticks + 1;
+        insert(e);
+        ++size_;
+
+        if (running_ and not ticking_)
+            schedule();
+    }
+
+    auto timer_wheel::start() -> void
+    {
+        running_ = true;
+        if (size_ and not ticking_)
+            schedule();
+    }
+
+    auto timer_wheel::stop() -> void
+    {
+        running_ = false;
+        ticking_ = false;
+        timer_.cancel();
+    }
+
+    auto timer_wheel::advance(clock_type::time_point now) -> void
+    {
+        if (now < origin_)
+            return;
+        auto target = std::uint64_t((now - origin_) / resolution_);
+        while (now_tick_ < target)
+        {
+            if (size_ == 0)
+            {
+                now_tick_ = target;
+                break;
+            }
+            ++now_tick_;
+            tick();
+        }
+    }
+
+    auto timer_wheel::insert(entry &e) -> void
+    {
+        auto delta = e.expiry_ - now_tick_;
+        for (std::size_t level = 0; level < levels; ++level)
+        {
+            auto shift = slot_bits * level;
+            if (delta < (std::uint64_t(1) << (shift + slot_bits)))
+            {
+                e.link_before(wheels_[level][(e.expiry_ >> shift) & (slots - 1)]);
+                return;
+            }
+        }
+
+        // Beyond the range of the wheel: park in the furthest slot, from which it will be cascaded again
+        auto shift = slot_bits * (levels - 1);
+        auto far   = now_tick_ + (std::uint64_t(1) << (shift + slot_bits)) - 1;
+        e.link_before(wheels_[levels - 1][(far >> shift) & (slots - 1)]);
+    }
+
+    auto timer_wheel::tick() -> void
+    {
+        // When a wheel wraps, move the entries of the next slot of the wheel above down to where they now belong.
+        // Higher wheels first, so that entries cascade all the way down within one tick.
+        auto top = std::size_t(0);
+        while (top + 1 < levels and (now_tick_ & ((std::uint64_t(1) << (slot_bits * (top + 1))) - 1)) == 0)
+            ++top;
+        for (auto level = top; level > 0; --level)
+            cascade(level);
+
+        // Detach the due slot so that callbacks may arm and cancel entries freely
+        auto &slot = wheels_[0][now_tick_ & (slots - 1)];
+        auto  due  = slot_type();
+        if (slot.linked())
+        {
+            due.link_before(*slot.next);
+            slot.unlink();
+        }
+
+        while (due.linked())
+        {
+            auto &e = static_cast< entry & >(*due.next);
+            e.unlink();
+            --size_;
+            e.on_expiry_();
+        }
+    }
+
+    auto timer_wheel::cascade(std::size_t level) -> void
+    {
+        auto &slot  = wheels_[level][(now_tick_ >> (slot_bits * level)) & (slots - 1)];
+        auto  moved = slot_type();
+        if (slot.linked())
+        {
+            moved.link_before(*slot.next);
+            slot.unlink();
+        }
+
+        while (moved.linked())
+        {
+            auto &e = static_cast< entry & >(*moved.next);
+            e.unlink();
+            insert(e);
+        }
+    }
+
+    auto timer_wheel::schedule() -> void
+    {
+        ticking_ = true;
+        timer_.expires_at(origin_ + resolution_ * (now_tick_ + 1));
+        timer_.async_wait([this](error_code ec) { handle_tick(ec); });
+    }
+
+    auto timer_wheel::handle_tick(error_code ec) -> void
+    {
+        if (ec == net::error::operation_aborted or not running_)
+            return;
+
+        advance(clock_type::now());
+        if (size_)
+            schedule();
+        else
+            ticking_ = false;
+    }
+
+}   // namespace polyfill::net
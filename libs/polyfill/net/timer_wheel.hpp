@@ -0,0 +1,137 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#pragma once
+
+#include "polyfill/net.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+namespace polyfill::net
+{
+    namespace detail
+    {
+        /// Node of an intrusive circular list. A node linked to itself is unlinked.
+        struct timer_wheel_link
+        {
+            timer_wheel_link() = default;
+            timer_wheel_link(timer_wheel_link const &) = delete;
+            timer_wheel_link &operator=(timer_wheel_link const &) = delete;
+
+            auto linked() const -> bool { return next != this; }
+
+            auto unlink() -> void
+            {
+                prev->next = next;
+                next->prev = prev;
+                next = prev = this;
+            }
+
+            /// Insert this node before `pos`
+            auto link_before(timer_wheel_link &pos) -> void
+            {
+                next       = &pos;
+                prev       = pos.prev;
+                prev->next = this;
+                pos.prev   = this;
+            }
+
+            timer_wheel_link *next = this;
+            timer_wheel_link *prev = this;
+        };
+    }   // namespace detail
+
+    /// Coarse timeouts for many connections, served by one asio timer.
+    ///
+    /// Entries are kept in a hierarchy of four wheels of 64 slots, so arming, re-arming and cancelling an entry is
+    /// a constant time list operation with no allocation, however many entries there are. Expired entries run their
+    /// callback on the wheel's executor. With the default resolution of 100ms the wheel covers about 19 days.
+    ///
+    /// An entry never expires early, and expires at most two resolutions late.
+    /// Not thread safe: arm, cancel and callbacks must all happen on the wheel's executor.
+    struct timer_wheel
+    {
+        using executor_type = net::io_context::executor_type;
+        using clock_type    = std::chrono::steady_clock;
+        using timer_type    = net::basic_waitable_timer< clock_type, net::wait_traits< clock_type >, executor_type >;
+
+        static constexpr unsigned    slot_bits = 6;
+        static constexpr std::size_t slots     = std::size_t(1) << slot_bits;
+        static constexpr std::size_t levels    = 4;
+
+        /// A timeout owned by its user, typically a connection. The entry must not be destroyed by its own
+        /// callback. Destroying an armed entry cancels it.
+        struct entry : private detail::timer_wheel_link
+        {
+            explicit entry(std::function< void() > on_expiry);
+            ~entry();
+
+            auto armed() const -> bool { return linked(); }
+
+            auto cancel() -> void;
+
+          private:
+            friend timer_wheel;
+
+            std::function< void() > on_expiry_;
+            timer_wheel *           wheel_  = nullptr;
+            std::uint64_t           expiry_ = 0;
+        };
+
+        explicit timer_wheel(executor_type exec, clock_type::duration resolution = std::chrono::milliseconds(100));
+        ~timer_wheel();
+
+        timer_wheel(timer_wheel const &) = delete;
+        timer_wheel &operator=(timer_wheel const &) = delete;
+
+        /// Arm, or re-arm, an entry to expire after `timeout`
+        auto arm(entry &e, clock_type::duration timeout) -> void;
+
+        /// Begin expiring entries. The asio timer only runs while entries are armed.
+        auto start() -> void;
+
+        /// Stop expiring entries. Armed entries remain armed.
+        auto stop() -> void;
+
+        /// Expire every entry due at or before `now`. Called by the running wheel; public so that the wheel can be
+        /// driven without a clock.
+        auto advance(clock_type::time_point now) -> void;
+
+        /// Number of armed entries
+        auto size() const -> std::size_t { return size_; }
+
+        auto resolution() const -> clock_type::duration { return resolution_; }
+
+        /// The time of tick 0
+        auto origin() const -> clock_type::time_point { return origin_; }
+
+        auto get_executor() -> executor_type { return timer_.get_executor(); }
+
+      private:
+        using slot_type = detail::timer_wheel_link;
+
+        auto insert(entry &e) -> void;
+        auto tick() -> void;
+        auto cascade(std::size_t level) -> void;
+        auto schedule() -> void;
+        auto handle_tick(error_code ec) -> void;
+
+        clock_type::duration   resolution_;
+        clock_type::time_point origin_;
+        std::uint64_t          now_tick_ = 0;
+        std::size_t            size_     = 0;
+        bool                   running_  = false;
+        bool                   ticking_  = false;
+        timer_type             timer_;
+
+        std::array< std::array< slot_type, slots >, levels > wheels_;
+    };
+
+}   // namespace polyfill::net
@@ -0,0 +1,191 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#include "polyfill/net/timer_wheel.hpp"
+
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using namespace polyfill;
+    using namespace std::literals;
+}   // namespace
+
+TEST_CASE("polyfill::net::timer_wheel")
+{
+    auto ioc   = net::io_context();
+    auto wheel = net::timer_wheel(ioc.get_executor(), 100ms);
+    auto at    = [&](auto offset) { return wheel.origin() + offset; };
+
+    SECTION("entries never expire early")
+    {
+        int  fired = 0;
+        auto e     = net::timer_wheel::entry([&] { ++fired; });
+        wheel.arm(e, 250ms);
+        CHECK(e.armed());
+        CHECK(wheel.size() == 1);
+
+        wheel.advance(at(299ms));
+        CHECK(fired == 0);
+        wheel.advance(at(400ms));
+        CHECK(fired == 1);
+        CHECK(not e.armed());
+        CHECK(wheel.size() == 0);
+    }
+
+    SECTION("an entry armed while the wheel is behind the clock does not expire early")
+    {
+        int  fired = 0;
+        auto busy  = net::timer_wheel::entry([] {});
+        auto e     = net::timer_wheel::entry([&] { ++fired; });
+        wheel.arm(busy, 10s);
+
+        // the loop is blocked, so the wheel has not ticked
+        std::this_thread::sleep_for(450ms);
+        auto armed_at = net::timer_wheel::clock_type::now();
+        wheel.arm(e, 200ms);
+        wheel.advance(armed_at + 199ms);
+        CHECK(fired == 0);
+        wheel.advance(armed_at + 400ms);
+        CHECK(fired == 1);
+    }
+
+    SECTION("re-arming postpones, cancelling and destruction prevent expiry")
+    {
+        int  fired = 0;
+        auto a     = net::timer_wheel::entry([&] { fired += 1; });
+        auto b     = std::make_unique< net::timer_wheel::entry >([&] { fired += 10; });
+        auto c     = net::timer_wheel::entry([&] { fired += 100; });
+        wheel.arm(a, 200ms);
+        wheel.arm(*b, 200ms);
+        wheel.arm(c, 200ms);
+        CHECK(wheel.size() == 3);
+
+        wheel.advance(at(200ms));
+        wheel.arm(a, 200ms);
+        c.cancel();
+        b.reset();
+        CHECK(wheel.size() == 1);
+
+        wheel.advance(at(400ms));
+        CHECK(fired == 0);
+        wheel.advance(at(500ms));
+        CHECK(fired == 1);
+    }
+
+    SECTION("callbacks may re-arm their own entry")
+    {
+        int                      fired = 0;
+        net::timer_wheel::entry *self  = nullptr;
+        auto                     e     = net::timer_wheel::entry([&] {
+            if (++fired < 3)
+                wheel.arm(*self, 100ms);
+        });
+        self = &e;
+        wheel.arm(e, 100ms);
+        wheel.advance(at(10s));
+        CHECK(fired == 3);
+    }
+
+    SECTION("entries on every level expire on their own tick")
+    {
+        auto rng      = std::mt19937(1);
+        auto dist     = std::uniform_int_distribution< std::uint64_t >(0, 20'000'000);
+        auto expected = std::vector< std::uint64_t >();
+        auto actual   = std::vector< std::uint64_t >();
+        auto entries  = std::vector< std::unique_ptr< net::timer_wheel::entry > >();
+        auto now      = std::uint64_t(0);
+
+        // the largest timeouts lie beyond the range of the wheel
+        for (std::size_t i = 0; i < 2000; ++i)
+        {
+            auto ticks = dist(rng) >> (i % 4 * 6);   // spread over all four wheels
+            expected.push_back(ticks + 1);
+            actual.push_back(0);
+            entries.push_back(std::make_unique< net::timer_wheel::entry >([&actual, &now, i] { actual[i] = now; }));
+            wheel.arm(*entries.back(), wheel.resolution() * ticks);
+        }
+
+        while (wheel.size())
+            wheel.advance(at(wheel.resolution() * ++now));
+
+        for (std::size_t i = 0; i < expected.size(); ++i)
+        {
+            INFO("entry " << i);
+            CHECK(actual[i] == expected[i]);
+        }
+    }
+
+    SECTION("the running wheel expires entries in real time")
+    {
+        auto fast  = net::timer_wheel(ioc.get_executor(), 5ms);
+        bool fired = false;
+        auto e     = net::timer_wheel::entry([&] {
+            fired = true;
+            fast.stop();
+        });
+        fast.start();
+        auto start = std::chrono::steady_clock::now();
+        fast.arm(e, 20ms);
+        ioc.run_for(2s);
+        CHECK(fired);
+        CHECK(std::chrono::steady_clock::now() - start >= 20ms);
+    }
+}
+
+TEST_CASE("polyfill::net::timer_wheel re-arm cost", "[.][benchmark]")
+{
+    constexpr std::size_t connections = 100'000;
+    constexpr std::size_t rounds      = 10;
+
+    auto ioc = net::io_context();
+
+    {
+        auto wheel   = net::timer_wheel(ioc.get_executor());
+        auto entries = std::vector< std::unique_ptr< net::timer_wheel::entry > >();
+        for (std::size_t i = 0; i < connections; ++i)
+            entries.push_back(std::make_unique< net::timer_wheel::entry >([] {}));
+
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t r = 0; r < rounds; ++r)
+            for (std::size_t i = 0; i < connections; ++i)
+                wheel.arm(*entries[i], std::chrono::seconds(30 + i % 30));
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << "timer_wheel re-arm      : "
+                  << std::chrono::duration< double, std::nano >(elapsed).count() / double(connections * rounds)
+                  << " ns\n";
+    }
+
+    {
+        using timer_type = net::basic_waitable_timer< std::chrono::steady_clock,
+                                                      net::wait_traits< std::chrono::steady_clock >,
+                                                      net::io_context::executor_type >;
+        auto timers = std::vector< std::unique_ptr< timer_type > >();
+        for (std::size_t i = 0; i < connections; ++i)
+            timers.push_back(std::make_unique< timer_type >(ioc.get_executor()));
+
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t r = 0; r < rounds; ++r)
+            for (std::size_t i = 0; i < connections; ++i)
+            {
+                timers[i]->expires_after(std::chrono::seconds(30 + i % 30));
+                timers[i]->async_wait([](error_code) {});
+            }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << "steady_timer re-arm     : "
+                  << std::chrono::duration< double, std::nano >(elapsed).count() / double(connections * rounds)
+                  << " ns (excluding the cancelled handlers)\n";
+        timers.clear();
+        ioc.run();
+    }
+}
@@ -0,0 +1,127 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#pragma once
+#include "polyfill/net.hpp"
+#include "polyfill/net/detail/when_state.hpp"
+#include "polyfill/net/future.hpp"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <utility>
+#include <variant>
+
+/// @file when.hpp
+///
+/// Await several operations concurrently.
+///
+/// Each operation is run as a child coroutine on the awaiting coroutine's executor. No strand is created, so that
+/// executor must not run handlers concurrently (an io_context run by one thread, or a strand).
+///
+/// Coroutines cannot be interrupted from outside, so an operation which may have to be abandoned is paired with a
+/// function which causes it to finish early, typically by cancelling the socket or timer it is waiting on. See
+/// cancellable(). The combinators do not complete until every child has finished, so operations may safely refer
+/// to objects owned by the awaiting coroutine.
+///
+namespace polyfill::net
+{
+    /// An awaitable operation together with the means to cancel it
+    template < class T >
+    struct cancellable_op
+    {
+        using value_type = T;
+
+        awaitable< T >          op;
+        std::function< void() > cancel;
+    };
+
+    template < class T >
+    auto cancellable(awaitable< T > op, std::function< void() > cancel) -> cancellable_op< T >
+    {
+        return { std::move(op), std::move(cancel) };
+    }
+
+    /// Wait for a future. Cancelling abandons the wait; the promise is unaffected.
+    template < class T, class Executor >
+    auto cancellable(future< T, Executor > f) -> cancellable_op< T >
+    {
+        auto wait = [](future< T, Executor > f) -> awaitable< T > { co_return co_await f(); };
+        return { wait(f), [f]() mutable { f.cancel(); } };
+    }
+
+    /// @brief Run all operations concurrently and return all of their results.
+    ///
+    /// If any operation throws, the others are cancelled and, once all have finished, the first exception is
+    /// rethrown.
+    /// @param args Each may be a cancellable_op, a future, or an awaitable (which cannot be cancelled).
+    /// @return A tuple of the results. Operations returning void contribute std::monostate.
+    template < class... Args >
+    auto when_all(Args &&... args) -> awaitable< std::tuple< detail::when_result_t< Args >... > >
+    {
+        static_assert(sizeof...(Args) > 0);
+        return detail::when_all_impl(std::index_sequence_for< Args... >(),
+                                     detail::as_cancellable(std::forward< Args >(args))...);
+    }
+
+    /// @brief Run all operations concurrently and return the result of the first to finish.
+    ///
+    /// The remaining operations are cancelled. If the first to finish threw, its exception is rethrown once all
+    /// have finished.
+    /// @param args Each may be a cancellable_op, a future, or an awaitable (which cannot be cancelled).
+    /// @return A variant whose index identifies the operation that finished first.
+    template < class... Args >
+    auto when_any(Args &&... args) -> awaitable< std::variant< detail::when_result_t< Args >... > >
+    {
+        static_assert(sizeof...(Args) > 0);
+        return detail::when_any_impl(std::index_sequence_for< Args... >(),
+                                     detail::as_cancellable(std::forward< Args >(args))...);
+    }
+
+    /// Limit the time an operation may take. If the limit expires the operation is cancelled and the returned
+    /// operation throws system_error(net::error::timed_out).
+    template < class Arg >
+    auto with_timeout(Arg &&arg, std::chrono::steady_clock::duration limit)
+        -> cancellable_op< detail::when_value_t< Arg > >
+    {
+        auto inner = detail::as_cancellable(std::forward< Arg >(arg));
+        auto ctl   = std::make_shared< detail::timeout_control >();
+        ctl->cancel_inner = std::move(inner.cancel);
+
+        return { detail::run_with_timeout(std::move(inner.op), ctl, limit), [ctl] { ctl->cancel(); } };
+    }
+
+}   // namespace polyfill::net
+
+namespace polyfill::net::detail
+{
+    inline auto wait_for_expiry(timeout_control::timer_type &timer) -> awaitable< void >
+    {
+        co_await timer.async_wait(use_awaitable);
+    }
+
+    template < class T >
+    auto run_with_timeout(awaitable< T >                      op,
+                          std::shared_ptr< timeout_control >  ctl,
+                          std::chrono::steady_clock::duration limit) -> awaitable< T >
+    {
+        auto &timer = ctl->timer.emplace(co_await this_coro::executor, limit);
+        if (ctl->cancelled)
+            throw system_error(error::operation_aborted);
+
+        auto guarded = cancellable(std::move(op), [ctl] { ctl->cancel_op(); });
+        auto expiry  = cancellable(wait_for_expiry(timer), [ctl] { ctl->timer->cancel(); });
+        auto result  = co_await when_any(std::move(guarded), std::move(expiry));
+        if (result.index() == 1)
+            throw system_error(error::timed_out);
+        if constexpr (not std::is_void_v< T >)
+            co_return std::get< 0 >(std::move(result));
+    }
+
+}   // namespace polyfill::net::detail
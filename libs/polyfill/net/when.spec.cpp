@@ -0,0 +1,158 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#include "polyfill/net/when.hpp"
+
+#include <catch2/catch.hpp>
+#include <string>
+
+namespace
+{
+    using namespace polyfill;
+    using namespace std::literals;
+
+    using timer_type = net::detail::timeout_control::timer_type;
+
+    auto delayed(timer_type &timer, std::chrono::milliseconds delay, std::string result) -> net::awaitable< std::string >
+    {
+        timer.expires_after(delay);
+        co_await timer.async_wait(net::use_awaitable);
+        co_return result;
+    }
+
+    auto sleep(timer_type &timer, std::chrono::milliseconds delay) -> net::awaitable< void >
+    {
+        timer.expires_after(delay);
+        co_await timer.async_wait(net::use_awaitable);
+    }
+
+    auto failing() -> net::awaitable< int >
+    {
+        co_await net::post(net::use_awaitable);
+        throw system_error(net::error::connection_refused);
+    }
+
+    template < class F >
+    auto run_test(net::io_context &ioc, F f) -> void
+    {
+        auto failure = std::exception_ptr();
+        net::co_spawn(ioc, std::move(f), [&failure](std::exception_ptr ep) { failure = ep; });
+        ioc.run();
+        if (failure)
+            std::rethrow_exception(failure);
+    }
+}   // namespace
+
+TEST_CASE("polyfill::net::when_all")
+{
+    auto ioc = net::io_context();
+    auto t1  = timer_type(ioc.get_executor());
+    auto t2  = timer_type(ioc.get_executor());
+    auto t3  = timer_type(ioc.get_executor());
+
+    SECTION("results of all operations, run concurrently")
+    {
+        run_test(ioc, [&]() -> net::awaitable< void > {
+            auto start     = std::chrono::steady_clock::now();
+            auto [a, b, c] = co_await net::when_all(delayed(t1, 50ms, "a"), delayed(t2, 50ms, "b"), sleep(t3, 0ms));
+            auto elapsed   = std::chrono::steady_clock::now() - start;
+            CHECK(a == "a");
+            CHECK(b == "b");
+            CHECK(std::is_same_v< decltype(c), std::monostate >);
+            CHECK(elapsed < 95ms);
+        });
+    }
+
+    SECTION("a failure cancels the others and is rethrown")
+    {
+        run_test(ioc, [&]() -> net::awaitable< void > {
+            auto start = std::chrono::steady_clock::now();
+            try
+            {
+                co_await net::when_all(net::cancellable(delayed(t1, 10s, "slow"), [&] { t1.cancel(); }), failing());
+                FAIL("no exception");
+            }
+            catch (system_error &se)
+            {
+                CHECK(se.code() == net::error::connection_refused);
+            }
+            CHECK(std::chrono::steady_clock::now() - start < 1s);
+        });
+    }
+}
+
+TEST_CASE("polyfill::net::when_any")
+{
+    auto ioc = net::io_context();
+    auto t1  = timer_type(ioc.get_executor());
+    auto t2  = timer_type(ioc.get_executor());
+
+    SECTION("first to finish wins and the loser is cancelled")
+    {
+        run_test(ioc, [&]() -> net::awaitable< void > {
+            auto start  = std::chrono::steady_clock::now();
+            auto result = co_await net::when_any(net::cancellable(delayed(t1, 10s, "slow"), [&] { t1.cancel(); }),
+                                                 net::cancellable(delayed(t2, 10ms, "fast"), [&] { t2.cancel(); }));
+            REQUIRE(result.index() == 1);
+            CHECK(std::get< 1 >(result) == "fast");
+            CHECK(std::chrono::steady_clock::now() - start < 1s);
+        });
+    }
+
+    SECTION("futures can be raced and abandoned")
+    {
+        auto p = net::promise< int, net::detail::when_executor_type >(ioc.get_executor());
+        auto f = p.get_future();
+        run_test(ioc, [&]() -> net::awaitable< void > {
+            auto result = co_await net::when_any(f, net::cancellable(sleep(t1, 10ms), [&] { t1.cancel(); }));
+            CHECK(result.index() == 1);
+        });
+        p.set_value(42);   // discarded
+    }
+
+    SECTION("a future which is fulfilled wins")
+    {
+        auto p = net::promise< int, net::detail::when_executor_type >(ioc.get_executor());
+        auto f = p.get_future();
+        net::post(ioc, [&] { p.set_value(42); });
+        run_test(ioc, [&]() -> net::awaitable< void > {
+            auto result = co_await net::when_any(f, net::cancellable(sleep(t1, 10s), [&] { t1.cancel(); }));
+            REQUIRE(result.index() == 0);
+            CHECK(std::get< 0 >(result) == 42);
+        });
+    }
+}
+
+TEST_CASE("polyfill::net::with_timeout")
+{
+    auto ioc = net::io_context();
+    auto t1  = timer_type(ioc.get_executor());
+
+    SECTION("expiry cancels the operation")
+    {
+        run_test(ioc, [&]() -> net::awaitable< void > {
+            try
+            {
+                co_await net::with_timeout(net::cancellable(delayed(t1, 10s, "slow"), [&] { t1.cancel(); }), 10ms).op;
+                FAIL("no exception");
+            }
+            catch (system_error &se)
+            {
+                CHECK(se.code() == net::error::timed_out);
+            }
+        });
+    }
+
+    SECTION("operations within the limit complete normally")
+    {
+        run_test(ioc, [&]() -> net::awaitable< void > {
+            auto quick  = net::cancellable(delayed(t1, 1ms, "quick"), [&] { t1.cancel(); });
+            auto result = co_await net::when_all(net::with_timeout(std::move(quick), 10s));
+            CHECK(std::get< 0 >(result) == "quick");
+        });
+    }
+}
@@ -0,0 +1,53 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#pragma once
+
+#include <cstddef>
+
+namespace polyfill::net
+{
+    /// Limits the work a loop does before giving other handlers on its executor a turn.
+    ///
+    /// Operations which can complete from buffered data complete without returning to the scheduler, so a loop
+    /// over them can run indefinitely while other connections wait. The loop consumes the budget once per unit of
+    /// work and yields (for example by co_await-ing a post) whenever consume() returns true.
+    struct yield_budget
+    {
+        yield_budget(std::size_t max_items, std::size_t max_bytes)
+        : max_items_(max_items)
+        , max_bytes_(max_bytes)
+        {
+        }
+
+        /// Account for one item of `bytes` bytes.
+        /// \return true if the budget is exhausted, in which case it is replenished for the next turn
+        auto consume(std::size_t bytes) -> bool
+        {
+            ++items_;
+            bytes_ += bytes;
+            if (items_ < max_items_ and bytes_ < max_bytes_)
+                return false;
+            reset();
+            return true;
+        }
+
+        /// Begin a new turn, for example after an operation which is known to have suspended
+        auto reset() -> void
+        {
+            items_ = 0;
+            bytes_ = 0;
+        }
+
+      private:
+        std::size_t max_items_;
+        std::size_t max_bytes_;
+        std::size_t items_ = 0;
+        std::size_t bytes_ = 0;
+    };
+
+}   // namespace polyfill::net
@@ -0,0 +1,39 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#include "polyfill/net/yield_budget.hpp"
+
+#include <catch2/catch.hpp>
+
+TEST_CASE("polyfill::net::yield_budget")
+{
+    auto budget = polyfill::net::yield_budget(4, 1000);
+
+    SECTION("exhausted by items")
+    {
+        CHECK(not budget.consume(10));
+        CHECK(not budget.consume(10));
+        CHECK(not budget.consume(10));
+        CHECK(budget.consume(10));
+        CHECK(not budget.consume(10));
+    }
+
+    SECTION("exhausted by bytes")
+    {
+        CHECK(not budget.consume(600));
+        CHECK(budget.consume(400));
+        CHECK(budget.consume(5000));
+        CHECK(not budget.consume(1));
+    }
+
+    SECTION("reset begins a new turn")
+    {
+        CHECK(not budget.consume(900));
+        budget.reset();
+        CHECK(not budget.consume(900));
+    }
+}
@@ -0,0 +1,94 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace polyfill
+{
+    /// Add `n` to a cell which only the calling thread writes. The relaxed load and store compile to a plain add,
+    /// with no locked instruction. They are atomic only so that a concurrent read by another thread is well defined.
+    template < class T >
+    auto bump(std::atomic< T > &cell, std::type_identity_t< T > n) -> void
+    {
+        cell.store(cell.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    /// A block of cells for each thread, so that a thread records with bump() into memory no other thread writes,
+    /// and readers sum over all the blocks.
+    ///
+    /// A block is never freed. When its thread exits it is handed to the next new thread, which carries on adding
+    /// to it, so that the sums remain correct.
+    ///
+    /// The calling thread's block is found through a thread_local for each Block type, so there must be only one
+    /// store of each Block type.
+    template < class Block >
+    struct per_thread_store
+    {
+        /// The calling thread's block, or nullptr if it has not yet used the store
+        static auto this_thread() -> Block * { return this_thread_block_; }
+
+        /// The calling thread's block, which is allocated or taken over on first use
+        auto local() -> Block &
+        {
+            if (auto block = this_thread_block_)
+                return *block;
+            return register_thread();
+        }
+
+        /// Call `f` with every block, while no block changes hands
+        template < class F >
+        auto for_each(F &&f) const -> void
+        {
+            auto lock = std::lock_guard(mutex_);
+            for (auto &block : blocks_)
+                f(std::as_const(*block));
+        }
+
+      private:
+        struct thread_owner
+        {
+            per_thread_store *store = nullptr;
+
+            ~thread_owner()
+            {
+                auto lock = std::lock_guard(store->mutex_);
+                store->free_.push_back(std::exchange(this_thread_block_, nullptr));
+            }
+        };
+
+        auto register_thread() -> Block &
+        {
+            {
+                auto lock = std::lock_guard(mutex_);
+                if (free_.empty())
+                    this_thread_block_ = blocks_.emplace_back(std::make_unique< Block >()).get();
+                else
+                {
+                    this_thread_block_ = free_.back();
+                    free_.pop_back();
+                }
+            }
+            thread_local thread_owner owner;
+            owner.store = this;
+            return *this_thread_block_;
+        }
+
+        static inline thread_local Block *this_thread_block_ = nullptr;
+
+        mutable std::mutex                      mutex_;
+        std::vector< std::unique_ptr< Block > > blocks_;   //! one per thread which has recorded
+        std::vector< Block * >                  free_;     //! blocks of threads which have exited
+    };
+
+}   // namespace polyfill
@@ -0,0 +1,87 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#include "timestamp.hpp"
+
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace polyfill::timestamp
+{
+    namespace
+    {
+        /// Nanoseconds per tick of the selected clock
+        std::atomic< double > tick_period { 1.0 };
+
+        /// Measure the TSC against the steady clock
+        auto calibrate_tsc() -> double
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            using clock = std::chrono::steady_clock;
+            auto t0     = clock::now();
+            auto c0     = __rdtsc();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            auto t1 = clock::now();
+            auto c1 = __rdtsc();
+            return double(std::chrono::duration_cast< std::chrono::nanoseconds >(t1 - t0).count()) / double(c1 - c0);
+#else
+            return 1.0;
+#endif
+        }
+    }   // namespace
+
+    auto select(source s) -> void
+    {
+#if !defined(__x86_64__) && !defined(__i386__)
+        if (s == source::tsc)
+            s = source::steady;
+#endif
+#ifndef CLOCK_MONOTONIC_COARSE
+        if (s == source::coarse)
+            s = source::steady;
+#endif
+        tick_period.store(s == source::tsc ? calibrate_tsc() : 1.0, std::memory_order_relaxed);
+        detail::selected.store(s, std::memory_order_relaxed);
+    }
+
+    auto to_nanoseconds(std::uint64_t ticks) -> std::uint64_t
+    {
+        if (selected() != source::tsc)
+            return ticks;
+        return std::uint64_t(double(ticks) * tick_period.load(std::memory_order_relaxed));
+    }
+
+    auto parse(std::string_view name) -> source
+    {
+        if (name == "steady")
+            return source::steady;
+        if (name == "coarse")
+            return source::coarse;
+        if (name == "tsc")
+            return source::tsc;
+        throw std::invalid_argument("unknown timestamp source: " + std::string(name));
+    }
+
+    auto to_string(source s) -> std::string_view
+    {
+        switch (s)
+        {
+        case source::steady:
+            return "steady";
+        case source::coarse:
+            return "coarse";
+        case source::tsc:
+            return "tsc";
+        }
+        return "unknown";
+    }
+
+    auto operator<<(std::ostream &os, source s) -> std::ostream & { return os << to_string(s); }
+
+}   // namespace polyfill::timestamp
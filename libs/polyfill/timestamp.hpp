@@ -0,0 +1,90 @@
+//
+// Copyright (c) 2020 Richard Hodges (hodges.r@gmail.com)
+// Copyright (c) 2020 Alexander Hodges
+//
+// Official repository: https://github.com/AlexAndDad/gateway
+//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string_view>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/// @file timestamp.hpp
+///
+/// Cheap timestamps for measuring intervals on the hot path, from a clock selected once for the process.
+///
+/// - steady : std::chrono::steady_clock. Nanosecond resolution, about 20ns per reading.
+/// - coarse : CLOCK_MONOTONIC_COARSE. A few nanoseconds per reading, but advances only once per scheduler tick
+///            (typically 1-4ms), so shorter intervals read as 0.
+/// - tsc    : the processor's time stamp counter. A few nanoseconds per reading with sub-nanosecond resolution.
+///            Requires an invariant TSC; falls back to steady on other architectures.
+///
+namespace polyfill::timestamp
+{
+    enum class source
+    {
+        steady,
+        coarse,
+        tsc
+    };
+
+    namespace detail
+    {
+        inline std::atomic< source > selected { source::steady };
+    }
+
+    /// Select the clock. Must be called before any timestamps are taken, since readings of different sources
+    /// cannot be compared.
+    auto select(source s) -> void;
+
+    inline auto selected() -> source { return detail::selected.load(std::memory_order_relaxed); }
+
+    /// The current time in ticks of the selected clock
+    inline auto now() -> std::uint64_t
+    {
+        switch (selected())
+        {
+        case source::coarse:
+        {
+#ifdef CLOCK_MONOTONIC_COARSE
+            auto ts = ::timespec();
+            ::clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+            return std::uint64_t(ts.tv_sec) * 1'000'000'000 + std::uint64_t(ts.tv_nsec);
+#else
+            break;
+#endif
+        }
+        case source::tsc:
+#if defined(__x86_64__) || defined(__i386__)
+            return __rdtsc();
+#else
+            break;
+#endif
+        case source::steady:
+            break;
+        }
+        return std::uint64_t(std::chrono::duration_cast< std::chrono::nanoseconds >(
+                                 std::chrono::steady_clock::now().time_since_epoch())
+                                 .count());
+    }
+
+    /// Convert an interval measured in ticks of the selected clock
+    auto to_nanoseconds(std::uint64_t ticks) -> std::uint64_t;
+
+    /// Parse "steady", "coarse" or "tsc"
+    /// \throw std::invalid_argument
+    auto parse(std::string_view name) -> source;
+
+    auto to_string(source s) -> std::string_view;
+
+    auto operator<<(std::ostream &os, source s) -> std::ostream &;
+
+}   // namespace polyfill::timestamp
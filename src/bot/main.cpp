@@ -11,7 +11,7 @@ namespace bot
 
     struct client
     {
-        using executor_type = net::executor;
+        using executor_type = net::strand< net::io_context::executor_type >;
         using transport     = net::ip::tcp;
         using socket_type   = net::basic_stream_socket< transport, executor_type >;
         using resolver_type = net::ip::basic_resolver< transport, executor_type >;
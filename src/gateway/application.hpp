@@ -3,6 +3,7 @@
 #include "listener.hpp"
 #include "minecraft/security/private_key.hpp"
 #include "minecraft/security/rsa.hpp"
+#include "minecraft/utils/logging.hpp"
 
 namespace gateway
 {
@@ -10,9 +11,12 @@ namespace gateway
     {
         auto as_listener_config() const -> listener_config const & { return *this; }
 
+        minecraft::utils::logging_config logging;
+
         friend auto operator<<(std::ostream &os, app_config const &cfg) -> std::ostream &
         {
             os << "Application Config\n";
+            os << "\tlog queue : " << cfg.logging.queue_size << '\n';
             os << cfg.as_listener_config();
             return os;
         }
@@ -31,6 +35,7 @@ namespace gateway
             std::cout << "Application Starting\n\n";
             std::cout << config_ << std::endl;
             signals_.add(SIGINT);
+            signals_.add(SIGHUP);
         }
 
         void start()
@@ -63,12 +68,18 @@ namespace gateway
             }
             else if (sig == SIGINT)
             {
-                std::clog << "app: interrupted" << std::endl;
+                spdlog::info("app: interrupted");
                 cancel_all_services();
             }
+            else if (sig == SIGHUP)
+            {
+                spdlog::info("app: reloading ip filter");
+                listener_.reload_filter();
+                signals_.async_wait([this](error_code const &ec, int sig) { handle_signal(ec, sig); });
+            }
             else
             {
-                std::clog << "app: unexpected signal " << sig << std::endl;
+                spdlog::error("app: unexpected signal {}", sig);
                 cancel_all_services();
             }
         }
@@ -79,9 +90,19 @@ namespace gateway
             cancel_all_services();
         }
 
-        void start_all_services() { listener_.start(); }
+        void start_all_services()
+        {
+            if (config_.timeouts)
+                config_.timeouts->start();
+            listener_.start();
+        }
 
-        void cancel_all_services() { listener_.cancel(); }
+        void cancel_all_services()
+        {
+            listener_.cancel();
+            if (config_.timeouts)
+                config_.timeouts->stop();
+        }
 
         app_config const &config_;
 
@@ -8,8 +8,10 @@
 #include "minecraft/server/chat_message.hpp"
 #include "minecraft/server/join_game.hpp"
 #include "minecraft/server/play_packet.hpp"
+#include "minecraft/utils/logging.hpp"
 #include "polyfill/explain.hpp"
 #include "polyfill/hexdump.hpp"
+#include "polyfill/net/disconnect.hpp"
 #include "polyfill/report.hpp"
 
 #include <random>
@@ -21,6 +23,11 @@ namespace gateway
 
     namespace
     {
+        // Limits the messages logged for every connection, so that a flood of pings cannot flood the log
+        minecraft::utils::log_limiter ping_log;
+        minecraft::utils::log_limiter login_log;
+        minecraft::utils::log_limiter timeout_log;
+
         std::string generate_server_id()
         {
             auto rng   = std::random_device();
@@ -35,12 +42,25 @@ namespace gateway
             return result;
         }
 
+        auto default_status() -> minecraft::protocol::status_info
+        {
+            auto result           = minecraft::protocol::status_info();
+            result.max_players    = 1000000000;
+            result.online_players = 1000000;
+            result.description    = "Welcome to Awesomeness!";
+            return result;
+        }
+
     }   // namespace
 
     connection_config::connection_config()
     : server_key()
     , server_id(generate_server_id())
     , compression_threshold(256)
+    , status(std::make_shared< minecraft::protocol::status_cache >(default_status()))
+    , timeouts()
+    , login_timeout(30)
+    , idle_timeout(30)
     {
         server_key.emplace();
         server_key->assign(minecraft::security::rsa(1024));
@@ -49,10 +69,13 @@ namespace gateway
     auto operator<<(std::ostream &os, connection_config const &cfg) -> std::ostream &
     {
         fmt::print(
-            "[connection_config [server_id {}] [server_key {:n}] [compression_threshold {}]",
+            "[connection_config [server_id {}] [server_key {:n}] [compression_threshold {}] [login_timeout {}s] "
+            "[idle_timeout {}s]",
             cfg.server_id,
             spdlog::to_hex(cfg.server_key.has_value() ? cfg.server_key->public_asn1() : std::vector< std::uint8_t >()),
-            cfg.compression_threshold);
+            cfg.compression_threshold,
+            cfg.login_timeout.count(),
+            cfg.idle_timeout.count());
         return os;
     }
 
@@ -60,8 +83,8 @@ namespace gateway
 
     connection_impl::connection_impl(connection_config config, socket_type &&sock)
     : config_(std::move(config))
-    , stream_(std::move(sock))
-    , login_params_(config_.server_id, config_.server_key)
+    , deadline_([this] { handle_timeout(); })
+    , prelogin_(std::move(sock))
     {
     }
 
@@ -94,18 +117,21 @@ namespace gateway
 
     auto connection_impl::run() -> net::awaitable< void >
     {
+        set_deadline(config_.login_timeout);
+
         //
         // handle handshake and/or server ping
         //
 
-        if (co_await minecraft::protocol::async_is_old_style_ping(stream_.next_layer(), net::use_awaitable))
-            co_return spdlog::info("old style ping request..."),
-                co_await async_old_style_ping(stream_, net::use_awaitable);
+        if (co_await minecraft::protocol::async_is_old_style_ping(prelogin_, net::use_awaitable))
+            co_return ping_log.info("old style ping request..."),
+                co_await async_old_style_ping(prelogin_, *config_.status, net::use_awaitable);
         else
-            switch (co_await minecraft::protocol::async_server_handshake(stream_, net::use_awaitable))
+            switch (co_await minecraft::protocol::async_server_handshake(prelogin_, net::use_awaitable))
             {
             case minecraft::protocol::connection_state::status:
-                co_return co_await minecraft::protocol::async_server_status(stream_, net::use_awaitable);
+                co_return co_await minecraft::protocol::async_server_status(
+                    prelogin_, *config_.status, net::use_awaitable);
             default:
                 co_return spdlog::error("logic error"), void();
             case minecraft::protocol::connection_state::login:
@@ -114,25 +140,25 @@ namespace gateway
 
         //        initiate_read();
 
-        try
-        {
-            co_await minecraft::protocol::async_server_accept(stream_, this->login_params_, net::use_awaitable);
-            spdlog::info("Welcome! {} on {}", std::quoted(stream_.player_name()), stream_.full_info());
-        }
-        catch (system_error &se)
+        stream_.emplace(prelogin_.upgrade());
+        login_params_.emplace(config_.server_id, config_.server_key);
+
+        auto ec = error_code();
+        co_await minecraft::protocol::async_server_accept(
+            *stream_, *login_params_, net::redirect_error(net::use_awaitable, ec));
+        if (ec.failed())
         {
-            auto &&ec = se.code();
-            if (ec.failed())
-            {
-                spdlog::error("{}::{}({}) on {} with params {}",
-                              this,
-                              __func__,
-                              polyfill::report(ec),
-                              stream_.full_info(),
-                              login_params_);
-                co_return;
-            }
+            spdlog::error("{}::{}({}) on {} with params {}\nrecent frames:\n{}",
+                          this,
+                          __func__,
+                          polyfill::report(ec),
+                          stream_->full_info(),
+                          *login_params_,
+                          to_string(stream_->recent_frames()));
+            co_return;
         }
+        login_log.info("Welcome! {} on {}", std::quoted(stream_->player_name()), stream_->full_info());
+        set_deadline(config_.idle_timeout);
 
         {   // Send join game packet
             auto packet                  = minecraft::server::join_game();
@@ -145,13 +171,17 @@ namespace gateway
             packet.view_distance         = 16;
             packet.reduced_debug_info    = false;
             packet.enable_respawn_screen = true;
-            co_await async_write_packet(packet);
+            co_await async_write_packet(packet, ec);
+            if (ec.failed())
+                co_return;
         }
 
         {   // Send a spawn packet
             auto pack     = minecraft::server::spawn_position();
             pack.location = { 0, 60, 0 };
-            co_await async_write_packet(pack);
+            co_await async_write_packet(pack, ec);
+            if (ec.failed())
+                co_return;
         }
 
         {   // Send a player position and look packet
@@ -163,7 +193,9 @@ namespace gateway
             pack.pitch = 0.0f;
             pack.set_flags(false, false, false, false, false);
             pack.teleport_ID = 666;
-            co_await async_write_packet(pack);
+            co_await async_write_packet(pack, ec);
+            if (ec.failed())
+                co_return;
         }
 
         {   // Await a teleport confirm packet
@@ -175,38 +207,45 @@ namespace gateway
             auto pack      = minecraft::server::chat_message();
             pack.json_data = R"json({ "text" : "Hello, World!", "bold" : true })json";
             pack.position  = minecraft::server::chat_message::chat_position ::system_message;
-            co_await async_write_packet(pack);
+            co_await async_write_packet(pack, ec);
+            if (ec.failed())
+                co_return;
         }
 
-        // Spin
+        // Spin until the client goes away
         while (true)
         {
-            try
-            {
-                auto bt = co_await stream_.async_read_frame(net::use_awaitable);
-
-                auto id    = std::int32_t();
-                auto data  = stream_.current_frame();
-                auto buf   = minecraft::to_span(data);
-                auto first = buf.begin();
-                auto last  = buf.end();
-                auto ec    = boost::system::error_code();
-                auto i     = minecraft::parse_var(first, last, id, ec);
-                boost::ignore_unused(i);
-
-                spdlog::info("{}::{}({}) - frame length={}, type={}, dump={:n}",
-                             this,
-                             __func__,
-                             polyfill::report(ec),
-                             bt,
-                             id,
-                             spdlog::to_hex(config::to_span(data)));
-            }
-            catch (system_error &se)
+            auto bt = co_await stream_->read_frame(ec);
+            if (ec.failed())
             {
-                auto &&ec = se.code();
-                spdlog::warn("{}::{}({})", this, __func__, polyfill::report(ec));
+                if (polyfill::net::is_disconnect(ec))
+                    spdlog::debug("{}::{}({})", this, __func__, polyfill::report(ec));
+                else
+                    spdlog::warn("{}::{}({})\nrecent frames:\n{}",
+                                 this,
+                                 __func__,
+                                 polyfill::report(ec),
+                                 to_string(stream_->recent_frames()));
+                co_return;
             }
+
+            auto id    = std::int32_t();
+            auto data  = stream_->current_frame();
+            auto buf   = minecraft::to_span(data);
+            auto first = buf.begin();
+            auto last  = buf.end();
+            auto i     = minecraft::parse_var(first, last, id, ec);
+            boost::ignore_unused(i);
+            set_deadline(config_.idle_timeout);
+
+            log_.info("{}::{}({}) - frame length={}, type={}, dump={:n}",
+                      this,
+                      __func__,
+                      polyfill::report(ec),
+                      bt,
+                      id,
+                      spdlog::to_hex(config::to_span(data)));
+            ec.clear();
         }
     }
 
@@ -215,9 +254,26 @@ namespace gateway
         dispatch(bind_executor(get_executor(), [self = shared_from_this()] { self->handle_cancel(); }));
     }
 
-    auto connection_impl::get_executor() -> executor_type { return stream_.get_executor(); }
+    auto connection_impl::get_executor() -> executor_type { return prelogin_.get_executor(); }
 
-    auto connection_impl::handle_cancel() -> void { stream_.close(); }
+    auto connection_impl::handle_cancel() -> void
+    {
+        prelogin_.close();
+        if (stream_)
+            stream_->close();
+    }
+
+    auto connection_impl::set_deadline(std::chrono::seconds timeout) -> void
+    {
+        if (config_.timeouts)
+            config_.timeouts->arm(deadline_, timeout);
+    }
+
+    auto connection_impl::handle_timeout() -> void
+    {
+        timeout_log.info("{} timed out", this);
+        handle_cancel();
+    }
 
     template < class NextLayer, class Iter, class CompletionToken >
     auto
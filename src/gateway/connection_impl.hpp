@@ -1,8 +1,12 @@
 #pragma once
 
+#include "minecraft/protocol/prelogin_stream.hpp"
 #include "minecraft/protocol/server_accept.hpp"
+#include "minecraft/protocol/status_cache.hpp"
 #include "minecraft/security/private_key.hpp"
+#include "minecraft/utils/logging.hpp"
 #include "net.hpp"
+#include "polyfill/net/timer_wheel.hpp"
 
 #include <minecraft/protocol/stream.hpp>
 
@@ -15,6 +19,19 @@ namespace gateway
         std::optional< minecraft::security::private_key > server_key;
         std::string                                       server_id;
         int                                               compression_threshold;
+
+        /// Shared by all connections
+        std::shared_ptr< minecraft::protocol::status_cache > status;
+
+        /// Expires stalled connections. Shared by all connections. Without it connections never time out.
+        std::shared_ptr< polyfill::net::timer_wheel > timeouts;
+
+        /// Longest time from accept to the end of the handshake, status exchange or login
+        std::chrono::seconds login_timeout;
+
+        /// Longest time a player in the game may send nothing
+        std::chrono::seconds idle_timeout;
+
         friend auto operator<<(std::ostream &os, connection_config const &cfg) -> std::ostream &;
     };
 
@@ -23,6 +40,7 @@ namespace gateway
         using executor_type      = net::io_context::executor_type;
         using transport_protocol = net::ip::tcp;
         using socket_type        = net::basic_stream_socket< transport_protocol, executor_type >;
+        using prelogin_type      = minecraft::protocol::prelogin_stream< socket_type >;
         using stream_type        = minecraft::protocol::stream< socket_type >;
 
         explicit connection_impl(connection_config config, socket_type &&sock);
@@ -37,42 +55,51 @@ namespace gateway
         template < class Stream >
         friend Stream &operator<<(Stream &os, connection_impl const &i)
         {
-            os << "[connection " << minecraft::report(i.stream_.next_layer()) << ']';
+            os << "[connection " << minecraft::report(i.client_socket()) << ']';
             return os;
         }
 
         template < class Stream >
         friend Stream &operator<<(Stream &os, connection_impl *p)
         {
-            os << "[connection " << minecraft::report(p->stream_.next_layer()) << ']';
+            os << "[connection " << minecraft::report(p->client_socket()) << ']';
             return os;
         }
 
       private:
         net::awaitable< void > run();
         auto                   handle_cancel() -> void;
+        auto                   set_deadline(std::chrono::seconds timeout) -> void;
+        auto                   handle_timeout() -> void;
+
+        auto client_socket() const -> socket_type const &
+        {
+            return stream_ ? stream_->next_layer() : prelogin_.next_layer();
+        }
 
         template < class Packet >
-        auto async_write_packet(Packet const &p) -> net::awaitable< void >
+        auto async_write_packet(Packet const &p, error_code &ec) -> net::awaitable< void >
         {
-            try
-            {
-                co_await stream_.async_write_packet(p, net::use_awaitable);
-                spdlog::info("{}::{}({})", this, "async_write_packet", minecraft::report(error_code()));
-            }
-            catch (system_error &se)
-            {
-                auto &&ec = se.code();
+            co_await stream_->write_packet(p, ec);
+            if (ec.failed())
                 spdlog::warn("{}::{}({})", this, "async_write_packet", minecraft::report(ec));
-            }
+            else
+                spdlog::info("{}::{}({})", this, "async_write_packet", minecraft::report(ec));
         }
 
         connection_config config_;
 
-        stream_type         stream_;
-        std::vector< char > compose_buffer_;
+        polyfill::net::timer_wheel::entry deadline_;   //! armed in the wheel in config_, so declared after it
+
+        // The full protocol stream is only allocated once the client selects login
+        prelogin_type                prelogin_;
+        std::optional< stream_type > stream_;
+        std::vector< char >          compose_buffer_;
+
+        std::optional< minecraft::protocol::server_accept_state > login_params_;
 
-        minecraft::protocol::server_accept_state login_params_;
+        // Every play frame is logged with a dump, so the rate is limited for each connection
+        minecraft::utils::log_limiter log_;
     };
 
 }   // namespace gateway
@@ -1,10 +1,13 @@
 #pragma once
 
+#include "application/ip_filter.hpp"
 #include "config/net.hpp"
 #include "connection_cache.hpp"
 #include "minecraft/security/private_key.hpp"
+#include "minecraft/utils/logging.hpp"
 
 #include <iostream>
+#include <memory>
 
 namespace gateway {
     struct listener_config : connection_config
@@ -16,6 +19,13 @@ namespace gateway {
 
         std::string listen_port = "25565";
 
+        /// Optional file of allow/deny rules consulted before a connection is accepted. See application::ip_filter.
+        std::string ip_filter_file;
+
+        /// A socket which is already listening, for example one inherited from a supervisor. If set, listen_port
+        /// is not bound.
+        int listen_handle = -1;
+
         friend auto operator<<(std::ostream& os, listener_config const& cfg) -> std::ostream&;
     };
 
@@ -46,8 +56,13 @@ namespace gateway {
             }));
         }
 
+        /// Reload the rules in config.ip_filter_file. The file is parsed away from the io thread and the new rules
+        /// take effect for connections accepted after it has been parsed. On error the current rules are retained.
+        void
+        reload_filter();
+
         auto
-        get_executor() -> net::executor
+        get_executor() -> executor_type
         {
             return acceptor_.get_executor();
         }
@@ -64,7 +79,9 @@ namespace gateway {
         handle_cancel();
 
         listener_config config_;
+        std::shared_ptr<application::ip_filter_handle> filter_;
         acceptor_type acceptor_;
         connection_cache connections_;
+        minecraft::utils::log_limiter accept_log_ {20, 50};
     };
 }
@@ -1,5 +1,6 @@
 #include "config/net.hpp"
 #include "application.hpp"
+#include "application/supervisor.hpp"
 #include "polyfill/explain.hpp"
 
 #include <iostream>
@@ -9,35 +10,86 @@
 
 namespace gateway
 {
-    void run()
+    void run(app_config config)
     {
-        namespace po = boost::program_options;
-
-        app_config config;
-
-
-
+        minecraft::utils::install_logger(config.logging);
 
         auto ioc = net::io_context(1);
         auto exec = ioc.get_executor();
 
+        config.timeouts = std::make_shared< polyfill::net::timer_wheel >(exec);
+
         auto app = application(exec, config);
         app.start();
 
 
+        ioc.run();
+        minecraft::utils::shutdown_logger();
+    }
+
+    /// Run `workers` gateways in child processes which share one listening socket, restarting any which fail
+    void run_workers(app_config config, std::size_t workers)
+    {
+        config.listen_handle = ::application::open_shared_listener(config.listen_port);
+
+        auto ioc = net::io_context(1);
+        auto sup = ::application::supervisor(ioc, { workers }, [&config](::application::worker_context) {
+            run(config);
+            return 0;
+        });
+        sup.start();
+
         ioc.run();
     }
 
 }
 
-int main()
+int main(int argc, char **argv)
 {
     using polyfill::explain;
     using polyfill::deduce_return_code;
 
+    namespace po = boost::program_options;
+
     try
     {
-        gateway::run();
+        gateway::app_config config;
+        auto                workers       = std::size_t();
+        auto                login_timeout = int();
+        auto                idle_timeout  = int();
+        auto                desc          = po::options_description();
+        desc.add_options()(
+            "ip-filter", po::value(&config.ip_filter_file), "file of allow/deny address rules, reloaded on SIGHUP")(
+            "login-timeout",
+            po::value(&login_timeout)->default_value(int(config.login_timeout.count())),
+            "seconds a client may take over the handshake, a status request or logging in")(
+            "idle-timeout",
+            po::value(&idle_timeout)->default_value(int(config.idle_timeout.count())),
+            "seconds a player in the game may send nothing before being disconnected")(
+            "log-queue",
+            po::value(&config.logging.queue_size)->default_value(config.logging.queue_size),
+            "log messages which may wait to be written, after which the oldest are dropped. 0 logs synchronously")(
+            "workers",
+            po::value(&workers)->default_value(0),
+            "run this many gateway processes sharing the port, supervised by this one. 0 runs a single gateway in "
+            "this process")("help,-?", "show this help");
+
+        auto vm = po::variables_map();
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        if (vm.count("help"))
+        {
+            std::cout << desc << std::endl;
+            std::exit(0);
+        }
+        po::notify(vm);
+
+        config.login_timeout = std::chrono::seconds(login_timeout);
+        config.idle_timeout  = std::chrono::seconds(idle_timeout);
+
+        if (workers)
+            gateway::run_workers(std::move(config), workers);
+        else
+            gateway::run(std::move(config));
         return 0;
     }
     catch(...)
@@ -45,4 +97,4 @@ int main()
         std::cerr << explain() << std::endl;
         return deduce_return_code();
     }
-}
\ No newline at end of file
+}
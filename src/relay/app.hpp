@@ -1,9 +1,21 @@
 #pragma once
+#include "application/admin_server.hpp"
 #include "application/console.hpp"
+#include "application/loop_monitor.hpp"
+#include "application/metrics_server.hpp"
+#include "application/supervisor.hpp"
 #include "config/net.hpp"
 #include "listener.hpp"
+#include "minecraft/protocol/packet_profile.hpp"
+#include "minecraft/protocol/packet_trace.hpp"
+#include "minecraft/protocol/timeline_trace.hpp"
 #include "minecraft/security/private_key.hpp"
 #include "minecraft/security/rsa.hpp"
+#include "minecraft/utils/logging.hpp"
+#include "polyfill/timestamp.hpp"
+#include "status_service.hpp"
+
+#include <sstream>
 
 namespace relay
 {
@@ -11,9 +23,45 @@ namespace relay
     {
         auto as_listener_config() const -> listener_config const & { return *this; }
 
+        int status_refresh_seconds = 5;
+
+        /// False when running as one of several worker processes, which must not share the terminal
+        bool interactive = true;
+
+        /// When running as a worker process, the pipe on which to report stats to the supervisor
+        int stats_fd = -1;
+
+        /// Port on the loopback interface on which to serve Prometheus metrics. Empty for none.
+        std::string metrics_port;
+
+        /// Watches the event loop for blocking handlers. A zero threshold disables the monitor.
+        application::loop_monitor_config loop_monitor;
+
+        minecraft::utils::logging_config logging;
+
+        /// File into which traced connections record their frames. Empty for none.
+        std::string trace_file;
+        std::size_t trace_records = 1 << 20;
+
+        /// File into which the login timelines of sampled connections are written, for viewing in Perfetto. Empty
+        /// for none. One connection in `timeline_sample` is sampled, as are the players selected by the timeline
+        /// command.
+        std::string   timeline_file;
+        std::uint32_t timeline_sample = 100;
+
+        /// Path of the Unix domain socket on which to serve admin commands. Empty for none.
+        std::string admin_socket;
+
         friend auto operator<<(std::ostream &os, app_config const &cfg) -> std::ostream &
         {
             os << "Application Config\n";
+            os << "\tstatus refresh : " << cfg.status_refresh_seconds << "s\n";
+            os << "\tmetrics port   : " << (cfg.metrics_port.empty() ? "none" : cfg.metrics_port) << '\n';
+            os << "\tstall threshold: " << cfg.loop_monitor.threshold.count() << "ms\n";
+            os << "\tlog queue      : " << cfg.logging.queue_size << '\n';
+            os << "\ttrace file     : " << (cfg.trace_file.empty() ? "none" : cfg.trace_file) << '\n';
+            os << "\ttimeline file  : " << (cfg.timeline_file.empty() ? "none" : cfg.timeline_file) << '\n';
+            os << "\tadmin socket   : " << (cfg.admin_socket.empty() ? "none" : cfg.admin_socket) << '\n';
             os << cfg.as_listener_config();
             return os;
         }
@@ -23,16 +71,63 @@ namespace relay
     {
         using executor_type = net::io_context::executor_type;
         using signal_set    = net::basic_signal_set< executor_type >;
+        using timer_type    = net::basic_waitable_timer< std::chrono::steady_clock,
+                                                      net::wait_traits< std::chrono::steady_clock >,
+                                                      executor_type >;
 
         app(executor_type exec, app_config config)
         : config_(std::move(config))
         , signals_(exec)
         , listener_(exec, config_)
+        , status_(exec,
+                  { { config_.upstream_host, config_.upstream_port } },
+                  std::chrono::seconds(config_.status_refresh_seconds),
+                  config_.status)
         , console_(exec, ::dup(0))
+        , drain_timer_(exec)
         {
             std::cout << "Application Starting\n\n";
             std::cout << config_ << std::endl;
             signals_.add(SIGINT);
+            signals_.add(SIGHUP);
+            if (not config_.admin_socket.empty())
+                admin_.emplace(exec, config_.admin_socket);
+            add_command("stats", [this](std::string_view, std::ostream &os) { this->print_stats(os); });
+            add_command("latency", [this](std::string_view, std::ostream &os) { this->print_latency(os); });
+            add_command("profile reset", [](std::string_view, std::ostream &os) {
+                minecraft::protocol::packet_profile::global().reset();
+                os << "profile: reset\n";
+            });
+            add_command("profile cpu", [](std::string_view, std::ostream &os) {
+                print_profile(os, minecraft::protocol::packet_profile::order::cpu);
+            });
+            add_command("profile", [](std::string_view, std::ostream &os) {
+                print_profile(os, minecraft::protocol::packet_profile::order::bytes);
+            });
+            add_command("top", [this](std::string_view args, std::ostream &os) { this->print_top(args, os); });
+            add_command("connections",
+                        [this](std::string_view args, std::ostream &os) { this->print_connections(args, os); });
+            add_command("kick", [this](std::string_view args, std::ostream &os) { this->kick(args, os); });
+            add_command("drain", [this](std::string_view, std::ostream &os) { this->drain(os); });
+            add_command("set-log-level",
+                        [](std::string_view args, std::ostream &os) { set_log_level(args, os); });
+            add_command("trace", [this](std::string_view args, std::ostream &os) { this->set_trace(args, os); });
+            add_command("frames", [this](std::string_view args, std::ostream &os) { this->print_frames(args, os); });
+            add_command("timeline", [](std::string_view args, std::ostream &os) { select_timeline(args, os); });
+            if (not config_.trace_file.empty())
+                minecraft::protocol::packet_trace::global().open(config_.trace_file, config_.trace_records);
+            if (not config_.timeline_file.empty())
+                minecraft::protocol::timeline_trace::global().open(
+                    config_.timeline_file, config_.timeline_sample, "relay");
+            if (config_.stats_fd >= 0)
+                stats_.emplace(exec, config_.stats_fd, std::chrono::seconds(1), [this](application::worker_stats &s) {
+                    this->collect_stats(s);
+                });
+            if (not config_.metrics_port.empty())
+                metrics_.emplace(exec, config_.metrics_port);
+            if (config_.loop_monitor.threshold.count() > 0)
+                monitor_.emplace(exec, config_.loop_monitor);
+            register_metrics();
         }
 
         void start()
@@ -65,16 +160,226 @@ namespace relay
             }
             else if (sig == SIGINT)
             {
-                std::clog << "app: interrupted" << std::endl;
+                spdlog::info("app: interrupted");
                 cancel_all_services();
             }
+            else if (sig == SIGHUP)
+            {
+                spdlog::info("app: reloading ip filter");
+                listener_.reload_filter();
+                signals_.async_wait([this](error_code const &ec, int sig) { handle_signal(ec, sig); });
+            }
             else
             {
-                std::clog << "app: unexpected signal " << sig << std::endl;
+                spdlog::error("app: unexpected signal {}", sig);
                 cancel_all_services();
             }
         }
 
+        /// Publish the state of the shared services. The metrics are sampled on the scraping thread, which is this
+        /// one, and the samplers keep the services alive for the life of the registry.
+        void register_metrics()
+        {
+            auto &reg = polyfill::metrics::registry::global();
+            reg.gauge("relay_admission_waiting",
+                      "Players waiting for admission",
+                      {},
+                      [admission = config_.admission] { return std::int64_t(admission->waiting()); });
+            reg.gauge("relay_admission_in_flight",
+                      "Players admitted and logging in to the upstream server",
+                      {},
+                      [admission = config_.admission] { return std::int64_t(admission->in_flight()); });
+            reg.gauge("relay_timeouts_armed", "Connections with a login or idle deadline", {}, [wheel = config_.timeouts] {
+                return wheel ? std::int64_t(wheel->size()) : std::int64_t(0);
+            });
+        }
+
+        /// Offer a command on the console and, if there is one, the admin socket
+        void add_command(std::string const &name, application::admin_server::handler_type handler)
+        {
+            if (admin_)
+                admin_->add_command(name, handler);
+            console_.add_command(name, std::move(handler));
+        }
+
+        void print_stats(std::ostream &os)
+        {
+            os << "Forwarding\n" << *config_.forwarding;
+            os << "Admission\n\tin flight : " << config_.admission->in_flight()
+               << ", waiting : " << config_.admission->waiting() << ", limit : " << config_.admission->limit() << '\n';
+        }
+
+        void print_latency(std::ostream &os)
+        {
+            os << "Forwarding latency (" << polyfill::timestamp::selected() << " clock)\n" << *config_.latency;
+        }
+
+        static void print_profile(std::ostream &os, minecraft::protocol::packet_profile::order by)
+        {
+            os << "Packet profile\n";
+            minecraft::protocol::packet_profile::global().write_table(os, by);
+        }
+
+        /// "top [column] [n]": the `n` players with the highest usage in `column`, by default the 10 using the most
+        /// cpu
+        void print_top(std::string_view args, std::ostream &os)
+        {
+            auto is   = std::istringstream(std::string(args));
+            auto name = std::string("cpu");
+            auto n    = std::size_t(10);
+            if (not args.empty())
+                is >> name;
+            if (not is.eof())
+                is >> n;
+            auto column = connection_usage::parse_column(name);
+            if (not column or is.fail())
+            {
+                os << "usage: top [in|out|frames|compression|cipher|handler|cpu] [n]\n";
+                return;
+            }
+            os << "Top " << n << " connections by " << name << '\n';
+            write_top(os, listener_.usage(), *column, n);
+        }
+
+        /// "connections [player=<text>] [address=<prefix>] [sort=<column>] [limit=<n>]": the logged in players
+        /// selected by a connection_query
+        void print_connections(std::string_view args, std::ostream &os)
+        {
+            auto query = connection_query::parse(args);
+            if (not query)
+            {
+                os << "usage: connections [player=<text>] [address=<prefix>] [sort=<column>] [limit=<n>]\n";
+                return;
+            }
+            auto usage = listener_.usage();
+            std::erase_if(usage, [&query](connection_usage const &u) { return not query->matches(u); });
+            os << usage.size() << " players selected of " << listener_.connection_count() << " connections\n";
+            write_top(os, std::move(usage), query->sort, query->limit);
+        }
+
+        /// "kick <player>": disconnect a player
+        void kick(std::string_view player, std::ostream &os)
+        {
+            if (player.empty())
+                os << "usage: kick <player>\n";
+            else
+                os << "kick: " << listener_.kick(player) << " connections of " << player << " closed\n";
+        }
+
+        /// "drain": stop accepting connections, and stop once those already accepted have ended. A worker
+        /// process which is drained is then restarted by the supervisor.
+        void drain(std::ostream &os)
+        {
+            if (not draining_)
+            {
+                draining_ = true;
+                listener_.drain();
+                await_drained();
+            }
+            os << "drain: " << listener_.connection_count() << " connections remaining\n";
+        }
+
+        void await_drained()
+        {
+            if (listener_.connection_count() == 0)
+            {
+                // posted, so that a "drain" command which finds nothing to wait for is answered before the admin
+                // socket is closed
+                spdlog::info("app: drained");
+                post(bind_executor(get_executor(), [this] { this->handle_cancel(); }));
+                return;
+            }
+            drain_timer_.expires_after(std::chrono::seconds(1));
+            drain_timer_.async_wait([this](error_code const &ec) {
+                if (not ec.failed())
+                    this->await_drained();
+            });
+        }
+
+        /// "set-log-level <level>": change the level of the log, for example to debug a problem as it happens
+        static void set_log_level(std::string_view name, std::ostream &os)
+        {
+            auto level = spdlog::level::from_str(std::string(name));
+            if (level == spdlog::level::off and name != "off")
+            {
+                os << "usage: set-log-level trace|debug|info|warning|error|critical|off\n";
+                return;
+            }
+            spdlog::set_level(level);
+            auto lsv = to_string_view(level);
+            os << "log level: " << std::string_view(lsv.data(), lsv.size()) << '\n';
+        }
+
+        /// "trace on|off [player]": start or stop the packet trace of a player, or of every player logged in now
+        void set_trace(std::string_view args, std::ostream &os)
+        {
+            auto on = boost::istarts_with(args, "on");
+            if (not on and not boost::istarts_with(args, "off"))
+            {
+                os << "usage: trace on|off [player]\n";
+                return;
+            }
+            auto player = boost::trim_copy(std::string(args.substr(on ? 2 : 3)));
+
+            auto &trace = minecraft::protocol::packet_trace::global();
+            if (not trace.is_open())
+                os << "trace: no trace file, see --trace-file\n";
+            else
+                os << "trace: " << (on ? "started" : "stopped") << " on " << listener_.trace(player, on)
+                   << " connections, recording to " << trace.path() << '\n';
+        }
+
+        /// "timeline on|off <player>": write the login timelines of a player's future connections, as well as those
+        /// sampled
+        static void select_timeline(std::string_view args, std::ostream &os)
+        {
+            auto on     = boost::istarts_with(args, "on");
+            auto player = boost::trim_copy(std::string(args.substr(std::min(args.size(), std::size_t(on ? 2 : 3)))));
+            if ((not on and not boost::istarts_with(args, "off")) or player.empty())
+            {
+                os << "usage: timeline on|off <player>\n";
+                return;
+            }
+
+            auto &timelines = minecraft::protocol::timeline_trace::global();
+            if (not timelines.is_open())
+                os << "timeline: no timeline file, see --timeline-file\n";
+            else
+            {
+                timelines.select(player, on);
+                os << "timeline: " << player << (on ? " selected" : " deselected") << ", writing to "
+                   << timelines.path() << '\n';
+            }
+        }
+
+        /// "frames <player>": the last frames read and written on the connections of a player
+        void print_frames(std::string_view player, std::ostream &os)
+        {
+            if (player.empty())
+            {
+                os << "usage: frames <player>\n";
+                return;
+            }
+            auto frames = listener_.recent_frames(player);
+            if (frames.empty())
+                os << "frames: " << player << " is not connected\n";
+            else
+                os << "Recent frames of " << player << '\n' << frames;
+        }
+
+        void collect_stats(application::worker_stats &s)
+        {
+            auto &fwd                    = *config_.forwarding;
+            s["client_to_server.frames"] = fwd.client_to_server.frames.value();
+            s["client_to_server.bytes"]  = fwd.client_to_server.bytes.value();
+            s["client_to_server.yields"] = fwd.client_to_server.yields.value();
+            s["server_to_client.frames"] = fwd.server_to_client.frames.value();
+            s["server_to_client.bytes"]  = fwd.server_to_client.bytes.value();
+            s["server_to_client.yields"] = fwd.server_to_client.yields.value();
+            s["admission.in_flight"]     = std::int64_t(config_.admission->in_flight());
+            s["admission.waiting"]       = std::int64_t(config_.admission->waiting());
+        }
+
         void handle_cancel()
         {
             signals_.cancel();
@@ -83,18 +388,42 @@ namespace relay
 
         void start_all_services()
         {
+            if (config_.timeouts)
+                config_.timeouts->start();
             listener_.start();
-            console_.start([this]{
-                dispatch(bind_executor(this->get_executor(), [this]{
-                    this->cancel_all_services();
-                    this->signals_.cancel();
-                }));
-            });
+            status_.start();
+            if (stats_)
+                stats_->start();
+            if (metrics_)
+                metrics_->start();
+            if (monitor_)
+                monitor_->start();
+            if (admin_)
+                admin_->start();
+            if (config_.interactive)
+                console_.start([this]{
+                    dispatch(bind_executor(this->get_executor(), [this]{
+                        this->cancel_all_services();
+                        this->signals_.cancel();
+                    }));
+                });
         }
 
         void cancel_all_services()
         {
             listener_.cancel();
+            status_.cancel();
+            if (config_.timeouts)
+                config_.timeouts->stop();
+            if (stats_)
+                stats_->stop();
+            if (metrics_)
+                metrics_->stop();
+            if (monitor_)
+                monitor_->stop();
+            if (admin_)
+                admin_->stop();
+            drain_timer_.cancel();
             console_.stop();
         }
 
@@ -102,6 +431,14 @@ namespace relay
 
         signal_set           signals_;
         listener             listener_;
+        status_service       status_;
         application::console console_;
+        timer_type           drain_timer_;
+        bool                 draining_ = false;
+
+        std::optional< application::stats_publisher > stats_;
+        std::optional< application::metrics_server >  metrics_;
+        std::optional< application::loop_monitor >    monitor_;
+        std::optional< application::admin_server >    admin_;
     };
 }   // namespace relay
\ No newline at end of file
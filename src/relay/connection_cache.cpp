@@ -1,5 +1,8 @@
 #include "connection_cache.hpp"
 
+#include <spdlog/spdlog.h>
+#include <sstream>
+
 namespace relay
 {
     void connection_cache::create(connection_config config, socket_type &&sock)
@@ -13,6 +16,66 @@ namespace relay
         cache_[ep] = conn.get_weak_impl();
     }
 
+    auto connection_cache::usage() -> std::vector< connection_usage >
+    {
+        auto result = std::vector< connection_usage >();
+        for (auto iter = cache_.begin(); iter != cache_.end();)
+        {
+            auto p = iter->second.lock();
+            if (not p)
+            {
+                iter = cache_.erase(iter);
+                continue;
+            }
+            if (auto u = p->usage(); not u.player.empty())
+            {
+                auto os = std::ostringstream();
+                os << iter->first;
+                u.endpoint = os.str();
+                result.push_back(std::move(u));
+            }
+            ++iter;
+        }
+        return result;
+    }
+
+    auto connection_cache::trace(std::string_view player, bool on) -> std::size_t
+    {
+        auto count = std::size_t(0);
+        for (auto &[ep, weak] : cache_)
+            if (auto p = weak.lock(); p and p->trace(player, on))
+                ++count;
+        return count;
+    }
+
+    auto connection_cache::recent_frames(std::string_view player) -> std::string
+    {
+        auto os = std::ostringstream();
+        for (auto &[ep, weak] : cache_)
+            if (auto p = weak.lock(); p and p->player_name() == player)
+                os << ep << '\n' << p->recent_frames();
+        return os.str();
+    }
+
+    auto connection_cache::kick(std::string_view player) -> std::size_t
+    {
+        auto count = std::size_t(0);
+        for (auto &[ep, weak] : cache_)
+            if (auto p = weak.lock(); p and not player.empty() and p->player_name() == player)
+            {
+                spdlog::info("{} kicked", *p);
+                p->cancel();
+                ++count;
+            }
+        return count;
+    }
+
+    auto connection_cache::live() -> std::size_t
+    {
+        std::erase_if(cache_, [](auto const &entry) { return entry.second.expired(); });
+        return cache_.size();
+    }
+
     void connection_cache::cancel()
     {
         canceled_ = true;
@@ -15,6 +15,23 @@ namespace relay {
 
         void cancel();
 
+        /// The usage of every live connection which has reached login. Forgets connections which have ended.
+        auto usage() -> std::vector<connection_usage>;
+
+        /// Start or stop the packet trace of the connections of `player`, or of every logged in player if empty.
+        /// \return the number of connections selected
+        auto trace(std::string_view player, bool on) -> std::size_t;
+
+        /// The recent frames of each connection of `player`, headed by its endpoint
+        auto recent_frames(std::string_view player) -> std::string;
+
+        /// Cancel the connections of `player`
+        /// \return the number of connections cancelled
+        auto kick(std::string_view player) -> std::size_t;
+
+        /// The number of connections which have not ended. Forgets those which have.
+        auto live() -> std::size_t;
+
 
         using by_endpoint_map = std::unordered_map<protocol::endpoint,
             std::weak_ptr<connection_impl>,
@@ -4,14 +4,19 @@
 #include "minecraft/protocol/old_style_ping.hpp"
 #include "minecraft/protocol/server_handshake.hpp"
 #include "minecraft/protocol/server_status.hpp"
+#include "minecraft/protocol/timeline_trace.hpp"
 #include "minecraft/report.hpp"
 #include "minecraft/security/rsa.hpp"
 #include "minecraft/send_frame.hpp"
 #include "minecraft/server/chat_message.hpp"
+#include "minecraft/server/keep_alive.hpp"
 #include "minecraft/server/play_packet.hpp"
 #include "minecraft/utils/exception_handler.hpp"
+#include "minecraft/utils/logging.hpp"
 #include "polyfill/explain.hpp"
 #include "polyfill/hexdump.hpp"
+#include "polyfill/net/disconnect.hpp"
+#include "polyfill/timestamp.hpp"
 
 #include <random>
 #include <spdlog/fmt/bin_to_hex.h>
@@ -37,12 +42,35 @@ namespace relay
             return result;
         }
 
+        // Keep alive ids sent by the relay itself are drawn from a range an upstream server is unlikely to use, so
+        // that the client's replies can be recognised and dropped.
+        constexpr std::int64_t waiting_keep_alive_base = 0x72656c6179000000;   // "relay"
+
+        // Messages which every connection logs are limited at each call site, so that a flood of connections or
+        // status pings cannot flood the log. Each relay process has one event loop.
+        minecraft::utils::log_limiter accept_log;
+        minecraft::utils::log_limiter ping_log;
+        minecraft::utils::log_limiter login_log;
+        minecraft::utils::log_limiter timeout_log;
+
+        std::uint64_t last_connection_id = 0;
+
     }   // namespace
 
     connection_config::connection_config()
     : server_key()
     , server_id(generate_server_id())
     , compression_threshold(256)
+    , status(std::make_shared< minecraft::protocol::status_cache >())
+    , admission(std::make_shared< application::admission_queue >())
+    , waiting_interval(5)
+    , timeouts()
+    , login_timeout(30)
+    , idle_timeout(30)
+    , frame_budget(32)
+    , byte_budget(64 * 1024)
+    , forwarding(std::make_shared< forwarding_stats >())
+    , latency(std::make_shared< forwarding_latency >())
     {
 
         auto& ppk = server_key.emplace();
@@ -53,10 +81,17 @@ namespace relay
     auto operator<<(std::ostream &os, connection_config const &cfg) -> std::ostream &
     {
         fmt::print(
-            "[connection_config [server_id {}] [server_key {:n}] [compression_threshold {}]",
+            "[connection_config [server_id {}] [server_key {:n}] [compression_threshold {}] [max_logins {}] "
+            "[login_latency {}ms] [login_timeout {}s] [idle_timeout {}s] [frame_budget {}] [byte_budget {}]",
             cfg.server_id,
             spdlog::to_hex(cfg.server_key.has_value() ? cfg.server_key->public_asn1() : std::vector< std::uint8_t >()),
-            cfg.compression_threshold);
+            cfg.compression_threshold,
+            cfg.admission->config().max_concurrent,
+            cfg.admission->config().target_latency.count(),
+            cfg.login_timeout.count(),
+            cfg.idle_timeout.count(),
+            cfg.frame_budget,
+            cfg.byte_budget);
         return os;
     }
 
@@ -64,21 +99,36 @@ namespace relay
 
     connection_impl::connection_impl(connection_config config, socket_type &&sock)
     : config_(std::move(config))
-    , stream_(std::move(sock))
-    , upstream_(socket_type(get_executor()))
+    , id_(++last_connection_id)
+    , deadline_([this] { handle_timeout(); })
+    , prelogin_(std::move(sock))
     , resolver_(get_executor())
-    , login_params_(config_.server_id, config_.server_key, config_.compression_threshold)
+    , wait_timer_(get_executor())
+    , client_to_server_budget_(config_.frame_budget, config_.byte_budget)
+    , server_to_client_budget_(config_.frame_budget, config_.byte_budget)
     {
-        spdlog::info("{} accepted", this);
-        stream_.next_layer().set_option(protocol_type::no_delay(true));
+        accept_log.info("{} accepted", this);
+        if (auto &timelines = protocol::timeline_trace::global(); timelines.is_open())
+        {
+            timeline_sampled_ = timelines.sample();
+            if (timeline_sampled_ or timelines.any_selected())
+                timeline_.enable();
+        }
+        prelogin_.next_layer().set_option(protocol_type::no_delay(true));
+        metrics().connections_in(phase_).inc();
     }
 
+    connection_impl::~connection_impl() { metrics().connections_in(phase_).dec(); }
+
     auto connection_impl::start() -> void
     {
         net::co_spawn(
             get_executor(),
             [self = shared_from_this()]() -> net::awaitable< void > { co_await self->run(); },
             [self = shared_from_this()](std::exception_ptr ep) {
+                self->write_timeline();
+                if (ep)
+                    self->count_failed_login();
                 try
                 {
                     if (ep)
@@ -90,10 +140,14 @@ namespace relay
                     if (ec == net::error::operation_aborted)
                         return;
                     spdlog::error("{}::{}({})", *self, "run", minecraft::report(ec));
+                    if (not polyfill::net::is_disconnect(ec) and self->stream_)
+                        spdlog::error("{}::{} recent frames:\n{}", *self, "run", self->recent_frames());
                 }
                 catch (...)
                 {
                     spdlog::error("{}::{} - exception: ", *self, "run", polyfill::explain());
+                    if (self->stream_)
+                        spdlog::error("{}::{} recent frames:\n{}", *self, "run", self->recent_frames());
                 }
             });
     }
@@ -103,54 +157,181 @@ namespace relay
         dispatch(bind_executor(get_executor(), [self = shared_from_this()] { self->handle_cancel(); }));
     }
 
-    auto connection_impl::get_executor() -> executor_type { return stream_.get_executor(); }
+    auto connection_impl::get_executor() -> executor_type { return prelogin_.get_executor(); }
+
+    auto connection_impl::trace(std::string_view player, bool on) -> bool
+    {
+        if (not stream_ or stream_->player_name().empty())
+            return false;
+        if (not player.empty() and player != stream_->player_name())
+            return false;
+        stream_->trace(on ? id_ : 0);
+        if (upstream_)
+            upstream_->trace(on ? id_ : 0);
+        spdlog::info("{} packet trace {} as connection {}", this, on ? "started" : "stopped", id_);
+        return true;
+    }
+
+    auto connection_impl::recent_frames() const -> std::string
+    {
+        auto result = std::string();
+        if (stream_)
+            result += "    player:\n" + to_string(stream_->recent_frames());
+        if (upstream_)
+            result += "    upstream:\n" + to_string(upstream_->recent_frames());
+        return result;
+    }
+
+    auto connection_impl::usage() const -> connection_usage
+    {
+        auto result = connection_usage();
+        if (not stream_)
+            return result;
+
+        result.player     = stream_->player_name();
+        auto &player      = stream_->usage();
+        result.bytes_in   = player.bytes_in;
+        result.bytes_out  = player.bytes_out;
+        result.frames     = player.frames_in + player.frames_out;
+        result.handler_ns = polyfill::timestamp::to_nanoseconds(handler_ticks_);
+        for (auto *s : { &*stream_, upstream_ ? &*upstream_ : nullptr })
+            if (s)
+            {
+                result.compression_ns += s->usage().compression_ns;
+                result.cipher_ns += s->usage().cipher_ns;
+            }
+        return result;
+    }
 
     auto connection_impl::handle_cancel() -> void
     {
-        stream_.cancel();
-        upstream_.cancel();
+        prelogin_.cancel();
+        if (stream_)
+            stream_->cancel();
+        if (upstream_)
+            upstream_->cancel();
         resolver_.cancel();
+        wait_timer_.cancel();
+    }
+
+    auto connection_impl::set_deadline(std::chrono::seconds timeout) -> void
+    {
+        if (config_.timeouts)
+            config_.timeouts->arm(deadline_, timeout);
+    }
+
+    auto connection_impl::handle_timeout() -> void
+    {
+        timeout_log.info("{} timed out", this);
+        timed_out_ = true;
+        handle_cancel();
+    }
+
+    auto connection_impl::set_phase(connection_phase phase) -> void
+    {
+        metrics().connections_in(phase_).dec();
+        phase_ = phase;
+        metrics().connections_in(phase_).inc();
+    }
+
+    auto connection_impl::count_failed_login() -> void
+    {
+        switch (phase_)
+        {
+        case connection_phase::login:
+        case connection_phase::queued:
+        case connection_phase::connecting:
+            (timed_out_ ? metrics().logins_timed_out : metrics().logins_failed).inc();
+            break;
+        default:
+            break;
+        }
     }
 
     auto connection_impl::run() -> net::awaitable< void >
     {
+        set_deadline(config_.login_timeout);
+
         // check if it's a ping
 
-        if (co_await protocol::async_is_old_style_ping(stream_.next_layer(), net::use_awaitable))
-            co_return spdlog::info("{} old style ping", this),
-                co_await async_old_style_ping(stream_, net::use_awaitable);
+        auto step = timeline_.begin("handshake");
+        if (co_await protocol::async_is_old_style_ping(prelogin_, net::use_awaitable))
+        {
+            timeline_.end(step);
+            ping_log.info("{} old style ping", this);
+            step = timeline_.begin("legacy ping");
+            co_await async_old_style_ping(prelogin_, *config_.status, net::use_awaitable);
+            timeline_.end(step);
+            co_return;
+        }
 
-        if (auto state = co_await protocol::async_server_handshake(stream_, net::use_awaitable); is_status(state))
+        auto state = co_await protocol::async_server_handshake(prelogin_, net::use_awaitable);
+        timeline_.end(step);
+        if (is_status(state))
         {
-            spdlog::info("{} ping handshake - version {}", this, wise_enum::to_string(stream_.protocol_version()));
-            co_return co_await async_server_status(stream_, net::use_awaitable);
+            ping_log.info("{} ping handshake - version {}", this, wise_enum::to_string(prelogin_.protocol_version()));
+            step = timeline_.begin("status");
+            co_await async_server_status(prelogin_, *config_.status, net::use_awaitable);
+            timeline_.end(step);
         }
         else if (is_login(state))
         {
-            spdlog::info("{} login handshake - version {}", stream_, wise_enum::to_string(stream_.protocol_version()));
-            upstream_.protocol_version(stream_.protocol_version());
-            co_await protocol::async_server_accept(stream_, this->login_params_, net::use_awaitable);
+            login_log.info(
+                "{} login handshake - version {}", prelogin_, wise_enum::to_string(prelogin_.protocol_version()));
+            set_phase(connection_phase::login);
+            stream_.emplace(prelogin_.upgrade());
+            upstream_.emplace(socket_type(get_executor()));
+            login_params_.emplace(config_.server_id, config_.server_key, config_.compression_threshold);
+            if (timeline_.enabled())
+            {
+                stream_->timeline().enable();
+                upstream_->timeline().enable();
+            }
+            auto login = timeline_.begin("login");
 
-            spdlog::info("{} Welcome! {} on {}", this, std::quoted(stream_.player_name()), stream_.full_info());
+            upstream_->protocol_version(stream_->protocol_version());
+            co_await protocol::async_server_accept(*stream_, *login_params_, net::use_awaitable);
 
+            login_log.info("{} Welcome! {} on {}", this, std::quoted(stream_->player_name()), stream_->full_info());
+
+            // a player may wait in the admission queue for as long as it takes, since it is kept alive meanwhile
+            deadline_.cancel();
+            set_phase(connection_phase::queued);
+            step = timeline_.begin("admission");
+            co_await wait_for_admission();
+            timeline_.end(step);
+            set_phase(connection_phase::connecting);
+            set_deadline(config_.login_timeout);
+
+            step = timeline_.begin("upstream resolve");
             auto results =
                 co_await resolver_.async_resolve(config_.upstream_host, config_.upstream_port, net::use_awaitable);
+            timeline_.end(step);
 
-            auto ep = co_await net::async_connect(upstream_.next_layer(), results, net::use_awaitable);
-            connect_state_.version(stream_.protocol_version());
-            connect_state_.name(stream_.player_name());
+            step    = timeline_.begin("upstream connect");
+            auto ep = co_await net::async_connect(upstream_->next_layer(), results, net::use_awaitable);
+            timeline_.end(step);
+            connect_state_.version(stream_->protocol_version());
+            connect_state_.name(stream_->player_name());
             connect_state_.connection_args(config_.upstream_host, ep.port());
 
-            co_await protocol::async_client_connect(upstream_, connect_state_, net::use_awaitable);
-            spdlog::info(
-                "{} We are welcome upstream! {} on {}", this, std::quoted(stream_.player_name()), stream_.full_info());
+            co_await protocol::async_client_connect(*upstream_, connect_state_, net::use_awaitable);
+            timeline_.end(login);
+            write_timeline();
+            admission_->complete();
+            admission_.reset();
+            metrics().logins_joined.inc();
+            set_phase(connection_phase::playing);
+            set_deadline(config_.idle_timeout);
+            login_log.info(
+                "{} We are welcome upstream! {} on {}", this, std::quoted(stream_->player_name()), stream_->full_info());
 
             net::co_spawn(
                 get_executor(),
                 [self = shared_from_this()]() -> net::awaitable< void > { return self->client_to_server(); },
                 [this, ehandler = utils::make_exception_handler(this, "client to server")](std::exception_ptr ep) {
-                    this->upstream_.next_layer().close();
-                    this->stream_.next_layer().close();
+                    this->upstream_->next_layer().close();
+                    this->stream_->next_layer().close();
                     ehandler(ep);
                 });
 
@@ -158,8 +339,8 @@ namespace relay
                 get_executor(),
                 [self = shared_from_this()]() -> net::awaitable< void > { return self->server_to_client(); },
                 [this, ehandler = utils::make_exception_handler(this, "server to client")](std::exception_ptr ep) {
-                    this->upstream_.next_layer().close();
-                    this->stream_.next_layer().close();
+                    this->upstream_->next_layer().close();
+                    this->stream_->next_layer().close();
                     ehandler(ep);
                 });
         }
@@ -167,54 +348,229 @@ namespace relay
             throw std::runtime_error("client requested unrecognised or invalid state");
     }
 
+    auto connection_impl::wait_for_admission() -> net::awaitable< void >
+    {
+        admission_.emplace(*config_.admission, [this] { wait_timer_.cancel(); });
+        if (admission_->admitted())
+            co_return;
+
+        login_log.info("{} waiting for admission at position {}", this, admission_->position());
+
+        // Until admitted the player holds only its protocol stream. It is kept alive and told its position in the
+        // queue whenever that changes.
+        auto last_position = std::size_t(0);
+        while (not admission_->admitted())
+        {
+            if (auto position = admission_->position(); position != last_position)
+            {
+                auto msg      = server::chat_message();
+                msg.json_data = fmt::format(R"json({{"text":"You are number {} in the queue","color":"gold"}})json",
+                                            position);
+                msg.position  = server::chat_message::chat_position::system_message;
+                co_await stream_->async_write_packet(msg, net::use_awaitable);
+                last_position = position;
+            }
+
+            auto ka          = server::keep_alive();
+            ka.keep_alive_id = waiting_keep_alive_base + keep_alives_sent_++;
+            co_await stream_->async_write_packet(ka, net::use_awaitable);
+            ++keep_alives_unanswered_;
+
+            if (admission_->admitted())
+                break;
+
+            auto ec = error_code();
+            wait_timer_.expires_after(config_.waiting_interval);
+            co_await wait_timer_.async_wait(net::redirect_error(net::use_awaitable, ec));
+            if (ec == net::error::operation_aborted and not admission_->admitted())
+                throw system_error(ec);
+        }
+
+        login_log.info("{} admitted", this);
+    }
+
+    auto connection_impl::is_waiting_keep_alive_reply(net::const_buffer frame) -> bool
+    {
+        if (keep_alives_unanswered_ == 0)
+            return false;
+
+        auto first = static_cast< const_buffer_iterator >(frame.data());
+        auto last  = first + frame.size();
+        auto ec    = error_code();
+        auto which = var_enum< client_play_packet >();
+        auto id    = std::int64_t();
+        first      = parse(first, last, which, ec);
+        if (ec.failed() or which.value() != client_play_packet::keep_alive)
+            return false;
+        parse(first, last, id, ec);
+        if (ec.failed() or id < waiting_keep_alive_base or id >= waiting_keep_alive_base + keep_alives_sent_)
+            return false;
+
+        --keep_alives_unanswered_;
+        return true;
+    }
+
+    auto connection_impl::record_latency(forwarding_latency::direction &d,
+                                         std::int32_t                   frame_type,
+                                         std::uint64_t                  received) -> void
+    {
+        d.record(frame_type, polyfill::timestamp::to_nanoseconds(polyfill::timestamp::now() - received));
+    }
+
+    auto connection_impl::write_timeline() -> void
+    {
+        if (not timeline_.enabled() or std::exchange(timeline_written_, true))
+            return;
+
+        auto &timelines = protocol::timeline_trace::global();
+        auto  player    = player_name();
+        if (not timeline_sampled_ and not timelines.selected(player))
+            return;
+        timelines.write(id_,
+                        fmt::format("connection {} {}", id_, player),
+                        { &timeline_,
+                          stream_ ? &stream_->timeline() : nullptr,
+                          upstream_ ? &upstream_->timeline() : nullptr });
+    }
+
+    auto connection_impl::report_end(char const *where, error_code const &ec) -> void
+    {
+        if (polyfill::net::is_disconnect(ec))
+            log_.log(spdlog::level::debug, "{}::{} : {}", *this, where, report(ec));
+        else
+            log_.info("{}::{} : {}\n{}",
+                      *this,
+                      where,
+                      report(ec),
+                      minecraft::utils::deferred { [this] { return recent_frames(); } });
+    }
+
     auto connection_impl::client_to_server() -> net::awaitable< void >
     {
+        auto ec            = error_code();
+        auto last_received = std::uint64_t(0);
         while (1)
         {
-            co_await stream_.async_read_frame(net::use_awaitable);
-            auto frame = stream_.current_frame();
+            co_await stream_->async_read_frame(
+                bind_recycling(client_to_server_memory_, net::redirect_error(net::use_awaitable, ec)));
+            if (ec.failed())
+            {
+                report_end(__func__, ec);
+                co_return;
+            }
+            auto frame = stream_->current_frame();
+
+            // Buffered frames are read without returning to the scheduler, so take turns with other connections.
+            // A frame which needed a read from the socket has already waited its turn.
+            auto &stats = config_.forwarding->client_to_server;
+            stats.frames.inc();
+            stats.bytes.inc(std::int64_t(frame.size()));
+            if (auto received = stream_->frame_received(); received != last_received)
+            {
+                last_received = received;
+                client_to_server_budget_.reset();
+            }
+            if (client_to_server_budget_.consume(frame.size()))
+            {
+                stats.yields.inc();
+                co_await net::post(get_executor(), bind_recycling(client_to_server_memory_, net::use_awaitable));
+            }
+            auto handler_start = polyfill::timestamp::now();
 
             int32_t frame_type;
-            auto    span = to_span(stream_.current_frame());
-            auto    ec   = error_code();
+            auto    span = to_span(stream_->current_frame());
             minecraft::parse_var(span.begin(), span.end(), frame_type, ec);
             if (ec.failed())
             {
-                spdlog::error("{}::{} : {}", *this, __func__, report(ec));
+                log_.error("{}::{} : {}", *this, __func__, report(ec));
                 co_return;
             }
             else
             {
-                spdlog::trace("{}::{} : frame type: {:0x} length {:0x}", *this, __func__, frame_type, frame.size());
-                co_await upstream_.async_write_frame(frame, net::use_awaitable);
+                log_.log(spdlog::level::trace,
+                         "{}::{} : frame type: {:0x} length {:0x}",
+                         *this,
+                         __func__,
+                         frame_type,
+                         frame.size());
+                set_deadline(config_.idle_timeout);
+                auto reply = is_waiting_keep_alive_reply(frame);
+                handler_ticks_ += polyfill::timestamp::now() - handler_start;
+                if (reply)
+                    continue;
+                co_await upstream_->async_write_frame(
+                    frame, bind_recycling(client_to_server_memory_, net::redirect_error(net::use_awaitable, ec)));
+                if (ec.failed())
+                {
+                    report_end(__func__, ec);
+                    co_return;
+                }
+                record_latency(config_.latency->client_to_server, frame_type, stream_->frame_received());
             }
         }
     }
 
     auto connection_impl::server_to_client() -> net::awaitable< void >
     {
+        auto ec            = error_code();
+        auto last_received = std::uint64_t(0);
         //        net::system_timer st(get_executor());
         while (1)
         {
-            co_await upstream_.async_read_frame(net::use_awaitable);
-            auto frame = upstream_.current_frame();
+            co_await upstream_->async_read_frame(
+                bind_recycling(server_to_client_memory_, net::redirect_error(net::use_awaitable, ec)));
+            if (ec.failed())
+            {
+                report_end(__func__, ec);
+                co_return;
+            }
+            auto frame = upstream_->current_frame();
+
+            // Buffered frames are read without returning to the scheduler, so take turns with other connections.
+            // A frame which needed a read from the socket has already waited its turn.
+            auto &stats = config_.forwarding->server_to_client;
+            stats.frames.inc();
+            stats.bytes.inc(std::int64_t(frame.size()));
+            if (auto received = upstream_->frame_received(); received != last_received)
+            {
+                last_received = received;
+                server_to_client_budget_.reset();
+            }
+            if (server_to_client_budget_.consume(frame.size()))
+            {
+                stats.yields.inc();
+                co_await net::post(get_executor(), bind_recycling(server_to_client_memory_, net::use_awaitable));
+            }
+            auto handler_start = polyfill::timestamp::now();
 
             int32_t frame_type;
             auto    span = to_span(frame);
-            auto    ec   = error_code();
             minecraft::parse_var(span.begin(), span.end(), frame_type, ec);
             if (ec.failed())
             {
-                spdlog::error("{}::{} : {}", *this, __func__, report(ec));
+                log_.error("{}::{} : {}", *this, __func__, report(ec));
                 co_return;
             }
             else
             {
-                spdlog::trace("{}::{} : frame type: {:0x} length {:0x}", *this, __func__, frame_type, frame.size());
+                log_.log(spdlog::level::trace,
+                         "{}::{} : frame type: {:0x} length {:0x}",
+                         *this,
+                         __func__,
+                         frame_type,
+                         frame.size());
                 //                spdlog::info("{}::{} : frame type: {:0x} length {:0x} {:n}", *this, __func__,
                 //                frame_type, frame.size(), spdlog::to_hex(to_span(frame))); st.expires_after(500ms);
                 //                co_await st.async_wait(net::use_awaitable);
-                co_await stream_.async_write_frame(frame, net::use_awaitable);
+                handler_ticks_ += polyfill::timestamp::now() - handler_start;
+                co_await stream_->async_write_frame(
+                    frame, bind_recycling(server_to_client_memory_, net::redirect_error(net::use_awaitable, ec)));
+                if (ec.failed())
+                {
+                    report_end(__func__, ec);
+                    co_return;
+                }
+                record_latency(config_.latency->server_to_client, frame_type, upstream_->frame_received());
             }
         }
     }
@@ -1,10 +1,22 @@
 #pragma once
 
+#include "application/admission_queue.hpp"
 #include "config.hpp"
+#include "connection_usage.hpp"
+#include "forwarding_latency.hpp"
+#include "forwarding_stats.hpp"
+#include "metrics.hpp"
 #include "minecraft/protocol/client_connect.hpp"
+#include "minecraft/protocol/prelogin_stream.hpp"
 #include "minecraft/protocol/server_accept.hpp"
+#include "minecraft/protocol/status_cache.hpp"
 #include "minecraft/protocol/stream.hpp"
+#include "minecraft/protocol/timeline.hpp"
 #include "minecraft/security/private_key.hpp"
+#include "minecraft/utils/logging.hpp"
+#include "polyfill/net/recycling_allocator.hpp"
+#include "polyfill/net/timer_wheel.hpp"
+#include "polyfill/net/yield_budget.hpp"
 
 namespace relay
 {
@@ -19,18 +31,50 @@ namespace relay
         std::string upstream_host;
         std::string upstream_port;
 
+        /// Shared by all connections. Refreshed from the upstream server by the status_service.
+        std::shared_ptr< minecraft::protocol::status_cache > status;
+
+        /// Limits how many players are logging in to the upstream server at once. Shared by all connections.
+        std::shared_ptr< application::admission_queue > admission;
+
+        /// How often a player waiting for admission is sent a keep alive and their position in the queue
+        std::chrono::seconds waiting_interval;
+
+        /// Expires stalled connections. Shared by all connections. Without it connections never time out.
+        std::shared_ptr< polyfill::net::timer_wheel > timeouts;
+
+        /// Longest time from accept to admission, and from admission to joining the upstream server
+        std::chrono::seconds login_timeout;
+
+        /// Longest time a player in the game may send nothing. Clients answer the server's keep alives, so a live
+        /// client is never idle for long.
+        std::chrono::seconds idle_timeout;
+
+        /// Frames, or bytes, one forwarding direction may process before yielding to other connections
+        std::size_t frame_budget;
+        std::size_t byte_budget;
+
+        /// Shared by all connections
+        std::shared_ptr< forwarding_stats >   forwarding;
+        std::shared_ptr< forwarding_latency > latency;
+
         friend auto operator<<(std::ostream &os, connection_config const &cfg) -> std::ostream &;
     };
 
     struct connection_impl : std::enable_shared_from_this< connection_impl >
     {
-        using executor_type = net::executor;
+        using executor_type = net::io_context::executor_type;
         using protocol_type = net::ip::tcp;
         using socket_type   = net::basic_stream_socket< protocol_type, executor_type >;
+        using prelogin_type = minecraft::protocol::prelogin_stream< socket_type >;
         using stream_type   = minecraft::protocol::stream< socket_type >;
         using resolver_type = net::ip::basic_resolver< protocol_type, executor_type >;
+        using timer_type    = net::basic_waitable_timer< std::chrono::steady_clock,
+                                                      net::wait_traits< std::chrono::steady_clock >,
+                                                      executor_type >;
 
         explicit connection_impl(connection_config config, socket_type &&sock);
+        ~connection_impl();
 
         auto start() -> void;
 
@@ -38,13 +82,59 @@ namespace relay
 
         auto get_executor() -> executor_type;
 
+        /// What the connection has cost so far. The endpoint is left to the caller.
+        auto usage() const -> connection_usage;
+
+        /// Empty until the player has logged in
+        auto player_name() const -> std::string_view
+        {
+            return stream_ ? std::string_view(stream_->player_name()) : std::string_view();
+        }
+
+        /// Identifies the connection within the process, for example in the packet trace
+        auto id() const -> std::uint64_t { return id_; }
+
+        /// Start or stop recording the frames of both sides of the connection in the packet trace, if it is the
+        /// connection of `player`, or of any logged in player if `player` is empty.
+        /// \return true if the connection was selected
+        auto trace(std::string_view player, bool on) -> bool;
+
+        /// The last frames read and written on each side of the connection, oldest first. Empty before login.
+        auto recent_frames() const -> std::string;
+
       private:
         net::awaitable< void > run();
+        net::awaitable< void > wait_for_admission();
         net::awaitable< void > client_to_server();
         net::awaitable< void > server_to_client();
 
         auto handle_cancel() -> void;
 
+        /// Cancel the connection if it has not made progress within `timeout`. Re-arming moves the deadline.
+        auto set_deadline(std::chrono::seconds timeout) -> void;
+        auto handle_timeout() -> void;
+
+        /// Move the connection to another phase of the relay_connections gauge
+        auto set_phase(connection_phase phase) -> void;
+
+        /// Count a login which ended before the player joined the upstream server
+        auto count_failed_login() -> void;
+
+        /// Record the time from the receipt of a frame to the completion of its forwarding
+        auto record_latency(forwarding_latency::direction &d, std::int32_t frame_type, std::uint64_t received)
+            -> void;
+
+        /// Write the timeline of the login to the timeline_trace, once, if the connection was sampled or its player
+        /// is selected
+        auto write_timeline() -> void;
+
+        /// Log the end of a forwarding loop. Disconnects are expected and logged quietly.
+        auto report_end(char const *where, error_code const &ec) -> void;
+
+        /// Return true if the frame is the client's reply to a keep alive sent while it was waiting for admission.
+        /// Such replies must not be forwarded, since the upstream server did not send the keep alive.
+        auto is_waiting_keep_alive_reply(net::const_buffer frame) -> bool;
+
         template < class F >
         auto bind_self(F &&f)
         {
@@ -55,19 +145,47 @@ namespace relay
         }
 
         connection_config config_;
+        std::uint64_t     id_;
+
+        polyfill::net::timer_wheel::entry deadline_;   //! armed in the wheel in config_, so declared after it
 
-        stream_type   stream_;     //! client connection
-        stream_type   upstream_;   //! connection to the server
-        resolver_type resolver_;
+        // Until the client selects login, the connection is owned by the lightweight prelogin stream. Status pings
+        // and scanners never cause the full protocol streams to be allocated.
+        prelogin_type                prelogin_;   //! client connection during handshake and status
+        std::optional< stream_type > stream_;     //! client connection once login has been selected
+        std::optional< stream_type > upstream_;   //! connection to the server
+        resolver_type                resolver_;
+        timer_type                   wait_timer_;   //! paces keep alives while waiting for admission
 
-        minecraft::protocol::server_accept_state login_params_;
+        std::optional< minecraft::protocol::server_accept_state > login_params_;
 
         minecraft::protocol::client_connect_state connect_state_;
 
+        // Each forwarding direction has at most one operation outstanding at a time, so the memory for its
+        // operation state is recycled rather than allocated per frame.
+        polyfill::net::handler_memory<> client_to_server_memory_;
+        polyfill::net::handler_memory<> server_to_client_memory_;
+        polyfill::net::yield_budget     client_to_server_budget_;
+        polyfill::net::yield_budget     server_to_client_budget_;
+
+        std::optional< application::admission_queue::place > admission_;
+        std::int64_t                                         keep_alives_sent_       = 0;
+        std::int64_t                                         keep_alives_unanswered_ = 0;
+        std::uint64_t                                        handler_ticks_          = 0;   //! polyfill::timestamp
+        connection_phase                                     phase_                  = connection_phase::handshake;
+        bool                                                 timed_out_              = false;
+        minecraft::utils::log_limiter                        log_;   //! messages about this connection
+
+        // The phases of the connection, such as the wait for admission. The steps of the logins are recorded in
+        // the timelines of the streams.
+        minecraft::protocol::timeline timeline_;
+        bool                          timeline_sampled_ = false;
+        bool                          timeline_written_ = false;
+
         template < class Stream >
         friend Stream &operator<<(Stream &os, const connection_impl &p)
         {
-            os << "[connection " << report(p.stream_.next_layer()) << ']';
+            os << "[connection " << report(p.stream_ ? p.stream_->next_layer() : p.prelogin_.next_layer()) << ']';
             return os;
         }
 
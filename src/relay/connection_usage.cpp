@@ -0,0 +1,135 @@
+#include "connection_usage.hpp"
+
+#include <algorithm>
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <charconv>
+#include <fmt/format.h>
+#include <ostream>
+
+namespace relay
+{
+    auto connection_usage::parse_column(std::string_view name) -> std::optional< column >
+    {
+        struct entry
+        {
+            std::string_view name;
+            column           which;
+        };
+        static constexpr entry names[] = {
+            { "in", column::bytes_in },
+            { "out", column::bytes_out },
+            { "frames", column::frames },
+            { "compression", column::compression },
+            { "cipher", column::cipher },
+            { "handler", column::handler },
+            { "cpu", column::cpu },
+        };
+        for (auto &e : names)
+            if (boost::iequals(name, e.name))
+                return e.which;
+        return std::nullopt;
+    }
+
+    auto connection_usage::value(column c) const -> std::uint64_t
+    {
+        switch (c)
+        {
+        case column::bytes_in:
+            return bytes_in;
+        case column::bytes_out:
+            return bytes_out;
+        case column::frames:
+            return frames;
+        case column::compression:
+            return compression_ns;
+        case column::cipher:
+            return cipher_ns;
+        case column::handler:
+            return handler_ns;
+        case column::cpu:
+            return compression_ns + cipher_ns + handler_ns;
+        }
+        return 0;
+    }
+
+    auto connection_query::parse(std::string_view args) -> std::optional< connection_query >
+    {
+        auto result = connection_query();
+        auto words  = std::vector< std::string >();
+        boost::split(words, args, boost::is_space(), boost::token_compress_on);
+        for (auto &word : words)
+        {
+            if (word.empty())
+                continue;
+            auto eq = word.find('=');
+            if (eq == std::string::npos)
+                return std::nullopt;
+            auto key   = std::string_view(word).substr(0, eq);
+            auto value = std::string_view(word).substr(eq + 1);
+            if (key == "player")
+                result.player = value;
+            else if (key == "address")
+                result.address = value;
+            else if (key == "sort")
+            {
+                auto c = connection_usage::parse_column(value);
+                if (not c)
+                    return std::nullopt;
+                result.sort = *c;
+            }
+            else if (key == "limit")
+            {
+                auto last = value.data() + value.size();
+                if (value.empty() or std::from_chars(value.data(), last, result.limit).ptr != last)
+                    return std::nullopt;
+            }
+            else
+                return std::nullopt;
+        }
+        return result;
+    }
+
+    auto connection_query::matches(connection_usage const &u) const -> bool
+    {
+        return boost::icontains(u.player, player) and boost::starts_with(u.endpoint, address);
+    }
+
+    auto write_top(std::ostream &os, std::vector< connection_usage > usage, connection_usage::column by, std::size_t n)
+        -> void
+    {
+        n           = std::min(n, usage.size());
+        auto higher = [by](connection_usage const &l, connection_usage const &r) { return l.value(by) > r.value(by); };
+        std::partial_sort(usage.begin(), usage.begin() + std::ptrdiff_t(n), usage.end(), higher);
+
+        auto ms = [](std::uint64_t ns) { return double(ns) / 1e6; };
+        os << fmt::format("\t{:<16} {:<21} {:>12} {:>12} {:>10} {:>10} {:>10} {:>10} {:>10}\n",
+                          "player",
+                          "endpoint",
+                          "in",
+                          "out",
+                          "frames",
+                          "comp ms",
+                          "cipher ms",
+                          "handler ms",
+                          "cpu ms");
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            auto &u = usage[i];
+            os << fmt::format("\t{:<16} {:<21} {:>12} {:>12} {:>10} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f}\n",
+                              u.player.empty() ? "-" : u.player,
+                              u.endpoint,
+                              u.bytes_in,
+                              u.bytes_out,
+                              u.frames,
+                              ms(u.compression_ns),
+                              ms(u.cipher_ns),
+                              ms(u.handler_ns),
+                              ms(u.value(connection_usage::column::cpu)));
+        }
+        if (usage.size() > n)
+            os << "\t... and " << usage.size() - n << " more\n";
+    }
+
+}   // namespace relay
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace relay
+{
+    /// What one player's connection has cost the relay so far. Bytes and frames are counted on the player's side;
+    /// the times include the work done on both the player's and the upstream server's streams.
+    struct connection_usage
+    {
+        enum class column
+        {
+            bytes_in,      //! from the player
+            bytes_out,     //! to the player
+            frames,        //! in both directions
+            compression,
+            cipher,
+            handler,       //! forwarding loops, between the completion of a read and the start of the write
+            cpu            //! the sum of the three times
+        };
+
+        /// Parse a column name as used by the "top" command: in, out, frames, compression, cipher, handler or cpu
+        static auto parse_column(std::string_view name) -> std::optional< column >;
+
+        auto value(column c) const -> std::uint64_t;
+
+        std::string   player;     //! empty until the player has logged in
+        std::string   endpoint;   //! of the player
+        std::uint64_t bytes_in       = 0;
+        std::uint64_t bytes_out      = 0;
+        std::uint64_t frames         = 0;
+        std::uint64_t compression_ns = 0;
+        std::uint64_t cipher_ns      = 0;
+        std::uint64_t handler_ns     = 0;
+    };
+
+    /// The selection made by the "connections" command
+    struct connection_query
+    {
+        /// Parse the arguments of the command, words of the form `key=value`:
+        /// - `player=<text>`: players whose name contains the text
+        /// - `address=<text>`: players whose endpoint starts with the text
+        /// - `sort=<column>`: the column to order by, as for parse_column. By default cpu.
+        /// - `limit=<n>`: the most connections to list. By default 50.
+        /// \return nullopt if an argument is not recognised
+        static auto parse(std::string_view args) -> std::optional< connection_query >;
+
+        auto matches(connection_usage const &u) const -> bool;
+
+        std::string              player;
+        std::string              address;
+        connection_usage::column sort  = connection_usage::column::cpu;
+        std::size_t              limit = 50;
+    };
+
+    /// Write a table of the `n` connections with the highest value in column `by`
+    auto write_top(std::ostream &os, std::vector< connection_usage > usage, connection_usage::column by, std::size_t n)
+        -> void;
+
+}   // namespace relay
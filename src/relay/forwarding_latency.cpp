@@ -0,0 +1,34 @@
+#include "forwarding_latency.hpp"
+
+#include <fmt/format.h>
+#include <ostream>
+
+namespace relay
+{
+    auto operator<<(std::ostream &os, forwarding_latency const &latency) -> std::ostream &
+    {
+        auto us  = [](std::uint64_t ns) { return double(ns) / 1000.0; };
+        auto one = [&](char const *name, forwarding_latency::direction const &d) {
+            os << '\t' << name << '\n';
+            os << fmt::format(
+                "\t\t{:>6} {:>10} {:>10} {:>10} {:>10} {:>10}\n", "packet", "count", "p50 us", "p99 us", "p999 us", "max us");
+            for (std::size_t id = 0; id < d.by_packet.size(); ++id)
+            {
+                auto &h = d.by_packet[id];
+                if (not h or h->count() == 0)
+                    continue;
+                os << fmt::format("\t\t{:>#6x} {:>10} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f}\n",
+                                  id,
+                                  h->count(),
+                                  us(h->percentile(50)),
+                                  us(h->percentile(99)),
+                                  us(h->percentile(99.9)),
+                                  us(h->max()));
+            }
+        };
+        one("client to server", latency.client_to_server);
+        one("server to client", latency.server_to_client);
+        return os;
+    }
+
+}   // namespace relay
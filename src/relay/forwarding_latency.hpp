@@ -0,0 +1,40 @@
+#pragma once
+
+#include "polyfill/latency_histogram.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+
+namespace relay
+{
+    /// Time frames spend inside the relay, from the read which completed the frame to the completion of its write
+    /// to the other side, by direction and packet id. Shared by all connections, and used from the relay's thread.
+    struct forwarding_latency
+    {
+        struct direction
+        {
+            static constexpr std::size_t packet_ids = 128;   //! higher ids are recorded under the last
+
+            auto record(std::int32_t packet_id, std::uint64_t ns) -> void
+            {
+                auto &h = by_packet[std::size_t(std::clamp(packet_id, 0, std::int32_t(packet_ids) - 1))];
+                if (not h)
+                    h = std::make_unique< polyfill::latency_histogram >();
+                h->record(ns);
+            }
+
+            /// Created on the first frame of each id
+            std::array< std::unique_ptr< polyfill::latency_histogram >, packet_ids > by_packet;
+        };
+
+        direction client_to_server;
+        direction server_to_client;
+
+        /// A table of p50, p99, p99.9 and max by direction and packet id, in microseconds
+        friend auto operator<<(std::ostream &os, forwarding_latency const &latency) -> std::ostream &;
+    };
+
+}   // namespace relay
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "polyfill/metrics.hpp"
+
+#include <ostream>
+
+namespace relay
+{
+    /// Traffic forwarded by the relay, and how often a connection used up its cooperative budget and had to yield
+    /// to the others. The counters are published in polyfill::metrics::registry::global().
+    struct forwarding_stats
+    {
+        struct direction
+        {
+            explicit direction(char const *name)
+            : frames(registry().counter("relay_frames_total", "Frames forwarded", { { "direction", name } }))
+            , bytes(registry().counter("relay_bytes_total", "Frame bytes forwarded", { { "direction", name } }))
+            , yields(registry().counter(
+                  "relay_budget_yields_total", "Times a connection's budget was exhausted", { { "direction", name } }))
+            {
+            }
+
+            polyfill::metrics::counter frames;
+            polyfill::metrics::counter bytes;
+            polyfill::metrics::counter yields;   //! times a connection's budget was exhausted
+
+          private:
+            static auto registry() -> polyfill::metrics::registry & { return polyfill::metrics::registry::global(); }
+        };
+
+        direction client_to_server { "client_to_server" };
+        direction server_to_client { "server_to_client" };
+
+        friend auto operator<<(std::ostream &os, forwarding_stats const &stats) -> std::ostream &
+        {
+            auto one = [&os](char const *name, direction const &d) {
+                os << "\t" << name << " : " << d.frames.value() << " frames, " << d.bytes.value() << " bytes, "
+                   << d.yields.value() << " budget yields\n";
+            };
+            one("client to server", stats.client_to_server);
+            one("server to client", stats.server_to_client);
+            return os;
+        }
+    };
+
+}   // namespace relay
@@ -1,6 +1,8 @@
 #include "listener.hpp"
 
+#include "metrics.hpp"
 #include "minecraft/report.hpp"
+#include "polyfill/explain.hpp"
 
 #include <spdlog/spdlog.h>
 
@@ -11,33 +13,44 @@ namespace relay
         os << "Listener Config\n";
         os << "\tlisten port : " << cfg.listen_port;
         os << '\n';
+        os << "\tip filter   : " << (cfg.ip_filter_file.empty() ? "none" : cfg.ip_filter_file);
+        os << '\n';
         os << cfg.as_connection_config();
         return os;
     }
 
     listener::listener(executor_type exec, listener_config config)
     : config_(std::move(config))
+    , filter_(std::make_shared< application::ip_filter_handle >())
     , acceptor_(exec)
     {
-        using namespace std::literals;
-        error_code ec;
-        acceptor_.open(protocol::v4());
-        acceptor_.set_option(socket_type::reuse_address());
-        do
+        if (not config_.ip_filter_file.empty())
+            filter_->replace(application::ip_filter::load(config_.ip_filter_file));
+
+        if (config_.listen_handle >= 0)
+            acceptor_.assign(protocol::v4(), config_.listen_handle);
+        else
         {
-            acceptor_.bind(protocol::endpoint(net::ip::make_address("0.0.0.0"),
-                                              std::uint16_t(::atoi(config_.listen_port.c_str()))),
-                           ec);
-            if (not ec.failed())
-                break;
-            if (ec.failed() && ec != net::error::address_in_use)
-                throw system_error(ec);
-            std::cout << ec.message() << std::endl;
-            auto t = net::system_timer(get_executor());
-            t.expires_after(5s);
-            t.wait();
-        } while (ec.failed());
-        acceptor_.listen();
+            using namespace std::literals;
+            error_code ec;
+            acceptor_.open(protocol::v4());
+            acceptor_.set_option(socket_type::reuse_address());
+            do
+            {
+                acceptor_.bind(protocol::endpoint(net::ip::make_address("0.0.0.0"),
+                                                  std::uint16_t(::atoi(config_.listen_port.c_str()))),
+                               ec);
+                if (not ec.failed())
+                    break;
+                if (ec.failed() && ec != net::error::address_in_use)
+                    throw system_error(ec);
+                spdlog::warn("listener: {}, retrying in 5s", ec.message());
+                auto t = net::system_timer(get_executor());
+                t.expires_after(5s);
+                t.wait();
+            } while (ec.failed());
+            acceptor_.listen();
+        }
         spdlog::info("relay: listening on {}", minecraft::report(acceptor_));
     }
 
@@ -50,12 +63,21 @@ namespace relay
             if (ec == net::error::connection_aborted)
                 initiate_accept();
             else if (ec != net::error::operation_aborted)
-                std::clog << "listener: accept error: " << ec.message() << std::endl;
+                spdlog::error("listener: accept error: {}", ec.message());
         }
         else
         {
-            auto ep = sock.remote_endpoint();
-            std::clog << "listener: new connection from " << ep.address() << ':' << ep.port() << std::endl;
+            auto ep = sock.remote_endpoint(ec);
+            if (ec.failed() or not filter_->permits(ep.address()))
+            {
+                metrics().refused.inc();
+                accept_log_.log(spdlog::level::debug, "listener: refused connection from {}", minecraft::report(ep));
+                sock.close(ec);
+                initiate_accept();
+                return;
+            }
+            metrics().accepts.inc();
+            accept_log_.info("listener: new connection from {}", minecraft::report(ep));
 
             connections_.create(config_, std::move(sock));
 
@@ -63,9 +85,39 @@ namespace relay
         }
     }
 
+    void listener::reload_filter()
+    {
+        if (config_.ip_filter_file.empty())
+            return;
+
+        net::post(net::system_executor(), [filter = filter_, path = config_.ip_filter_file] {
+            try
+            {
+                auto next = application::ip_filter::load(path);
+                spdlog::info("listener: loaded {} exact and {} network rules from {}",
+                             next->exact_count(),
+                             next->network_count(),
+                             path);
+                filter->replace(std::move(next));
+            }
+            catch (...)
+            {
+                spdlog::error("listener: ip filter not reloaded: {}", polyfill::explain());
+            }
+        });
+    }
+
+    void listener::drain()
+    {
+        spdlog::info("{} draining {} connections", this, connections_.live());
+        auto ec = error_code();
+        acceptor_.close(ec);
+    }
+
     void listener::handle_cancel()
     {
-        acceptor_.cancel();
+        auto ec = error_code();
+        acceptor_.cancel(ec);   // the acceptor is closed if draining
         connections_.cancel();
     }
 
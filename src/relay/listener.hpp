@@ -1,10 +1,13 @@
 #pragma once
 
+#include "application/ip_filter.hpp"
 #include "config/net.hpp"
 #include "connection_cache.hpp"
 #include "minecraft/security/private_key.hpp"
+#include "minecraft/utils/logging.hpp"
 
 #include <iostream>
+#include <memory>
 
 namespace relay {
     struct listener_config : connection_config
@@ -16,6 +19,13 @@ namespace relay {
 
         std::string listen_port;
 
+        /// Optional file of allow/deny rules consulted before a connection is accepted. See application::ip_filter.
+        std::string ip_filter_file;
+
+        /// A socket which is already listening, for example one inherited from a supervisor. If set, listen_port
+        /// is not bound.
+        int listen_handle = -1;
+
         friend auto operator<<(std::ostream& os, listener_config const& cfg) -> std::ostream&;
     };
 
@@ -46,8 +56,53 @@ namespace relay {
             }));
         }
 
+        /// Reload the rules in config.ip_filter_file. The file is parsed away from the io thread and the new rules
+        /// take effect for connections accepted after it has been parsed. On error the current rules are retained.
+        void
+        reload_filter();
+
+        /// The usage of the connections of logged in players. Call on the listener's executor.
+        auto
+        usage() -> std::vector<connection_usage>
+        {
+            return connections_.usage();
+        }
+
+        /// See connection_cache::trace. Call on the listener's executor.
+        auto
+        trace(std::string_view player, bool on) -> std::size_t
+        {
+            return connections_.trace(player, on);
+        }
+
+        /// See connection_cache::kick. Call on the listener's executor.
+        auto
+        kick(std::string_view player) -> std::size_t
+        {
+            return connections_.kick(player);
+        }
+
+        /// Stop accepting connections, leaving those already accepted to end in their own time. Other processes
+        /// sharing the listening socket carry on accepting. Call on the listener's executor.
+        void
+        drain();
+
+        /// The number of connections which have not ended. Call on the listener's executor.
+        auto
+        connection_count() -> std::size_t
+        {
+            return connections_.live();
+        }
+
+        /// See connection_cache::recent_frames. Call on the listener's executor.
+        auto
+        recent_frames(std::string_view player) -> std::string
+        {
+            return connections_.recent_frames(player);
+        }
+
         auto
-        get_executor() -> net::executor
+        get_executor() -> executor_type
         {
             return acceptor_.get_executor();
         }
@@ -71,8 +126,10 @@ namespace relay {
         }
 
         listener_config config_;
+        std::shared_ptr<application::ip_filter_handle> filter_;
         acceptor_type acceptor_;
         connection_cache connections_;
+        minecraft::utils::log_limiter accept_log_ {20, 50};
     };
 
 }
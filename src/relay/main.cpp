@@ -1,6 +1,7 @@
 #include "app.hpp"
 #include "config.hpp"
 #include "polyfill/explain.hpp"
+#include "polyfill/timestamp.hpp"
 
 #include <boost/program_options.hpp>
 #include <iostream>
@@ -11,12 +12,45 @@ namespace relay
 {
     void run(app_config config)
     {
+        // after any fork, since the logging thread is not inherited by a worker process
+        minecraft::utils::install_logger(config.logging);
+
         auto ioc  = net::io_context(1);
         auto exec = ioc.get_executor();
 
+        config.timeouts = std::make_shared< polyfill::net::timer_wheel >(exec);
+
         auto app_ = app(exec, std::move(config));
         app_.start();
 
+        ioc.run();
+        minecraft::protocol::timeline_trace::global().close();
+        minecraft::utils::shutdown_logger();
+    }
+
+    /// Run `workers` relays in child processes which share one listening socket, restarting any which fail
+    void run_workers(app_config config, std::size_t workers)
+    {
+        config.listen_handle = application::open_shared_listener(config.listen_port);
+        config.interactive   = false;
+
+        auto ioc = net::io_context(1);
+        auto sup = application::supervisor(ioc, { workers }, [&config](application::worker_context ctx) {
+            auto worker_config     = config;
+            worker_config.stats_fd = ctx.stats_fd;
+            if (not config.metrics_port.empty())
+                worker_config.metrics_port = std::to_string(std::stoi(config.metrics_port) + int(ctx.index));
+            if (not config.trace_file.empty())
+                worker_config.trace_file += "." + std::to_string(ctx.index);
+            if (not config.timeline_file.empty())
+                worker_config.timeline_file += "." + std::to_string(ctx.index);
+            if (not config.admin_socket.empty())
+                worker_config.admin_socket += "." + std::to_string(ctx.index);
+            run(std::move(worker_config));
+            return 0;
+        });
+        sup.start();
+
         ioc.run();
     }
 
@@ -32,6 +66,13 @@ int main(int argc, char **argv)
     namespace po = boost::program_options;
 
     std::string log_level;
+    auto        admission       = application::admission_config();
+    auto        login_latency   = int();
+    auto        login_timeout   = int();
+    auto        idle_timeout    = int();
+    auto        workers         = std::size_t();
+    auto        latency_clock   = std::string();
+    auto        stall_threshold = int();
 
     try
     {
@@ -41,6 +82,63 @@ int main(int argc, char **argv)
             "upstream-host", po::value(&config.upstream_host)->default_value("localhost"), "upstream minecraft server")(
             "upstream-port", po::value(&config.upstream_port)->default_value("25565"), "upstream minecraft port")(
             "port", po::value(&config.listen_port)->default_value("9000"), "port to listen on")(
+            "ip-filter", po::value(&config.ip_filter_file), "file of allow/deny address rules, reloaded on SIGHUP")(
+            "status-refresh",
+            po::value(&config.status_refresh_seconds)->default_value(5),
+            "seconds between upstream status queries")(
+            "max-logins",
+            po::value(&admission.max_concurrent)->default_value(admission.max_concurrent),
+            "most players logging in to the upstream at once, further players wait in a queue")(
+            "login-latency",
+            po::value(&login_latency)->default_value(int(admission.target_latency.count())),
+            "upstream login time in milliseconds beyond which fewer players are admitted at once")(
+            "login-timeout",
+            po::value(&login_timeout)->default_value(int(config.login_timeout.count())),
+            "seconds a player may take to log in, not counting time spent in the queue")(
+            "idle-timeout",
+            po::value(&idle_timeout)->default_value(int(config.idle_timeout.count())),
+            "seconds a player in the game may send nothing before being disconnected")(
+            "frame-budget",
+            po::value(&config.frame_budget)->default_value(config.frame_budget),
+            "frames a connection may forward in one direction before letting other connections run")(
+            "byte-budget",
+            po::value(&config.byte_budget)->default_value(config.byte_budget),
+            "bytes a connection may forward in one direction before letting other connections run")(
+            "latency-clock",
+            po::value(&latency_clock)->default_value("steady"),
+            "clock for forwarding latency: steady, coarse (cheapest, millisecond resolution) or tsc")(
+            "stall-threshold",
+            po::value(&stall_threshold)->default_value(int(config.loop_monitor.threshold.count())),
+            "milliseconds a handler may block the event loop before it is reported, 0 to disable")(
+            "log-queue",
+            po::value(&config.logging.queue_size)->default_value(config.logging.queue_size),
+            "log messages which may wait to be written, after which the oldest are dropped. 0 logs synchronously")(
+            "trace-file",
+            po::value(&config.trace_file),
+            "file in which to record the frames of players traced with the console's trace command. Worker processes "
+            "add their index to the name. Decode with trace_dump")(
+            "trace-records",
+            po::value(&config.trace_records)->default_value(config.trace_records),
+            "frames the trace file holds before the oldest are overwritten, 64 bytes each")(
+            "timeline-file",
+            po::value(&config.timeline_file),
+            "file in which to write the login timelines of sampled connections, in the Chrome trace event format "
+            "for Perfetto. Worker processes add their index to the name")(
+            "timeline-sample",
+            po::value(&config.timeline_sample)->default_value(config.timeline_sample),
+            "write the timeline of one in this many connections, 0 for only players selected with the timeline "
+            "command")(
+            "admin-socket",
+            po::value(&config.admin_socket),
+            "Unix domain socket on which to serve admin commands; send \"help\" for a list. Worker processes add "
+            "their index to the name")(
+            "metrics-port",
+            po::value(&config.metrics_port),
+            "loopback port on which to serve Prometheus metrics. Worker processes use consecutive ports from this one")(
+            "workers",
+            po::value(&workers)->default_value(0),
+            "run this many relay processes sharing the port, supervised by this one. Limits such as max-logins "
+            "apply to each worker. 0 runs a single relay in this process")(
             "log-level,L", po::value(&log_level)->default_value("info"), "set the logging level")("help,-?",
                                                                                                   "show this help");
 
@@ -53,6 +151,18 @@ int main(int argc, char **argv)
         }
         po::notify(vm);
 
+        if (admission.max_concurrent < admission.min_concurrent)
+            throw std::invalid_argument("max-logins must be at least 1");
+        admission.target_latency = std::chrono::milliseconds(login_latency);
+        config.admission         = std::make_shared< application::admission_queue >(admission);
+        config.login_timeout     = std::chrono::seconds(login_timeout);
+        config.idle_timeout      = std::chrono::seconds(idle_timeout);
+        if (config.frame_budget == 0 or config.byte_budget == 0)
+            throw std::invalid_argument("frame-budget and byte-budget must be at least 1");
+        polyfill::timestamp::select(polyfill::timestamp::parse(latency_clock));
+        config.loop_monitor.name      = "relay";
+        config.loop_monitor.threshold = std::chrono::milliseconds(stall_threshold);
+
         auto level = spdlog::level::from_str(log_level);
         auto show_log_level = [&level]
         {
@@ -64,7 +174,10 @@ int main(int argc, char **argv)
         show_log_level();
         spdlog::set_level(spdlog::level::from_str(log_level));
 
-        relay::run(std::move(config));
+        if (workers)
+            relay::run_workers(std::move(config), workers);
+        else
+            relay::run(std::move(config));
         return 0;
     }
     catch (...)
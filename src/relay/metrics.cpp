@@ -0,0 +1,32 @@
+#include "metrics.hpp"
+
+namespace relay
+{
+    auto metrics() -> relay_metrics const &
+    {
+        static auto const m = [] {
+            auto &reg    = polyfill::metrics::registry::global();
+            auto  logins = [&reg](char const *outcome) {
+                return reg.counter(
+                    "relay_logins_total", "Players who logged in, by outcome", { { "outcome", outcome } });
+            };
+            auto connections = [&reg](char const *phase) {
+                return reg.gauge("relay_connections", "Open client connections, by phase", { { "phase", phase } });
+            };
+            return relay_metrics {
+                reg.counter("relay_accepts_total", "Client connections accepted"),
+                reg.counter("relay_refused_total", "Client connections refused by the ip filter"),
+                logins("joined"),
+                logins("failed"),
+                logins("timed_out"),
+                { connections("handshake"),
+                  connections("login"),
+                  connections("queued"),
+                  connections("connecting"),
+                  connections("playing") }
+            };
+        }();
+        return m;
+    }
+
+}   // namespace relay
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "polyfill/metrics.hpp"
+
+#include <array>
+#include <cstddef>
+
+namespace relay
+{
+    /// The stages of a connection's life, counted by the relay_connections gauge
+    enum class connection_phase
+    {
+        handshake,    //! before the client chooses status or login
+        login,        //! authenticating with the relay
+        queued,       //! waiting for admission
+        connecting,   //! logging in to the upstream server
+        playing,      //! forwarding frames
+        count
+    };
+
+    /// Published in polyfill::metrics::registry::global()
+    struct relay_metrics
+    {
+        polyfill::metrics::counter accepts;
+        polyfill::metrics::counter refused;
+        polyfill::metrics::counter logins_joined;
+        polyfill::metrics::counter logins_failed;
+        polyfill::metrics::counter logins_timed_out;
+
+        std::array< polyfill::metrics::gauge, std::size_t(connection_phase::count) > connections;
+
+        auto connections_in(connection_phase p) const -> polyfill::metrics::gauge const &
+        {
+            return connections[std::size_t(p)];
+        }
+    };
+
+    auto metrics() -> relay_metrics const &;
+
+}   // namespace relay
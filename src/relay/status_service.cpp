@@ -0,0 +1,140 @@
+#include "status_service.hpp"
+
+#include "minecraft/protocol/client_status.hpp"
+#include "minecraft/report.hpp"
+#include "polyfill/explain.hpp"
+
+#include <spdlog/spdlog.h>
+
+namespace relay
+{
+    using namespace std::literals;
+
+    namespace
+    {
+        // a server that accepts the connection but never replies must not stall the refresh
+        constexpr auto query_timeout = 5s;
+
+        // the number of players the vanilla server presents in the sample
+        constexpr std::size_t max_sample = 12;
+    }   // namespace
+
+    status_service::status_service(executor_type                                        exec,
+                                   std::vector< upstream_address >                      upstreams,
+                                   std::chrono::seconds                                 interval,
+                                   std::shared_ptr< minecraft::protocol::status_cache > cache)
+    : upstreams_(std::move(upstreams))
+    , interval_(interval)
+    , cache_(std::move(cache))
+    , resolver_(exec)
+    , timer_(exec)
+    {
+    }
+
+    void status_service::start()
+    {
+        net::co_spawn(get_executor(), run(), [this](std::exception_ptr ep) {
+            try
+            {
+                if (ep)
+                    std::rethrow_exception(ep);
+            }
+            catch (system_error &se)
+            {
+                if (se.code() != net::error::operation_aborted)
+                    spdlog::error("status_service: {}", minecraft::report(se.code()));
+            }
+            catch (...)
+            {
+                spdlog::error("status_service: {}", polyfill::explain());
+            }
+        });
+    }
+
+    void status_service::cancel()
+    {
+        dispatch(bind_executor(get_executor(), [this] {
+            canceled_ = true;
+            timer_.cancel();
+            resolver_.cancel();
+        }));
+    }
+
+    auto status_service::run() -> net::awaitable< void >
+    {
+        while (not canceled_)
+        {
+            co_await refresh();
+            timer_.expires_after(interval_);
+            co_await timer_.async_wait(net::use_awaitable);
+        }
+    }
+
+    auto status_service::refresh() -> net::awaitable< void >
+    {
+        auto replies   = std::size_t(0);
+        auto aggregate = minecraft::protocol::status_info();
+
+        for (auto &upstream : upstreams_)
+        {
+            try
+            {
+                auto info = co_await query(upstream);
+                if (replies++ == 0)
+                    aggregate = std::move(info);
+                else
+                {
+                    aggregate.online_players += info.online_players;
+                    aggregate.max_players += info.max_players;
+                    aggregate.sample.insert(aggregate.sample.end(), info.sample.begin(), info.sample.end());
+                }
+            }
+            catch (system_error &se)
+            {
+                if (canceled_)
+                    co_return;
+                spdlog::warn(
+                    "status_service: {}:{} - {}", upstream.host, upstream.port, minecraft::report(se.code()));
+            }
+        }
+
+        if (replies == 0)
+            co_return;
+
+        if (aggregate.sample.size() > max_sample)
+            aggregate.sample.resize(max_sample);
+        spdlog::debug("status_service: {}", aggregate);
+        cache_->update(std::move(aggregate));
+    }
+
+    auto status_service::query(upstream_address const &upstream) -> net::awaitable< minecraft::protocol::status_info >
+    {
+        using stream_type = minecraft::protocol::stream< socket_type >;
+
+        auto results = co_await resolver_.async_resolve(upstream.host, upstream.port, net::use_awaitable);
+        auto stream  = std::make_shared< stream_type >(socket_type(get_executor()));
+
+        auto deadline = timer_type(get_executor());
+        deadline.expires_after(query_timeout);
+        deadline.async_wait([weak = std::weak_ptr< stream_type >(stream)](error_code ec) {
+            if (auto s = weak.lock(); s and not ec.failed())
+                s->cancel();
+        });
+
+        auto ep = co_await net::async_connect(stream->next_layer(), results, net::use_awaitable);
+        stream->protocol_version(minecraft::protocol::version_type::v1_15_2);
+        stream->server_address(upstream.host);
+        stream->server_port(ep.port());
+
+        auto response = minecraft::server::status_response();
+        co_await minecraft::protocol::async_client_status(*stream, response, net::use_awaitable);
+        deadline.cancel();
+
+        auto ec   = error_code();
+        auto info = minecraft::protocol::status_info::from_json(response.json, ec);
+        if (ec.failed())
+            throw system_error(ec);
+        co_return info;
+    }
+
+}   // namespace relay
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "config.hpp"
+#include "minecraft/protocol/status_cache.hpp"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace relay
+{
+    struct upstream_address
+    {
+        std::string host;
+        std::string port;
+    };
+
+    /// Periodically queries the status of the upstream servers and publishes the aggregate into a status cache.
+    /// Player counts and samples are summed across upstreams. The version and description are taken from the
+    /// first upstream that replies. If no upstream replies the previous status is retained.
+    struct status_service
+    {
+        using executor_type = net::io_context::executor_type;
+        using protocol_type = net::ip::tcp;
+        using socket_type   = net::basic_stream_socket< protocol_type, executor_type >;
+        using resolver_type = net::ip::basic_resolver< protocol_type, executor_type >;
+        using timer_type    = net::basic_waitable_timer< std::chrono::steady_clock,
+                                                      net::wait_traits< std::chrono::steady_clock >,
+                                                      executor_type >;
+
+        status_service(executor_type                                        exec,
+                       std::vector< upstream_address >                      upstreams,
+                       std::chrono::seconds                                 interval,
+                       std::shared_ptr< minecraft::protocol::status_cache > cache);
+
+        void start();
+
+        void cancel();
+
+        auto get_executor() -> executor_type { return timer_.get_executor(); }
+
+      private:
+        auto run() -> net::awaitable< void >;
+
+        auto refresh() -> net::awaitable< void >;
+
+        auto query(upstream_address const &upstream) -> net::awaitable< minecraft::protocol::status_info >;
+
+        std::vector< upstream_address >                      upstreams_;
+        std::chrono::seconds                                 interval_;
+        std::shared_ptr< minecraft::protocol::status_cache > cache_;
+        resolver_type                                        resolver_;
+        timer_type                                           timer_;
+        bool                                                 canceled_ = false;
+    };
+
+}   // namespace relay
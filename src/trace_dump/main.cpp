@@ -0,0 +1,158 @@
+#include "minecraft/protocol/packet_profile.hpp"
+#include "minecraft/protocol/packet_trace_format.hpp"
+#include "polyfill/explain.hpp"
+
+#include <boost/program_options.hpp>
+#include <cstring>
+#include <ctime>
+#include <fmt/format.h>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace trace_dump
+{
+    namespace format = minecraft::protocol::trace_format;
+    using minecraft::protocol::packet_profile;
+
+    struct options
+    {
+        bool                           json = false;
+        std::optional< std::uint64_t > connection;
+    };
+
+    auto read_trace(std::string const &path) -> std::vector< format::record >
+    {
+        auto in = std::ifstream(path, std::ios::binary);
+        if (not in)
+            throw std::runtime_error(path + ": cannot open");
+
+        auto header = format::file_header();
+        if (not in.read(reinterpret_cast< char * >(&header), sizeof(header)) or
+            std::memcmp(header.magic, format::magic, sizeof(header.magic)) != 0)
+            throw std::runtime_error(path + ": not a packet trace");
+        if (header.version != format::version or header.record_size != sizeof(format::record))
+            throw std::runtime_error(path + ": unsupported trace version " + std::to_string(header.version));
+
+        // the writer sizes the file to the ring, so anything else is a corrupt or partially written header
+        in.seekg(0, std::ios::end);
+        auto size = std::uint64_t(in.tellg());
+        in.seekg(sizeof(header));
+        if (header.capacity == 0 or header.capacity > (size - sizeof(header)) / sizeof(format::record) or
+            sizeof(header) + header.capacity * sizeof(format::record) != size)
+            throw std::runtime_error(path + ": ring capacity " + std::to_string(header.capacity) +
+                                     " does not match the file size " + std::to_string(size));
+
+        auto ring = std::vector< format::record >(header.capacity);
+        in.read(reinterpret_cast< char * >(ring.data()), std::streamsize(ring.size() * sizeof(format::record)));
+        if (not in)
+            throw std::runtime_error(path + ": truncated");
+
+        // oldest first
+        auto result = std::vector< format::record >();
+        auto first  = header.next > header.capacity ? header.next - header.capacity : 0;
+        for (auto n = first; n < header.next; ++n)
+            result.push_back(ring[n % header.capacity]);
+        return result;
+    }
+
+    auto format_time(std::uint64_t ns) -> std::string
+    {
+        auto seconds = std::time_t(ns / 1'000'000'000);
+        auto tm      = std::tm();
+        ::gmtime_r(&seconds, &tm);
+        char buf[32];
+        std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", &tm);
+        return fmt::format("{}.{:09}Z", buf, ns % 1'000'000'000);
+    }
+
+    auto print(std::ostream &os, format::record const &r, options const &opts) -> void
+    {
+        auto dir     = to_string(packet_profile::direction(r.direction));
+        auto st      = to_string(packet_profile::state(r.state));
+        auto payload = std::string();
+        for (std::size_t i = 0; i < r.payload_length and i < format::payload_bytes; ++i)
+        {
+            if (i)
+                payload += ' ';
+            payload += fmt::format("{:02x}", r.payload[i]);
+        }
+
+        if (opts.json)
+            os << fmt::format(R"json({{"time":"{}","connection":{},"direction":"{}","state":"{}","packet_id":{},)json"
+                              R"json("frame_length":{},"wire_length":{},"payload":"{}"}})json",
+                              format_time(r.time_ns),
+                              r.connection,
+                              dir,
+                              st,
+                              r.packet_id,
+                              r.frame_length,
+                              r.wire_length,
+                              payload)
+               << '\n';
+        else
+            os << fmt::format("{} {:>6} {} {:<5} {:<4} {:>7} {:>7}  {}\n",
+                              format_time(r.time_ns),
+                              r.connection,
+                              dir,
+                              st,
+                              r.packet_id < 0 ? std::string("?") : fmt::format("{:#04x}", r.packet_id),
+                              r.frame_length,
+                              r.wire_length,
+                              payload);
+    }
+
+}   // namespace trace_dump
+
+int main(int argc, char **argv)
+{
+    namespace po = boost::program_options;
+
+    try
+    {
+        auto opts       = trace_dump::options();
+        auto files      = std::vector< std::string >();
+        auto connection = std::uint64_t();
+        auto desc       = po::options_description("trace_dump [options] file...\n\nDecode packet trace files written "
+                                                  "by the relay's --trace-file");
+        desc.add_options()("json", po::bool_switch(&opts.json), "write one JSON object per frame")(
+            "connection", po::value(&connection), "only the frames of this connection")(
+            "file", po::value(&files), "trace file")("help,-?", "show this help");
+        auto positional = po::positional_options_description();
+        positional.add("file", -1);
+
+        auto vm = po::variables_map();
+        po::store(po::command_line_parser(argc, argv).options(desc).positional(positional).run(), vm);
+        po::notify(vm);
+        if (vm.count("help") or files.empty())
+        {
+            std::cout << desc << std::endl;
+            return vm.count("help") ? 0 : 1;
+        }
+        if (vm.count("connection"))
+            opts.connection = connection;
+
+        if (not opts.json)
+            std::cout << fmt::format("{:<30} {:>6} {} {:<5} {:<4} {:>7} {:>7}  {}\n",
+                                     "time",
+                                     "conn",
+                                     "dir",
+                                     "state",
+                                     "id",
+                                     "length",
+                                     "wire",
+                                     "payload");
+        for (auto &file : files)
+            for (auto &r : trace_dump::read_trace(file))
+                if (not opts.connection or r.connection == *opts.connection)
+                    trace_dump::print(std::cout, r, opts);
+        return 0;
+    }
+    catch (...)
+    {
+        std::cerr << polyfill::explain() << std::endl;
+        return polyfill::deduce_return_code();
+    }
+}